@@ -69,7 +69,8 @@ int messageHandler (Message * req, Device * dev) {
     uint16_t index = req->startingAddress();
 
     // build response, see page 16 of MODBUS Application Protocol Specification
-    Response rsp (*req); // uses copy constructor to keep transaction id
+    // copies the ADU of the request, keeps transaction id, *req is left empty
+    Response rsp (std::move (*req));
     rsp.setSize (1); // keep until function code
     rsp.setByteCount (N * 2);
     for (uint16_t i = 0; i < N; i++) {
@@ -23,4 +23,10 @@
 #include <modbuspp/router.h>
 #include <modbuspp/request.h>
 #include <modbuspp/response.h>
+#include <modbuspp/recorder.h>
+#include <modbuspp/bitarray.h>
+#include <modbuspp/rtuframer.h>
+#include <modbuspp/capture.h>
+#include <modbuspp/logger.h>
+#include <modbuspp/sharedmap.h>
 /* ========================================================================== */
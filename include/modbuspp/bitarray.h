@@ -0,0 +1,187 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Modbus {
+
+  /**
+   * @brief Packs bits in the Modbus wire format
+   *
+   * Writes the @b n values of @b src (one byte by bit, any non-zero value
+   * being true) in the bytes @b dest from the bit @b offset, the first bit
+   * being the least significant bit of the first byte, as in the PDU of the
+   * functions Read Coils(01), Read Discrete Inputs(02) and Write Multiple
+   * Coils(15). The bits of @b dest outside the range are not modified.
+   *
+   * 16 bits are packed by iteration with SSE2 or NEON when available.
+   */
+  void packBits (uint8_t * dest, std::size_t offset, const uint8_t * src, std::size_t n);
+
+  /**
+   * @overload
+   */
+  void packBits (uint8_t * dest, std::size_t offset, const bool * src, std::size_t n);
+
+  /**
+   * @brief Unpacks bits from the Modbus wire format
+   *
+   * Reads @b n bits of @b src from the bit @b offset and writes them in
+   * @b dest, one byte by bit (0 or 1).
+   *
+   * 16 bits are unpacked by iteration with SSE2 or NEON when available.
+   */
+  void unpackBits (uint8_t * dest, const uint8_t * src, std::size_t offset, std::size_t n);
+
+  /**
+   * @overload
+   */
+  void unpackBits (bool * dest, const uint8_t * src, std::size_t offset, std::size_t n);
+
+  /**
+   * @class BitArray
+   * @brief Packed array of bits
+   *
+   * Stores coils or discrete inputs with one bit by value instead of one
+   * byte, range operations working on whole 64-bit words. The conversions
+   * from and to the Modbus wire format and to arrays of bool use
+   * packBits() and unpackBits().
+   *
+   * @code
+      BitArray inputs (10000);
+      bool values[2000];
+
+      slv.readDiscreteInputs (1, values, 2000);
+      inputs.assign (0, values, 2000);
+      inputs.set (2000, 8000, false);
+   * @endcode
+   *
+   * @author Pascal JEAN, aka epsilonrt
+   * @copyright GNU Lesser General Public License
+   */
+  class BitArray {
+    public:
+      /**
+       * @brief Constructor of an array of @b n bits set to @b value
+       */
+      explicit BitArray (std::size_t n = 0, bool value = false);
+
+      /**
+       * @brief Number of bits
+       */
+      std::size_t size() const {
+        return m_size;
+      }
+
+      /**
+       * @brief Resizes the array, the new bits are set to @b value
+       */
+      void resize (std::size_t n, bool value = false);
+
+      /**
+       * @brief Returns the bit @b i
+       */
+      bool test (std::size_t i) const {
+        return (m_words[i / 64] >> (i % 64)) & 1;
+      }
+
+      /**
+       * @overload
+       */
+      bool operator[] (std::size_t i) const {
+        return test (i);
+      }
+
+      /**
+       * @brief Sets the bit @b i to @b value
+       */
+      void set (std::size_t i, bool value = true) {
+        uint64_t m = uint64_t (1) << (i % 64);
+
+        if (value) {
+          m_words[i / 64] |= m;
+        }
+        else {
+          m_words[i / 64] &= ~m;
+        }
+      }
+
+      /**
+       * @brief Sets the @b n bits from the bit @b pos to @b value
+       */
+      void set (std::size_t pos, std::size_t n, bool value);
+
+      /**
+       * @brief Sets all bits to @b value
+       */
+      void fill (bool value);
+
+      /**
+       * @brief Number of bits set in the range [@b pos, @b pos + @b n[
+       */
+      std::size_t count (std::size_t pos, std::size_t n) const;
+
+      /**
+       * @brief Number of bits set
+       */
+      std::size_t count() const {
+        return count (0, m_size);
+      }
+
+      /**
+       * @brief Copies @b n bits from the bit @b pos to @b dest, one bool by bit
+       */
+      void unpack (bool * dest, std::size_t pos, std::size_t n) const;
+
+      /**
+       * @brief Sets @b n bits from the bit @b pos with the bool of @b src
+       */
+      void assign (std::size_t pos, const bool * src, std::size_t n);
+
+      /**
+       * @brief Copies @b n bits from the bit @b pos in the wire format
+       *
+       * @b dest receives (n + 7) / 8 bytes, the unused bits of the last byte
+       * are cleared.
+       */
+      void toBytes (uint8_t * dest, std::size_t pos, std::size_t n) const;
+
+      /**
+       * @brief Sets @b n bits from the bit @b pos with bytes in the wire format
+       */
+      void fromBytes (std::size_t pos, const uint8_t * src, std::size_t n);
+
+      /**
+       * @brief Packed words, the bit i is the bit i % 64 of the word i / 64
+       */
+      const uint64_t * words() const {
+        return m_words.data();
+      }
+
+    private:
+      uint64_t field (std::size_t pos, std::size_t n) const;
+      void setField (std::size_t pos, std::size_t n, uint64_t v);
+
+      std::vector<uint64_t> m_words;
+      std::size_t m_size;
+  };
+}
+
+/* ========================================================================== */
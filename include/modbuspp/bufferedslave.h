@@ -16,9 +16,13 @@
  */
 #pragma once
 
+#include <memory>
+#include <functional>
 #include <modbuspp/slave.h>
 #include <modbuspp/request.h>
 #include <modbuspp/response.h>
+#include <modbuspp/subscription.h>
+#include <modbuspp/registerview.h>
 
 namespace Modbus {
 
@@ -36,6 +40,29 @@ namespace Modbus {
     public:
 
       friend class Server;
+      friend class Recorder;
+
+      /**
+       * @class Range
+       * @brief Range of data written by the clients, see changes()
+       */
+      struct Range {
+        int address; ///< data address of the first element
+        int size; ///< number of elements
+      };
+
+      /**
+       * @brief Handler of a function code
+       *
+       * Called by the server with the request @b req received and the
+       * response @b rsp to fill. The response is allocated once by the server,
+       * it is a copy of the header and the function code of the request (its
+       * size is 1).
+       *
+       * The handler must return 0 to send @b rsp, 1 to send no response and
+       * -1 if error, the server sending a slave or server failure exception.
+       */
+      typedef std::function<int (const Request & req, Response & rsp) > FunctionHandler;
 
       /**
        * @brief Constructor
@@ -70,12 +97,222 @@ namespace Modbus {
       /**
        * @brief Setting a block of data in the memory map.
        *
-       * A single block of type @b t can be defined for a given slave.
-       * The block has @b nmeb elements and starts at @b startAddr.
+       * This is the main block of type @b t of the slave, it is resized if it
+       * already exists. The block has @b nmeb elements and starts at
+       * @b startAddr. Other blocks can be added with addBlock().
        * @return number of elements actually allocated, -1 if error
        */
       int setBlock (Table t, int nmemb, int startAddr = -1);
 
+      /**
+       * @brief Adds a block of data in the memory map.
+       *
+       * Adds a block of type @b t with @b nmemb elements starting at
+       * @b startAddr, for sparse maps (e.g. registers 0-99, 10000-10099 and
+       * 40000-40199) without allocating the addresses between the blocks.
+       * The block must not overlap another block of the same type.
+       * A request addressing data out of the blocks, or spanning two blocks,
+       * receives an illegal data address exception.
+       * The blocks are located by a paged index, in constant time.
+       * @return number of elements actually allocated, -1 if error (errno
+       * is set to EBUSY if the shared memory or the persistent file is open)
+       */
+      int addBlock (Table t, int nmemb, int startAddr);
+
+      /**
+       * @brief Removes a block added by addBlock()
+       *
+       * The views and subscriptions on this block become invalid.
+       * @return true if the block starting at @b startAddr was found
+       */
+      bool removeBlock (Table t, int startAddr);
+
+      /**
+       * @brief Number of blocks of type @b t, including the block set by setBlock()
+       */
+      int blockCount (Table t) const;
+
+      /**
+       * @brief Adds a file of records
+       *
+       * Adds the file @b file (from 1 to 65535) of @b records records
+       * (16-bit registers, at most 10000), read and written by the clients
+       * with the function codes 0x14 and 0x15 (read and write file record),
+       * and by readFileRecord() and writeFileRecord(). The records are in
+       * memory if @b path is empty, otherwise they are mapped from the file
+       * @b path, created if needed, in the host byte order.
+       * @return number of records, -1 if error (EEXIST if the file was
+       * already added)
+       */
+      int addFile (int file, int records, const std::string & path = std::string());
+
+      /**
+       * @brief Removes a file added by addFile()
+       * @return true if the file @b file was found
+       */
+      bool removeFile (int file);
+
+      /**
+       * @brief Number of records of the file @b file, -1 if it was not added
+       */
+      int fileSize (int file) const;
+
+      /**
+       * @brief Places the blocks of the slave in a shared memory segment
+       *
+       * The blocks set by setBlock() are moved to the named POSIX shared
+       * memory segment @b name (in /dev/shm on Linux), with a header and the
+       * seqlock of the data, the other processes of the host can read and
+       * write them with a SharedMap. The blocks added by addBlock() remain
+       * private.
+       *
+       * If the segment exists with the same blocks, for example created by
+       * a previous instance of the server, it is reused and its values
+       * replace those of the slave; otherwise it is created and the values
+       * of the slave are copied into it. The blocks can no longer be
+       * changed by setBlock() or addBlock() while the segment is attached.
+       *
+       * @return true if successful.
+       * Otherwise it shall return false and set errno.
+       */
+      bool attachSharedMemory (const std::string & name);
+
+      /**
+       * @brief Moves the blocks back from the shared memory segment
+       *
+       * The values are kept, the segment is not removed (see
+       * SharedMap::remove()).
+       */
+      void detachSharedMemory();
+
+      /**
+       * @brief returns true if the blocks are in a shared memory segment
+       */
+      bool isSharedMemoryAttached() const;
+
+      /**
+       * @brief Saves the coils and the holding registers in a file
+       *
+       * The values of all the blocks of coils and holding registers are
+       * saved in the memory-mapped file @b path by a background thread,
+       * every @b flushInterval milliseconds if they have changed and, if
+       * @b flushOnWrite is true, as soon as a client has written them. The
+       * file holds two snapshots written alternately and synced by msync(),
+       * each with a generation and a CRC-32: a snapshot interrupted by a
+       * crash or a power failure is ignored and the previous one is used.
+       *
+       * If the file exists with the same blocks, the values of its last
+       * valid snapshot are restored in the blocks at once, so that a server
+       * restarts with the last values instead of the initial values of its
+       * configuration or the values of the device, which are not written.
+       * Otherwise, the file is created with the current values.
+       *
+       * The blocks must be set before calling this function, they can no
+       * longer be changed by setBlock(), addBlock() or removeBlock() until
+       * closePersistentFile() is called.
+       *
+       * @param path path of the file
+       * @param flushInterval period of the flushes in milliseconds, 0 to
+       * flush only on writes
+       * @param flushOnWrite if true, the writes of the clients are flushed
+       * at once
+       * @return 1 if the values have been restored from the file, 0 if the
+       * file has been created.
+       * Otherwise it shall return -1 and set errno.
+       */
+      int setPersistentFile (const std::string & path, int flushInterval = 1000,
+                             bool flushOnWrite = true);
+
+      /**
+       * @brief Flushes the values and closes the file set by setPersistentFile()
+       */
+      void closePersistentFile();
+
+      /**
+       * @brief returns true if the values are saved in a file
+       */
+      bool isPersistent() const;
+
+      /**
+       * @brief Flushes the values to the file set by setPersistentFile()
+       *
+       * The values written by the application are flushed by the background
+       * thread at the next period, this function flushes them at once.
+       * @return true if successful.
+       * Otherwise it shall return false and set errno.
+       */
+      bool syncPersistentFile();
+
+      /**
+       * @brief Sets the maximum age of the values read from the device
+       *
+       * By default, each read of the application or of a client of the
+       * server is sent to the device (see the constructor). With a maximum
+       * age, the values of a block read from the device less than
+       * @b maxAge milliseconds ago are returned from the memory buffer, a
+       * read of an older or never read block reads the whole block from the
+       * device first (in several transactions if it is larger than a
+       * Modbus read). Several clients polling the same data then generate
+       * a single transaction per block and per period.
+       *
+       * With @b staleWhileRevalidate, a read of a block which has already
+       * been read but is older than @b maxAge returns the old values at
+       * once and the block is read from the device by a background thread.
+       * The transactions of this thread are serialized with the other
+       * transactions of the device, those of the other slaves and of the
+       * application included.
+       *
+       * The writes are always sent to the device.
+       *
+       * @param maxAge maximum age in milliseconds, 0 to disable the cache
+       * @param staleWhileRevalidate if true, returns old values while the
+       * block is read again
+       */
+      void setMaxAge (int maxAge, bool staleWhileRevalidate = false);
+
+      /**
+       * @brief Maximum age of the values read from the device, 0 if disabled
+       */
+      int maxAge() const;
+
+      /**
+       * @brief Marks all the blocks as stale
+       *
+       * The next read of each block reads it from the device.
+       */
+      void invalidate();
+
+      /**
+       * @brief Starts a group of writes
+       *
+       * The data of the slave can be written by the application threads
+       * while the server replies to the clients, without lock: the server
+       * copies the data read by a request and starts again if they were
+       * written during the copy (seqlock), so that a client never receives
+       * a value partially written. The writes between beginUpdate() and
+       * endUpdate() become visible to the clients at once, when endUpdate()
+       * is called. The calls can be nested.
+       *
+       * The writes made through a view (see view()) must be made between
+       * beginUpdate() and endUpdate().
+       *
+       * @code
+          slv.beginUpdate();
+          slv.writeInputRegisters (1, &temperature, 1); // float, 2 registers
+          slv.writeInputRegisters (3, &pressure, 1);
+          slv.endUpdate();
+       * @endcode
+       *
+       * A group of writes prevents the other threads to write the data
+       * and delays the replies of the server, it should be short.
+       */
+      void beginUpdate();
+
+      /**
+       * @brief Ends a group of writes started by beginUpdate()
+       */
+      void endUpdate();
+
       /**
        * @brief Set the before reply callback function @b cb of this slave
        *
@@ -102,6 +339,30 @@ namespace Modbus {
        */
       Message::Callback afterReplyCallback() const;
 
+      /**
+       * @brief Set the handler of the function code @b function of this slave
+       *
+       * The server calls @b handler instead of replying by itself to the
+       * requests to this slave of the code @b function, a standard code
+       * (e.g. to compute the values read) or not (e.g. a vendor specific
+       * code). The handlers are in a table indexed by the function code, the
+       * requests of the codes without handler are replied as usual. An empty
+       * @b handler removes the handler. The handlers must be set before the
+       * server is opened.
+       *
+       * The requests are not forwarded to the device, and on RTU libmodbus
+       * only receives the function codes it knows.
+       *
+       * @throw std::logic_error if the server of the slave is open.
+       */
+      void setFunctionHandler (int function, FunctionHandler handler);
+
+      /**
+       * @brief Return the handler of the function code @b function of this
+       * slave, empty if none
+       */
+      FunctionHandler functionHandler (int function) const;
+
       /**
        * @overload
        */
@@ -148,6 +409,30 @@ namespace Modbus {
       virtual int writeReadRegisters (int write_addr, const uint16_t * src, int write_nb,
                                       int  read_addr, uint16_t * dest, int read_nb);
 
+      /**
+       * @overload
+       *
+       * The register of the map is modified atomically, then the request is
+       * forwarded to the device if it is open.
+       */
+      virtual int maskWriteRegister (int addr, uint16_t andMask, uint16_t orMask);
+
+      /**
+       * @overload
+       *
+       * The records are read from the file added by addFile(), they are read
+       * from the device before if it is open.
+       */
+      virtual int readFileRecord (int file, int record, uint16_t * dest, int nb);
+
+      /**
+       * @overload
+       *
+       * The records are written in the file added by addFile(), then in the
+       * device if it is open.
+       */
+      virtual int writeFileRecord (int file, int record, const uint16_t * src, int nb);
+
       /**
        * @overload
        */
@@ -212,16 +497,43 @@ namespace Modbus {
        * Otherwise it shall return -1.
        */
       template <typename T, Endian e> int writeInputRegisters (int addr, Data<T, e> * src, int nb = 1) {
-        std::vector<uint16_t> buf;
+        std::vector<uint16_t> buf (nb * sizeof (T) / 2);
 
-        for (int i = 0; i < nb; i++) {
+        Data<T, e>::toRegisters (buf.data(), src, nb);
+        return writeInputRegisters (addr, buf.data(), buf.size());
+      }
 
-          src[i].updateRegisters();
-          for (auto & r : src[i].registers()) {
-            buf.push_back (r);
-          }
-        }
-        return writeInputRegisters (addr, buf.data(), buf.size());;
+      /**
+       * @brief Write many input values
+       *
+       * This function shall write the content of the @b nb input values of
+       * type T from the array @b src at address @b addr of the memory map.
+       *
+       * The values are converted to registers according to the bytes and
+       * words order @b e, in one pass.
+       *
+       * @return number of written input Modbus registers (16-bit) if successful.
+       * Otherwise it shall return -1.
+       */
+      template <typename T> int writeInputRegisters (int addr, const T * src, int nb, Endian e) {
+        static_assert ( (sizeof (T) >= 2 && (sizeof (T) % 2) == 0), "Bad typename !");
+        static_assert (std::is_arithmetic<T>::value, "Arithmetic type required !");
+        std::vector<uint16_t> buf (nb * sizeof (T) / 2);
+
+        swapRegisters (buf.data(), src, nb, sizeof (T), e);
+        return writeInputRegisters (addr, buf.data(), buf.size());
+      }
+
+      /**
+       * @brief Write many input data with a compile-time order
+       *
+       * @return number of written input Modbus registers (16-bit) if successful.
+       * Otherwise it shall return -1.
+       */
+      template <typename T, Endian e> int writeInputRegisters (int addr, const StaticData<T, e> * src, int nb = 1) {
+        static_assert (sizeof (StaticData<T, e>) == sizeof (T), "Bad StaticData layout !");
+
+        return writeInputRegisters (addr, reinterpret_cast<const T *> (src), nb, e);
       }
 
       /**
@@ -276,6 +588,139 @@ namespace Modbus {
        */
       bool updateBlockFromSlave ();
 
+      /**
+       * @brief Subscribe to the changes of an array of data
+       *
+       * Registers interest in @b nb values Data<T,e> starting at the data
+       * address @b addr of the table @b t. In a table of bits (coils or
+       * discrete inputs), each bit is a register containing 0 or 1, T is
+       * then usually uint16_t. The callback @b cb is
+       * called with the values whose difference with the last reported value
+       * exceeds the deadband @b db, each time the range is updated from the
+       * real slave (polling with updateBlockFromSlave() or reading when
+       * the device is a Master), written by a client of a Server or
+       * written by the application.
+       *
+       * The callback is called from the thread that changed the values, it
+       * must not subscribe or unsubscribe.
+       *
+       * @return the handle of the subscription, nullptr if error (errno is
+       * set to EINVAL if @b t is not a table or the range is out of
+       * the block).
+       */
+      template <typename T, Endian e = EndianBig>
+      std::shared_ptr<Subscription> subscribe (Table t, int addr, int nb,
+          typename DataSubscription<T, e>::Callback cb,
+          Deadband db = Deadband()) {
+        std::shared_ptr<Subscription> s (new DataSubscription<T, e> (t, addr, nb, cb, db));
+
+        return subscribe (s) ? s : nullptr;
+      }
+
+      /**
+       * @brief Add the subscription @b s
+       *
+       * The reference values of @b s are set from the current content of the
+       * block.
+       * @return true successful.
+       * Otherwise it shall return false and set errno.
+       */
+      bool subscribe (std::shared_ptr<Subscription> s);
+
+      /**
+       * @brief Remove the subscription @b s
+       *
+       * @return true if @b s was found and removed
+       */
+      bool unsubscribe (const std::shared_ptr<Subscription> & s);
+
+      /**
+       * @brief Compares the subscriptions of the table @b t with the block
+       *
+       * Must be called by the application if the block has been modified
+       * without using the functions of this class.
+       *
+       * @return the number of subscriptions whose callback has been called.
+       */
+      int checkSubscriptions (Table t);
+
+      /**
+       * @brief Returns and clears the data written by the clients
+       *
+       * Each write of coils or holding registers by a client (functions 5, 6,
+       * 15, 16, 22 and 23) marks the addresses written, the contiguous
+       * addresses are merged in a single range, by ascending addresses.
+       * The writes of the application are not marked.
+       *
+       * @code
+          while (slv.waitForChanges()) {
+
+            for (const auto & r : slv.changes (HoldingRegister)) {
+              // r.address and r.size setpoints were written
+            }
+          }
+       * @endcode
+       *
+       * @param t Coil or HoldingRegister, the other tables are never written
+       * by the clients
+       */
+      std::vector<Range> changes (Table t);
+
+      /**
+       * @brief returns true if the table @b t has data written by the
+       * clients not yet returned by changes()
+       */
+      bool hasChanges (Table t) const;
+
+      /**
+       * @brief Waits until data are written by the clients
+       *
+       * Returns immediately if changes are pending, the changes are not
+       * cleared, changes() must be called.
+       *
+       * @param timeout in milliseconds, -1 to wait indefinitely
+       * @return true if changes are pending, false on timeout
+       */
+      bool waitForChanges (int timeout = -1);
+
+      /**
+       * @brief Event file descriptor of the changes
+       *
+       * The descriptor is readable while changes are pending, it can be
+       * used with poll() or select() in an event loop; it must not be read
+       * or closed, it is reset by changes() when all the changes are
+       * returned. Linux only.
+       *
+       * @return the descriptor, -1 if error (errno is ENOSYS if not
+       * supported)
+       */
+      int changesDescriptor();
+
+      /**
+       * @brief Typed view of a range of the block @b t
+       *
+       * Returns a view of @b nb values of type T, stored with the order @b e,
+       * from the data address @b addr of the register table @b t. Values are
+       * read and written directly in the memory map, without copy.
+       *
+       * Writing through the view does not update the real slave and does not
+       * call the subscriptions, checkSubscriptions() must be called if needed.
+       * The view is invalidated by setBlock().
+       *
+       * @throw std::out_of_range if @b t is not a register table or the range
+       * is out of the block.
+       */
+      template <typename T, Endian e = EndianBig>
+      RegisterView<T, e> view (Table t, int addr, int nb) {
+        uint16_t * regs = registers (t, addr, nb * RegisterView<T, e>::Width);
+
+        if (!regs) {
+
+          throw std::out_of_range ("BufferedSlave::view range out of the block");
+        }
+        return RegisterView<T, e> (regs, nb, addr);
+      }
+
       using Slave::readInputRegisters;
       using Slave::readInputRegister;
       using Slave::readRegister;
@@ -289,6 +734,10 @@ namespace Modbus {
       BufferedSlave (Private &dd);
       modbus_mapping_t * map();
       const modbus_mapping_t * map() const;
+      modbus_mapping_t * map (const Request & req);
+      int reply (modbus_t * ctx, const Request & req, int len);
+      int reply (const Request & req, Response & rsp);
+      uint16_t * registers (Table t, int addr, int nb);
       int readFromDevice (const Request * req);
       int readFromDevice (const Request & req);
       int writeToDevice (const Request * req);
@@ -0,0 +1,234 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <string>
+#include <modbuspp/global.h>
+#include <modbuspp/pimp.h>
+
+namespace Modbus {
+
+  class Message;
+
+  /**
+   * @class Capture
+   * @brief Capture of the Modbus traffic in a pcap or pcapng file
+   *
+   * The frames are copied with their timestamp in a lock-free ring buffer,
+   * a background thread writes them in the file. Recording a frame does not
+   * block and does not make any system call, if the ring buffer is full the
+   * frame is dropped and counted (see dropped()).
+   *
+   * The file can be opened in Wireshark:
+   * - The TCP frames are written as raw IPv4 packets (LINKTYPE_RAW) with a
+   * synthetic IP/TCP header, the server being 10.0.0.1:502 and the client
+   * 10.0.0.2:49152, the Modbus/TCP dissector is used without configuration.
+   * - The RTU frames are written with the user link type DLT_USER0 (147),
+   * Wireshark must be configured to use the mbrtu protocol for this link
+   * type (Preferences > Protocols > DLT_USER, header and trailer size 0).
+   * .
+   * In the pcapng format, the direction of each frame (inbound or outbound)
+   * is stored in the packet flags.
+   *
+   * A capture is attached to a device with Device::setCapture(), the frames
+   * handled by the library are then recorded: received by a Server, sent or
+   * received by Master::sendRawRequest(), Master::receiveResponse() and
+   * Device::sendRawMessage(). The frames sent and received inside libmodbus
+   * (e.g. by Slave::readRegisters() or the replies built by libmodbus in a
+   * Server) are not seen by the library and are not captured.
+   *
+   * @code
+      Capture cap ("/tmp/modbus.pcapng", Tcp, Capture::PcapNg);
+      cap.setSlaveFilter (33);
+      srv.setCapture (&cap);
+   * @endcode
+   *
+   * @author Pascal JEAN, aka epsilonrt
+   * @copyright GNU Lesser General Public License
+   */
+  class Capture {
+
+    public:
+      /**
+       * @enum Format
+       * @brief File format
+       */
+      enum Format {
+        Pcap,   ///< pcap with nanosecond timestamps
+        PcapNg  ///< pcapng
+      };
+
+      /**
+       * @enum Direction
+       * @brief Direction of a frame, seen from the application
+       */
+      enum Direction {
+        Received, ///< inbound
+        Sent      ///< outbound
+      };
+
+      /**
+       * @brief Constructor
+       *
+       * Opens the file @b path, throws std::runtime_error on failure.
+       * @sa open()
+       */
+      Capture (const std::string & path, Net net, Format format = Pcap);
+
+      /**
+       * @brief Default constructor
+       *
+       * object cannot be used without calling open()
+       */
+      Capture();
+
+      /**
+       * @brief Destructor
+       *
+       * Writes the pending frames and closes the file.
+       */
+      virtual ~Capture();
+
+      /**
+       * @brief Opens a capture file
+       *
+       * The file is created (or truncated) and the writer thread is started.
+       *
+       * @param path path of the file
+       * @param net network of the frames, Tcp or Rtu
+       * @param format file format
+       * @param capacity number of frames of the ring buffer
+       * @return true if successful.
+       * Otherwise it shall return false and set errno.
+       */
+      bool open (const std::string & path, Net net, Format format = Pcap,
+                 size_t capacity = 1024);
+
+      /**
+       * @brief Writes the pending frames, stops the writer thread and closes
+       * the file
+       */
+      void close();
+
+      /**
+       * @brief returns true if the file is open
+       */
+      bool isOpen() const;
+
+      /**
+       * @brief Path of the file
+       */
+      const std::string & path() const;
+
+      /**
+       * @brief Network of the frames
+       */
+      Net net() const;
+
+      /**
+       * @brief Records a frame
+       *
+       * @param adu complete ADU, with the MBAP header (TCP) or the CRC (RTU)
+       * @param len length of @b adu in bytes
+       * @param dir direction of the frame
+       * @param response true for a response, false for a request
+       * @param timestamp time of the frame in nanoseconds since the Epoch,
+       * 0 for the current time
+       * @return true if the frame is recorded, false if it is filtered out,
+       * not sampled or dropped.
+       */
+      bool record (const uint8_t * adu, size_t len, Direction dir, bool response,
+                   uint64_t timestamp = 0);
+
+      /**
+       * @overload
+       *
+       * The ADU of the message must be complete (see NetLayer::prepareToSend()).
+       */
+      bool record (const Message & msg, Direction dir);
+
+      /**
+       * @brief Records a frame given without its header and its CRC
+       *
+       * @b data starts with the slave address followed by the PDU, as passed
+       * to Master::sendRawRequest(). The MBAP header (TCP) or the CRC (RTU)
+       * are added by the writer thread, the transaction identifier being 0.
+       */
+      bool recordPdu (const uint8_t * data, size_t len, Direction dir,
+                      bool response, uint64_t timestamp = 0);
+
+      /**
+       * @brief Records only one frame out of @b n
+       *
+       * 1 by default, all frames are recorded.
+       */
+      void setSampling (unsigned int n);
+
+      /**
+       * @brief Sampling period
+       */
+      unsigned int sampling() const;
+
+      /**
+       * @brief Records only the frames of the slave @b slave, -1 for all
+       */
+      void setSlaveFilter (int slave);
+
+      /**
+       * @brief Slave recorded, -1 for all
+       */
+      int slaveFilter() const;
+
+      /**
+       * @brief Enables or disables the recording of a function
+       *
+       * All functions are recorded by default. The exceptions are recorded
+       * with their function.
+       */
+      void setFunctionFilter (Function func, bool enable);
+
+      /**
+       * @brief Enables or disables the recording of all functions
+       */
+      void setFunctionFilter (bool enable);
+
+      /**
+       * @brief Number of frames recorded
+       */
+      unsigned long captured() const;
+
+      /**
+       * @brief Number of frames dropped because the ring buffer was full
+       */
+      unsigned long dropped() const;
+
+      /**
+       * @brief Current time in nanoseconds since the Epoch
+       */
+      static uint64_t now();
+
+    protected:
+      class Private;
+      Capture (Private &dd);
+      std::unique_ptr<Private> d_ptr;
+
+    private:
+      PIMP_DECLARE_PRIVATE (Capture)
+  };
+}
+
+/* ========================================================================== */
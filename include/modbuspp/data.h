@@ -34,6 +34,7 @@ namespace Modbus {
   class Message;
   class Request;
   class Response;
+  template <typename T, Endian e> class DataSubscription;
 
   /**
    * @class Data
@@ -225,6 +226,7 @@ namespace Modbus {
       friend class Message;
       friend class Request;
       friend class Response;
+      template <typename, Endian> friend class DataSubscription;
 
     protected:
 
@@ -254,6 +256,71 @@ namespace Modbus {
         swap (v);
         m_value = ntoh (v);
       }
+
+      // update the values of the nb data of the array dest from the
+      // registers regs, regs is converted in place.
+      static void fromRegisters (Data * dest, uint16_t * regs, int nb) {
+        const std::size_t w = sizeof (T) / 2;
+
+        for (int i = 0; i < nb; i++) {
+
+          std::memcpy (dest[i].m_registers.data(), &regs[i * w], sizeof (T));
+        }
+        if (sameEndianness (dest, nb)) {
+
+          swapRegisters (regs, nb, sizeof (T), dest[0].m_endian);
+          for (int i = 0; i < nb; i++) {
+
+            std::memcpy (&dest[i].m_value, &regs[i * w], sizeof (T));
+          }
+        }
+        else {
+
+          for (int i = 0; i < nb; i++) {
+
+            dest[i].updateValue();
+          }
+        }
+      }
+
+      // update the registers of the nb data of the array src and copy them
+      // to regs
+      static void toRegisters (uint16_t * regs, Data * src, int nb) {
+        const std::size_t w = sizeof (T) / 2;
+
+        if (sameEndianness (src, nb)) {
+
+          for (int i = 0; i < nb; i++) {
+
+            std::memcpy (&regs[i * w], &src[i].m_value, sizeof (T));
+          }
+          swapRegisters (regs, nb, sizeof (T), src[0].m_endian);
+          for (int i = 0; i < nb; i++) {
+
+            std::memcpy (src[i].m_registers.data(), &regs[i * w], sizeof (T));
+          }
+        }
+        else {
+
+          for (int i = 0; i < nb; i++) {
+
+            src[i].updateRegisters();
+            std::memcpy (&regs[i * w], src[i].m_registers.data(), sizeof (T));
+          }
+        }
+      }
+
+      static bool sameEndianness (const Data * d, int nb) {
+
+        for (int i = 1; i < nb; i++) {
+
+          if (d[i].m_endian != d[0].m_endian) {
+
+            return false;
+          }
+        }
+        return nb > 0;
+      }
 #endif /* __DOXYGEN__ not defined */
 
     private:
@@ -262,6 +329,208 @@ namespace Modbus {
       std::array < uint16_t, sizeof (T) / 2 > m_registers;
   };
 
+  /**
+   * @class StaticData
+   * @brief Arithmetic data in multiple 16-bit Modbus registers with a
+   * compile-time order
+   *
+   * StaticData is the compile-time variant of Data: the order of bytes and
+   * words is fixed by the template parameter @b e, the conversion from and to
+   * registers compiles to a few bswap or rotate instructions without any
+   * switch, and the object contains only the T value (an array of
+   * StaticData has the layout of an array of T, so that it can be read
+   * directly from the registers).
+   *
+   * Data remains the class to use when the order is known only at runtime,
+   * e.g. for maps configured from JSON.
+   *
+   * @param T is a type of arithmetic data (int, float ...) of a size greater
+   * than or equal to 2.
+   * @param e is the order of bytes and words in the data model used by the
+   * user's Modbus network.
+   *
+   * @author Pascal JEAN, aka epsilonrt
+   * @copyright GNU Lesser General Public License
+   */
+  template <typename T, Endian e = EndianBig>
+  class StaticData {
+    public:
+      static_assert ( (sizeof (T) >= 2 && (sizeof (T) % 2) == 0), "Bad Data typename !");
+      static_assert (std::is_arithmetic<T>::value, "Arithmetic type required !");
+
+      /**
+       * @brief Default constructor
+       *
+       * The default value of T is 0.
+       */
+      StaticData() : m_value (0) {}
+
+      /**
+       * @brief Constructor from a value of T
+       */
+      StaticData (const T& t) :  m_value (t) {}
+
+      /**
+       * @brief  Overload of the reference operator on the T value
+       */
+      operator T&() {
+        return m_value;
+      }
+
+      /**
+       * @overload
+       */
+      operator const T&() const {
+        return m_value;
+      }
+
+      /**
+       * @brief Access to the T value
+       */
+      T& value() {
+        return m_value;
+      }
+
+      /**
+       * @overload
+       */
+      const T& value() const {
+        return m_value;
+      }
+
+      /**
+       * @brief Overload of the assignment operator from a T value
+       */
+      T& operator= (const T& t) {
+        m_value = t;
+        return m_value;
+      }
+
+      /**
+       * @brief Return the bytes and words endianness
+       */
+      static constexpr Endian endianness() {
+        return e;
+      }
+
+      /**
+       * @brief Number of bytes of type T
+       */
+      static constexpr std::size_t size() {
+        return sizeof (T);
+      }
+
+      /**
+       * @brief Array of Modbus registers corresponding to the T value
+       */
+      std::array < uint16_t, sizeof (T) / 2 > registers() const {
+        std::array < uint16_t, sizeof (T) / 2 > regs;
+
+        toRegisters (regs.data(), m_value);
+        return regs;
+      }
+
+      /**
+       * @brief Set the T value from Modbus registers
+       *
+       * @b regs must contain size() / 2 registers.
+       */
+      void setRegisters (const uint16_t * regs) {
+        m_value = fromRegisters (regs);
+      }
+
+      /**
+       * @brief Converts Modbus registers to a T value
+       */
+      static T fromRegisters (const uint16_t * regs) {
+        Bits u;
+        T v;
+
+        std::memcpy (&u, regs, sizeof (T));
+        u = convert (u);
+        std::memcpy (&v, &u, sizeof (T));
+        return v;
+      }
+
+      /**
+       * @brief Converts a T value to Modbus registers
+       */
+      static void toRegisters (uint16_t * regs, const T & v) {
+        Bits u;
+
+        std::memcpy (&u, &v, sizeof (T));
+        u = convert (u);
+        std::memcpy (regs, &u, sizeof (T));
+      }
+
+    protected:
+#ifndef __DOXYGEN__
+      // unsigned integer of the size of T, an array for larger types
+      struct Wide {
+        uint16_t w[sizeof (T) / 2];
+      };
+      typedef typename std::conditional < sizeof (T) == 2, uint16_t,
+              typename std::conditional < sizeof (T) == 4, uint32_t,
+              typename std::conditional < sizeof (T) == 8, uint64_t,
+              Wide >::type >::type >::type Bits;
+
+      // operations needed by e, see swapRegisters()
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+      static constexpr bool SwapBytes = (e == EndianLittleBig || e == EndianLittleLittle);
+      static constexpr bool SwapWords = (e == EndianBigBig || e == EndianLittleBig);
+#else
+      static constexpr bool SwapBytes = (e == EndianLittleBig || e == EndianLittleLittle);
+      static constexpr bool SwapWords = (e == EndianBigLittle || e == EndianLittleLittle);
+#endif
+
+      static uint16_t swapBytes (uint16_t u) {
+        return static_cast<uint16_t> ( (u << 8) | (u >> 8));
+      }
+      static uint32_t swapBytes (uint32_t u) {
+        return ( (u & 0x00FF00FFUL) << 8) | ( (u >> 8) & 0x00FF00FFUL);
+      }
+      static uint64_t swapBytes (uint64_t u) {
+        return ( (u & 0x00FF00FF00FF00FFULL) << 8) | ( (u >> 8) & 0x00FF00FF00FF00FFULL);
+      }
+      static Wide swapBytes (Wide u) {
+        for (auto & w : u.w) {
+          w = swapBytes (w);
+        }
+        return u;
+      }
+
+      static uint16_t swapWords (uint16_t u) {
+        return u;
+      }
+      static uint32_t swapWords (uint32_t u) {
+        return (u << 16) | (u >> 16);
+      }
+      static uint64_t swapWords (uint64_t u) {
+        u = (u << 32) | (u >> 32);
+        return ( (u & 0x0000FFFF0000FFFFULL) << 16) | ( (u >> 16) & 0x0000FFFF0000FFFFULL);
+      }
+      static Wide swapWords (Wide u) {
+        for (std::size_t i = 0; i < sizeof (T) / 4; ++i) {
+          std::swap (u.w[i], u.w[ (sizeof (T) / 2) - 1 - i ]);
+        }
+        return u;
+      }
+
+      static Bits convert (Bits u) {
+        if (SwapBytes) {
+          u = swapBytes (u);
+        }
+        if (SwapWords) {
+          u = swapWords (u);
+        }
+        return u;
+      }
+#endif /* __DOXYGEN__ not defined */
+
+    private:
+      T m_value;
+  };
+
   /**
    * @class DataType
    * @author epsilonrt
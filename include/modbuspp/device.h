@@ -26,6 +26,8 @@ namespace Modbus {
   class RtuLayer;
   class TcpLayer;
   class Message;
+  class Capture;
+  class Logger;
 
   /**
    * @class Device
@@ -39,6 +41,8 @@ namespace Modbus {
    */
   class Device  {
     public:
+
+      friend class Slave;
       /**
        * @brief Constructor
        *
@@ -517,6 +521,9 @@ namespace Modbus {
        * @b flag. By default, the boolean flag is set to false.
        * When the @b flag value is set to true, many verbose messages are
        * displayed on stdout and stderr.
+       * The messages of the library are written by the logger of the device
+       * (see setLogger()), in a background thread, those of libmodbus are
+       * written directly on stdout and stderr.
        * For example, this flag is useful to display the bytes of the
        * Modbus messages :
        * @code
@@ -535,6 +542,39 @@ namespace Modbus {
        */
       bool debug () const;
 
+      /**
+       * @brief Set the capture of the traffic
+       *
+       * The frames sent and received by the library through this device
+       * are recorded in @b capture, nullptr to stop the capture. The capture
+       * is not owned by the device and must remain valid until it is
+       * detached. Unlike setDebug(), the frames are only copied on the
+       * communication path, the writing being done by a background thread.
+       *
+       * @sa Capture
+       */
+      void setCapture (Capture * capture);
+
+      /**
+       * @brief Return the capture of the traffic, nullptr if none
+       */
+      Capture * capture() const;
+
+      /**
+       * @brief Set the logger of the device
+       *
+       * The debug messages (see setDebug()) and the errors of the device are
+       * written in @b logger, nullptr for the global logger
+       * (Logger::global()). The logger is not owned by the device and must
+       * remain valid until it is detached.
+       */
+      void setLogger (Logger * logger);
+
+      /**
+       * @brief Return the logger of the device
+       */
+      Logger & logger() const;
+
       /**
        * @brief last error message
        *
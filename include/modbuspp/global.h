@@ -32,6 +32,7 @@ namespace Modbus {
   const int TcpSlave = MODBUS_TCP_SLAVE; ///< Can be used in TCP mode to restore the default value
   const int Unknown = -1; ///< Value corresponding to an unknown parameter
   const uint16_t MaxPduLength = MODBUS_MAX_PDU_LENGTH; ///< maximum size of a PDU
+  const uint16_t MaxAduLength = MODBUS_MAX_ADU_LENGTH; ///< maximum size of an ADU
   const uint8_t ExceptionFlag = 0x80;
 
   /**
@@ -153,8 +154,8 @@ namespace Modbus {
     WriteMultipleCoils = MODBUS_FC_WRITE_MULTIPLE_COILS,
     WriteMultipleRegisters = MODBUS_FC_WRITE_MULTIPLE_REGISTERS,
     ReportServerId = MODBUS_FC_REPORT_SLAVE_ID,
-    // ReadFileRecord = 20, // Not implemented
-    // WriteFileRecord = 21, // Not implemented
+    ReadFileRecord = 20, // not handled by libmodbus
+    WriteFileRecord = 21, // not handled by libmodbus
     MaskWriteRegister = MODBUS_FC_MASK_WRITE_REGISTER,
     ReadWriteMultipleRegisters = MODBUS_FC_WRITE_AND_READ_REGISTERS,
     // ReadFifoQueue = 24, // Not implemented
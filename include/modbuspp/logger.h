@@ -0,0 +1,270 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <string>
+#include <iostream>
+#include <functional>
+#include <memory>
+#include <modbuspp/global.h>
+#include <modbuspp/pimp.h>
+
+namespace Modbus {
+
+  class Message;
+
+  /**
+   * @brief Fast hexadecimal encoding of bytes
+   *
+   * Writes each byte of @b src as 2 uppercase hexadecimal digits in @b dest,
+   * preceded by @b prefix and followed by @b suffix if they are not null.
+   * @b dest must be large enough: 4 * @b n characters with prefix and suffix,
+   * 2 * @b n without. No terminating null character is written.
+   *
+   * @return the number of characters written
+   */
+  size_t hexEncode (char * dest, const uint8_t * src, size_t n,
+                    char prefix = 0, char suffix = 0);
+
+  /**
+   * @overload
+   */
+  std::string hexEncode (const uint8_t * src, size_t n,
+                         char prefix = 0, char suffix = 0);
+
+  /**
+   * @class Logger
+   * @brief Asynchronous logger
+   *
+   * Logging a message only copies it in a lock-free ring buffer with its
+   * level and timestamp, the formatting and the writing to the sink are
+   * done by a background thread. The bytes of a frame are copied as is,
+   * they are converted to hexadecimal by the background thread, and a
+   * message can be given as a function called by the background thread,
+   * so that the cost of the formatting is not paid by the caller.
+   * If the ring buffer is full, the message is dropped and counted.
+   *
+   * The devices log their debug messages (see Device::setDebug()) and their
+   * errors in the global logger (Logger::global()) or in the logger set by
+   * Device::setLogger().
+   *
+   * @code
+      Logger log (Logger::Debug);
+      log.setSink (std::make_shared<Logger::StreamSink> (std::clog, std::clog, true));
+
+      log.log (Logger::Info, "server started");
+      log.log (Logger::Debug, msg); // hexadecimal dump
+      log.log (Logger::Debug, [config] { return config.dump (2); });
+   * @endcode
+   *
+   * @author Pascal JEAN, aka epsilonrt
+   * @copyright GNU Lesser General Public License
+   */
+  class Logger {
+
+    public:
+      /**
+       * @enum Level
+       * @brief Severity levels, in ascending order
+       */
+      enum Level {
+        Trace,
+        Debug,
+        Info,
+        Warning,
+        Error,
+        Off ///< for setLevel() only, disables the logger
+      };
+
+      /**
+       * @class Record
+       * @brief Formatted message passed to a sink
+       */
+      struct Record {
+        Level level;
+        uint64_t timestamp; ///< microseconds since the Epoch
+        std::string text;
+      };
+
+      /**
+       * @class Sink
+       * @brief Destination of the messages
+       *
+       * The functions of a sink are called by the background thread of the
+       * logger only.
+       */
+      class Sink {
+        public:
+          virtual ~Sink() {}
+          /**
+           * @brief Writes a message
+           */
+          virtual void write (const Record & r) = 0;
+          /**
+           * @brief Called when the queue of the logger is empty
+           */
+          virtual void flush() {}
+      };
+
+      /**
+       * @class StreamSink
+       * @brief Sink writing in standard streams
+       *
+       * The messages of level Warning and above are written in @b err
+       * preceded by the level name, the others in @b out. If @b timestamps
+       * is true, each line starts with the date and time of the message.
+       */
+      class StreamSink : public Sink {
+        public:
+          explicit StreamSink (std::ostream & out = std::cout,
+                               std::ostream & err = std::cerr,
+                               bool timestamps = false);
+          virtual void write (const Record & r);
+          virtual void flush();
+
+        private:
+          std::ostream & m_out;
+          std::ostream & m_err;
+          bool m_timestamps;
+      };
+
+      /**
+       * @brief Message formatted by the background thread
+       */
+      typedef std::function<std::string() > Formatter;
+
+      /**
+       * @brief Constructor
+       *
+       * Starts the background thread, the sink is a StreamSink on
+       * std::cout and std::cerr.
+       *
+       * @param level minimum level of the messages logged
+       * @param capacity number of messages of the ring buffer
+       */
+      explicit Logger (Level level = Info, size_t capacity = 1024);
+
+      /**
+       * @brief Destructor
+       *
+       * Writes the pending messages and stops the background thread.
+       */
+      virtual ~Logger();
+
+      /**
+       * @brief Minimum level of the messages logged
+       */
+      Level level() const;
+
+      /**
+       * @brief Set the minimum level of the messages logged
+       */
+      void setLevel (Level level);
+
+      /**
+       * @brief returns true if the messages of level @b level are logged
+       */
+      bool isEnabled (Level level) const;
+
+      /**
+       * @brief Set the sink
+       *
+       * The pending messages are written in the new sink.
+       */
+      void setSink (std::shared_ptr<Sink> sink);
+
+      /**
+       * @brief Current sink
+       */
+      std::shared_ptr<Sink> sink() const;
+
+      /**
+       * @brief Logs a text message
+       *
+       * @return true if the message is queued, false if its level is not
+       * enabled or if the ring buffer is full.
+       */
+      bool log (Level level, const char * text);
+
+      /**
+       * @overload
+       */
+      bool log (Level level, const std::string & text);
+
+      /**
+       * @brief Logs a message formatted by the background thread
+       *
+       * @b f is called only if @b level is enabled, the variables it captures
+       * must remain valid until it is called (capture them by value).
+       */
+      bool log (Level level, Formatter f);
+
+      /**
+       * @brief Logs the bytes of a message in hexadecimal
+       *
+       * As Message::print(), requests between '<' and '>', responses between
+       * '[' and ']'.
+       */
+      bool log (Level level, const Message & msg);
+
+      /**
+       * @brief Logs bytes in hexadecimal
+       *
+       * The bytes are copied and encoded by the background thread,
+       * @b len must be less than or equal to MaxAduLength.
+       */
+      bool hex (Level level, const uint8_t * data, size_t len,
+                char prefix = '[', char suffix = ']');
+
+      /**
+       * @brief Waits until all the pending messages are written
+       */
+      void flush();
+
+      /**
+       * @brief Number of messages dropped because the ring buffer was full
+       */
+      unsigned long dropped() const;
+
+      /**
+       * @brief Name of a level, in uppercase
+       */
+      static const char * levelName (Level level);
+
+      /**
+       * @brief Current time in microseconds since the Epoch
+       */
+      static uint64_t now();
+
+      /**
+       * @brief Global logger
+       *
+       * Used by the devices without logger, its level is Debug.
+       */
+      static Logger & global();
+
+    protected:
+      class Private;
+      Logger (Private &dd);
+      std::unique_ptr<Private> d_ptr;
+
+    private:
+      PIMP_DECLARE_PRIVATE (Logger)
+  };
+}
+
+/* ========================================================================== */
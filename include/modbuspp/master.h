@@ -257,6 +257,21 @@ namespace Modbus {
        */
       int receiveResponse (Message & rsp);
 
+      /**
+       * @brief Write and read many registers of a slave in a single transaction
+       *
+       * This function shall write the @b write_nb holding registers of
+       * @b src at address @b write_addr of the slave @b slaveAddr, then shall
+       * read the @b read_nb holding registers at address @b read_addr in
+       * @b dest, with a single request and response (Modbus function code
+       * 0x17), instead of a write and a read transaction.
+       *
+       * @return the number of read registers if successful. Otherwise it
+       * shall return -1 and set errno, EINVAL if the slave was not added.
+       */
+      int writeReadRegisters (int slaveAddr, int write_addr, const uint16_t * src,
+                              int write_nb, int read_addr, uint16_t * dest, int read_nb);
+
     protected:
       class Private;
       Master (Private &dd);
@@ -20,8 +20,10 @@
 #include <stdexcept>
 #include <vector>
 #include <iostream>
+#include <algorithm>
 #include <modbuspp/global.h>
 #include <modbuspp/data.h>
+#include <modbuspp/swap.h>
 
 namespace Modbus {
   class Device;
@@ -71,8 +73,9 @@ namespace Modbus {
       
       /**
        * @brief Move Constructor
-       * The object acquires the content managed by @b other. 
-       * @b other becomes an empty object (as if default-constructed).
+       * The object acquires the content managed by @b other, without copy
+       * nor allocation. @b other becomes an empty object, isValid() returns
+       * false, it can only be destroyed or assigned.
        */
       Message (Message && other);
 
@@ -83,9 +86,17 @@ namespace Modbus {
       
       /**
        * @brief Move assignment
+       *
+       * @b other becomes an empty object, as for the move constructor.
        */
       Message& operator= (Message && other);
 
+      /**
+       * @brief returns false if the content of the message has been moved
+       * to another message
+       */
+      bool isValid() const;
+
       /**
        * @brief Swaps Message @b other with this Message. This operation is
        * very fast and never fails.
@@ -404,6 +415,61 @@ namespace Modbus {
       Message (Private &dd);
       std::unique_ptr<Private> d_ptr;
 
+#ifndef __DOXYGEN__
+      // bulk transfers of registers between the PDU, from pduOffset, and
+      // arrays of values, in a single conversion pass
+      void checkRange (int pduOffset, std::size_t len) const {
+
+        if (pduOffset < 0 || (pduOffset + len) > MaxPduLength) {
+
+          throw std::out_of_range ("Registers out of the PDU !");
+        }
+      }
+
+      // number of the nb registers from pduOffset which are in the PDU
+      static std::size_t fitting (int pduOffset, std::size_t nb) {
+
+        if (pduOffset < 0 || pduOffset >= MaxPduLength) {
+
+          return 0;
+        }
+        return std::min (nb, (MaxPduLength - pduOffset) / sizeof (uint16_t));
+      }
+
+      template <typename T>
+      void getValues (int pduOffset, T * dest, std::size_t nb, Endian e) const {
+
+        checkRange (pduOffset, nb * sizeof (T));
+        swapNetworkRegisters (dest, pdu() + pduOffset, nb, sizeof (T), e);
+      }
+
+      template <typename T>
+      void setValues (int pduOffset, const T * src, std::size_t nb, Endian e) {
+        std::size_t len = pduOffset + nb * sizeof (T);
+
+        checkRange (pduOffset, nb * sizeof (T));
+        swapNetworkRegisters (pdu() + pduOffset, src, nb, sizeof (T), e);
+        setSize (std::max (size(), len));
+      }
+
+      template <typename T, Endian e>
+      void getData (int pduOffset, Data<T, e> * dest, std::size_t nb) const {
+        uint16_t regs[MaxPduLength / 2];
+
+        getValues (pduOffset, regs, nb * sizeof (T) / 2, EndianBig);
+        Data<T, e>::fromRegisters (dest, regs, nb);
+      }
+
+      template <typename T, Endian e>
+      void setData (int pduOffset, Data<T, e> * src, std::size_t nb) {
+        uint16_t regs[MaxPduLength / 2];
+
+        checkRange (pduOffset, nb * sizeof (T));
+        Data<T, e>::toRegisters (regs, src, nb);
+        setValues (pduOffset, regs, nb * sizeof (T) / 2, EndianBig);
+      }
+#endif /* __DOXYGEN__ not defined */
+
     private:
       PIMP_DECLARE_PRIVATE (Message)
   };
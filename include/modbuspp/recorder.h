@@ -0,0 +1,289 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <modbuspp/global.h>
+#include <modbuspp/pimp.h>
+
+namespace Modbus {
+
+  class BufferedSlave;
+
+  /**
+   * @class Recorder
+   * @brief Time-series recorder of registers in a memory-mapped ring file
+   *
+   * The recorder appends timestamped samples of register ranges, called
+   * channels, in a file of fixed size mapped in memory. When the file is
+   * full, the oldest records are overwritten.
+   *
+   * Each channel is described by a slave identifier, a table, a starting
+   * address and a number of registers. A sample is written either as a
+   * keyframe (timestamp and all the registers) or as a delta (time elapsed
+   * since the previous sample of the channel and runs of modified registers),
+   * a keyframe being written each keyframeInterval() samples of the channel.
+   * An index of the keyframes allows reading a time range without scanning
+   * the whole file.
+   *
+   * @code
+      Recorder rec ("/var/lib/edge/history.mbr", 16 * 1024 * 1024);
+      // in the polling loop
+      slave.updateBlockFromSlave (InputRegister);
+      rec.record (slave, InputRegister);
+   * @endcode
+   *
+   * Timestamps are expressed in microseconds since the Epoch.
+   *
+   * @author Pascal JEAN, aka epsilonrt
+   * @copyright GNU Lesser General Public License
+   */
+  class Recorder {
+
+    public:
+      /**
+       * @class Channel
+       * @brief Description of a recorded register range
+       */
+      struct Channel {
+        int slave;
+        Table table;
+        int address; ///< PDU address of the first register
+        int size;    ///< number of registers
+      };
+
+      /**
+       * @class Sample
+       * @brief Registers of a channel at a given time
+       */
+      struct Sample {
+        int channel;
+        uint64_t timestamp;
+        std::vector<uint16_t> registers;
+      };
+
+      /**
+       * @brief Constructor
+       *
+       * Opens the ring file @b path with a data area of @b size bytes.
+       * @sa open()
+       */
+      Recorder (const std::string & path, size_t size);
+
+      /**
+       * @brief Default constructor
+       *
+       * object cannot be used without calling open()
+       */
+      Recorder ();
+
+      /**
+       * @brief Destructor
+       *
+       * Flushes and closes the file.
+       */
+      virtual ~Recorder();
+
+      /**
+       * @brief Opens the ring file
+       *
+       * If the file @b path exists and was created by a recorder with the
+       * same @b size, the recording continues after the last record, otherwise
+       * the file is created (or truncated).
+       *
+       * @param path path of the file
+       * @param size size in bytes of the data area
+       * @param indexSize number of entries of the keyframe index
+       * @return true if successful.
+       * Otherwise it shall return false and set errno.
+       */
+      bool open (const std::string & path, size_t size, int indexSize = 4096);
+
+      /**
+       * @brief Flushes and closes the file
+       */
+      void close();
+
+      /**
+       * @brief returns true if the file is open
+       */
+      bool isOpen() const;
+
+      /**
+       * @brief Path of the file
+       */
+      const std::string & path() const;
+
+      /**
+       * @brief Number of samples of a channel between two keyframes
+       */
+      int keyframeInterval() const;
+
+      /**
+       * @brief Set the number of samples of a channel between two keyframes
+       */
+      void setKeyframeInterval (int n);
+
+      /**
+       * @brief Record a sample of a register range
+       *
+       * The channel is created at the first call for a given @b slave, @b t,
+       * @b addr and @b nb.
+       *
+       * @param slave slave identifier
+       * @param t table, only input and holding registers are allowed
+       * @param addr PDU address of the first register
+       * @param src registers
+       * @param nb number of registers
+       * @param timestamp time of the sample, 0 for the current time
+       * @return the number of bytes written in the file if successful.
+       * Otherwise it shall return -1 and set errno.
+       */
+      int record (int slave, Table t, int addr, const uint16_t * src, int nb,
+                  uint64_t timestamp = 0);
+
+      /**
+       * @brief Record the blocks @b t of a buffered slave
+       *
+       * Each block, set by setBlock() or added by addBlock(), is recorded
+       * in its own channel, with the same timestamp.
+       *
+       * @return the number of bytes written in the file if successful.
+       * Otherwise it shall return -1 and set errno.
+       */
+      int record (BufferedSlave & slave, Table t, uint64_t timestamp = 0);
+
+      /**
+       * @brief Writes the modified pages of the file to the storage
+       *
+       * @param async if true, the writing is scheduled but not waited
+       * @return true if successful.
+       * Otherwise it shall return false and set errno.
+       */
+      bool flush (bool async = false);
+
+      /**
+       * @brief Current time in microseconds since the Epoch
+       */
+      static uint64_t now();
+
+    protected:
+      class Private;
+      Recorder (Private &dd);
+      std::unique_ptr<Private> d_ptr;
+
+    private:
+      PIMP_DECLARE_PRIVATE (Recorder)
+  };
+
+  /**
+   * @class RecorderReader
+   * @brief Reader of a file written by a Recorder
+   *
+   * The reader maps the file in read-only mode, it can be used while the
+   * recorder writes the file in another process, the records are read
+   * within the limits valid at the time of the call.
+   *
+   * @author Pascal JEAN, aka epsilonrt
+   * @copyright GNU Lesser General Public License
+   */
+  class RecorderReader {
+
+    public:
+      /**
+       * @brief Function called for each sample read
+       *
+       * Returns false to stop reading.
+       */
+      typedef std::function<bool (const Recorder::Sample &) > Callback;
+
+      /**
+       * @brief Constructor
+       */
+      explicit RecorderReader (const std::string & path);
+
+      /**
+       * @brief Default constructor
+       *
+       * object cannot be used without calling open()
+       */
+      RecorderReader ();
+
+      /**
+       * @brief Destructor
+       */
+      virtual ~RecorderReader();
+
+      /**
+       * @brief Opens the file @b path
+       * @return true if successful.
+       * Otherwise it shall return false and set errno.
+       */
+      bool open (const std::string & path);
+
+      /**
+       * @brief Closes the file
+       */
+      void close();
+
+      /**
+       * @brief returns true if the file is open
+       */
+      bool isOpen() const;
+
+      /**
+       * @brief Recorded channels, the index is the channel number
+       */
+      std::vector<Recorder::Channel> channels() const;
+
+      /**
+       * @brief Returns the channel number of a register range, -1 if not found
+       */
+      int channel (int slave, Table t, int addr, int nb) const;
+
+      /**
+       * @brief Reads the samples of a time range
+       *
+       * The samples of the channel @b ch whose timestamp is in [@b from, @b to]
+       * are passed in chronological order to @b cb. If @b ch is -1, the samples
+       * of all channels are read.
+       *
+       * @return the number of samples read if successful.
+       * Otherwise it shall return -1 and set errno.
+       */
+      int read (int ch, uint64_t from, uint64_t to, Callback cb) const;
+
+      /**
+       * @overload
+       *
+       * Returns the samples in a vector.
+       */
+      std::vector<Recorder::Sample> read (int ch, uint64_t from, uint64_t to) const;
+
+    protected:
+      class Private;
+      RecorderReader (Private &dd);
+      std::unique_ptr<Private> d_ptr;
+
+    private:
+      PIMP_DECLARE_PRIVATE (RecorderReader)
+  };
+}
+
+/* ========================================================================== */
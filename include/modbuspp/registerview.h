@@ -0,0 +1,225 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdexcept>
+#include <modbuspp/data.h>
+#include <modbuspp/swap.h>
+
+namespace Modbus {
+
+  /**
+   * @class RegisterView
+   * @brief Typed view of an array of 16-bit Modbus registers
+   *
+   * A RegisterView gives access to registers as an array of values of type T
+   * stored with the bytes and words order @b e, without copy: each value is
+   * converted in place when it is read or written. It does not own the
+   * registers, it is usually obtained from BufferedSlave::view() and must
+   * not be used after the block of the slave has been modified by
+   * setBlock() or the slave destroyed.
+   *
+   * @code
+      RegisterView<float, EndianBigLittle> temp = slv.view<float, EndianBigLittle> (InputRegister, 1, 100);
+
+      for (size_t i = 0; i < temp.size(); i++) {
+
+        temp[i] = sensor[i].value(); // converted directly in the input registers
+      }
+   * @endcode
+   *
+   * @param T is a type of arithmetic data (int, float ...) of a size greater
+   * than or equal to 2.
+   * @param e is the order of bytes and words in the data model used by the
+   * user's Modbus network.
+   *
+   * @author Pascal JEAN, aka epsilonrt
+   * @copyright GNU Lesser General Public License
+   */
+  template <typename T, Endian e = EndianBig>
+  class RegisterView {
+    public:
+      static_assert ( (sizeof (T) >= 2 && (sizeof (T) % 2) == 0), "Bad Data typename !");
+      static_assert (std::is_arithmetic<T>::value, "Arithmetic type required !");
+
+      /**
+       * @brief Number of registers of a value
+       */
+      static constexpr std::size_t Width = sizeof (T) / 2;
+
+      /**
+       * @class Reference
+       * @brief Reference to a value of the view
+       *
+       * Converts the registers of the value when it is read or assigned.
+       */
+      class Reference {
+        public:
+          operator T() const {
+            return StaticData<T, e>::fromRegisters (m_regs);
+          }
+
+          Reference & operator= (const T & v) {
+            StaticData<T, e>::toRegisters (m_regs, v);
+            return *this;
+          }
+
+          Reference & operator= (const Reference & other) {
+            return *this = static_cast<T> (other);
+          }
+
+          /**
+           * @brief Registers of the value
+           */
+          uint16_t * registers() const {
+            return m_regs;
+          }
+
+        private:
+          friend class RegisterView;
+          explicit Reference (uint16_t * regs) : m_regs (regs) {}
+          uint16_t * m_regs;
+      };
+
+      /**
+       * @brief Default constructor, an empty view
+       */
+      RegisterView() : m_regs (nullptr), m_size (0), m_address (0) {}
+
+      /**
+       * @brief Constructor
+       *
+       * @param regs registers, must contain @b nb * Width registers
+       * @param nb number of values
+       * @param addr address of the first register, for information
+       */
+      RegisterView (uint16_t * regs, std::size_t nb, int addr = 0) :
+        m_regs (regs), m_size (regs ? nb : 0), m_address (addr) {}
+
+      /**
+       * @brief Number of values
+       */
+      std::size_t size() const {
+        return m_size;
+      }
+
+      /**
+       * @brief returns true if the view is empty
+       */
+      bool empty() const {
+        return m_size == 0;
+      }
+
+      /**
+       * @brief Address of the first register
+       */
+      int address() const {
+        return m_address;
+      }
+
+      /**
+       * @brief Viewed registers
+       */
+      uint16_t * registers() const {
+        return m_regs;
+      }
+
+      /**
+       * @brief Access to the value @b i without bounds checking
+       */
+      Reference operator[] (std::size_t i) const {
+        return Reference (m_regs + i * Width);
+      }
+
+      /**
+       * @brief Access to the value @b i
+       *
+       * @throw std::out_of_range if @b i is not lower than size()
+       */
+      Reference at (std::size_t i) const {
+
+        if (i >= m_size) {
+
+          throw std::out_of_range ("RegisterView index out of range");
+        }
+        return (*this) [i];
+      }
+
+      /**
+       * @brief Sub-view of @b nb values from the value @b pos
+       *
+       * @throw std::out_of_range if the range exceeds the view
+       */
+      RegisterView subview (std::size_t pos, std::size_t nb) const {
+
+        if (pos > m_size || nb > (m_size - pos)) {
+
+          throw std::out_of_range ("RegisterView range out of range");
+        }
+        return RegisterView (m_regs + pos * Width, nb, m_address + pos * Width);
+      }
+
+      /**
+       * @brief Reads @b nb values from the value @b pos to @b dest
+       *
+       * The values are converted in one pass by swapRegisters().
+       *
+       * @throw std::out_of_range if the range exceeds the view
+       */
+      void read (T * dest, std::size_t pos, std::size_t nb) const {
+        RegisterView v = subview (pos, nb);
+
+        swapRegisters (dest, v.m_regs, nb, sizeof (T), e);
+      }
+
+      /**
+       * @brief Writes @b nb values from @b src to the value @b pos
+       *
+       * The values are converted in one pass by swapRegisters().
+       *
+       * @throw std::out_of_range if the range exceeds the view
+       */
+      void write (std::size_t pos, const T * src, std::size_t nb) const {
+        RegisterView v = subview (pos, nb);
+
+        swapRegisters (v.m_regs, src, nb, sizeof (T), e);
+      }
+
+      /**
+       * @brief Sets all values to @b v
+       */
+      void fill (const T & v) const {
+        uint16_t regs[Width];
+
+        StaticData<T, e>::toRegisters (regs, v);
+        for (std::size_t i = 0; i < m_size; i++) {
+
+          std::memcpy (m_regs + i * Width, regs, sizeof (T));
+        }
+      }
+
+    private:
+      uint16_t * m_regs;
+      std::size_t m_size;
+      int m_address;
+  };
+
+  template <typename T, Endian e>
+  constexpr std::size_t RegisterView<T, e>::Width;
+}
+
+/* ========================================================================== */
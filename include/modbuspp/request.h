@@ -53,11 +53,22 @@ namespace Modbus {
       
       /**
        * @brief Move Constructor
-       * The object acquires the content managed by @b other. 
-       * @b other becomes an empty object (as if default-constructed).
+       * The object acquires the content managed by @b other, without copy
+       * nor allocation. @b other becomes an empty object, isValid() returns
+       * false.
        */
       Request (Request && other);
 
+      /**
+       * @brief Copy assignment, without allocation
+       */
+      Request & operator= (const Request & other);
+
+      /**
+       * @brief Move assignment
+       */
+      Request & operator= (Request && other);
+
       /**
        * @brief Returns the byte count of the request
        *
@@ -88,9 +99,36 @@ namespace Modbus {
        * 
        * Can be used for function Write Multiple registers(16).
        * This values are at the pdu[6+index].
+       * The registers out of the PDU are ignored.
        */
       void registerValues (uint16_t index, uint16_t quantity, uint16_t * values) const;
 
+      /**
+       * @brief Returns values of the request
+       *
+       * Reads @b nb values of type T stored with the order @b e from the
+       * register @b index, in a single conversion pass.
+       * Can be used for function Write Multiple registers(16).
+       * @throw std::out_of_range if the values are out of the PDU.
+       */
+      template <typename T> void registerValues (uint16_t index, T * values, uint16_t nb, Endian e) const {
+        getValues (6 + index * 2, values, nb, e);
+      }
+
+      /**
+       * @overload
+       */
+      template <typename T, Endian e> void registerValues (uint16_t index, Data<T, e> * values, uint16_t nb) const {
+        getData (6 + index * 2, values, nb);
+      }
+
+      /**
+       * @overload
+       */
+      template <typename T, Endian e> void registerValues (uint16_t index, StaticData<T, e> * values, uint16_t nb) const {
+        getValues (6 + index * 2, reinterpret_cast<T *> (values), nb, e);
+      }
+
       /**
        * @brief Returns the coil value of the request 
        * 
@@ -145,9 +183,36 @@ namespace Modbus {
        *
        * Can be used for function Write Multiple registers(16).
        * This value is at the pdu[6+index].
+       * The registers out of the PDU are ignored.
        */
       void setRegisterValues (uint16_t index, uint16_t quantity, const uint16_t * values);
 
+      /**
+       * @brief Sets values for the request
+       *
+       * Writes @b nb values of type T with the order @b e from the
+       * register @b index, in a single conversion pass.
+       * Can be used for function Write Multiple registers(16).
+       * @throw std::out_of_range if the values are out of the PDU.
+       */
+      template <typename T> void setRegisterValues (uint16_t index, const T * values, uint16_t nb, Endian e) {
+        setValues (6 + index * 2, values, nb, e);
+      }
+
+      /**
+       * @overload
+       */
+      template <typename T, Endian e> void setRegisterValues (uint16_t index, Data<T, e> * values, uint16_t nb) {
+        setData (6 + index * 2, values, nb);
+      }
+
+      /**
+       * @overload
+       */
+      template <typename T, Endian e> void setRegisterValues (uint16_t index, const StaticData<T, e> * values, uint16_t nb) {
+        setValues (6 + index * 2, reinterpret_cast<const T *> (values), nb, e);
+      }
+
       /**
        * @brief Sets the coil value for the request
        *
@@ -172,6 +237,92 @@ namespace Modbus {
        */
       void setCoilValues (uint16_t index, uint16_t quantity, const bool * values);
 
+      /**
+       * @brief Returns the write starting address of the request
+       *
+       * Can be used for function Read/Write Multiple registers(23), the read
+       * starting address is startingAddress().
+       * This value is at the pdu[5].
+       */
+      uint16_t writeAddress () const;
+
+      /**
+       * @brief Returns the quantity of registers to write of the request
+       *
+       * Can be used for function Read/Write Multiple registers(23), the
+       * quantity to read is quantity().
+       * This value is at the pdu[7].
+       */
+      uint16_t writeQuantity () const;
+
+      /**
+       * @brief Returns register values to write of the request
+       *
+       * Can be used for function Read/Write Multiple registers(23).
+       * This values are at the pdu[10+index].
+       * The registers out of the PDU are ignored.
+       */
+      void writeRegisterValues (uint16_t index, uint16_t quantity, uint16_t * values) const;
+
+      /**
+       * @brief Sets the write starting address for the request
+       *
+       * Can be used for function Read/Write Multiple registers(23).
+       * This value is at the pdu[5].
+       */
+      void setWriteAddress (uint16_t addr);
+
+      /**
+       * @brief Sets the quantity of registers to write for the request
+       *
+       * Can be used for function Read/Write Multiple registers(23), the
+       * write byte count (pdu[9]) is updated.
+       * This value is at the pdu[7].
+       */
+      void setWriteQuantity (uint16_t n);
+
+      /**
+       * @brief Sets register values to write for the request
+       *
+       * Can be used for function Read/Write Multiple registers(23).
+       * This values are at the pdu[10+index].
+       * The registers out of the PDU are ignored.
+       */
+      void setWriteRegisterValues (uint16_t index, uint16_t quantity, const uint16_t * values);
+
+      /**
+       * @brief Returns the AND mask of the request
+       *
+       * Can be used for function Mask Write Register(22), the register
+       * address is startingAddress().
+       * This value is at the pdu[3].
+       */
+      uint16_t andMask () const;
+
+      /**
+       * @brief Returns the OR mask of the request
+       *
+       * Can be used for function Mask Write Register(22).
+       * This value is at the pdu[5].
+       */
+      uint16_t orMask () const;
+
+      /**
+       * @brief Sets the AND mask of the request
+       *
+       * Can be used for function Mask Write Register(22).
+       * This value is at the pdu[3].
+       */
+      void setAndMask (uint16_t mask);
+
+      /**
+       * @brief Sets the OR mask of the request
+       *
+       * Can be used for function Mask Write Register(22).
+       * This value is at the pdu[5].
+       */
+      void setOrMask (uint16_t mask);
+
     protected:
       class Private;
       Request (Private &dd);
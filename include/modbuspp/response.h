@@ -52,11 +52,37 @@ namespace Modbus {
       
       /**
        * @brief Move Constructors
+       *
+       * The response copies the ADU of @b req in its own private data, and
+       * those of @b req return to the pool of the thread: a received request
+       * is turned into its response without allocation once the pool is
+       * filled, the header (transaction identifier or slave address) and the
+       * function code being kept. @b req becomes an empty object, isValid()
+       * returns false.
+       *
+       * @code
+          int messageHandler (Message * req, Device * dev) {
+            Response rsp (std::move (*req)); // the server creates a new request
+            rsp.setSize (1); // keep until function code
+            ...
+            return dev->sendRawMessage (rsp, true);
+          }
+       * @endcode
        */
       Response (Request && req);
       Response (Message && msg);
       Response (Response && other);
 
+      /**
+       * @brief Copy assignment, without allocation
+       */
+      Response & operator= (const Response & other);
+
+      /**
+       * @brief Move assignment
+       */
+      Response & operator= (Response && other);
+
       /**
        * @brief Sets the byte count for the response
        *
@@ -81,14 +107,42 @@ namespace Modbus {
        * Can be used for the functions Read Holding Registers(03) and 
        * Read Input Register(04).
        * This value is at the pdu[2 + index*2].
+       * The registers out of the PDU are ignored.
        */
       void setRegisterValues (uint16_t index, uint16_t quantity, const uint16_t * values);
 
+      /**
+       * @brief Sets values for the response
+       *
+       * Writes @b nb values of type T with the order @b e from the
+       * register @b index, in a single conversion pass.
+       * Can be used for the functions Read Holding Registers(03) and
+       * Read Input Register(04).
+       * @throw std::out_of_range if the values are out of the PDU.
+       */
+      template <typename T> void setRegisterValues (uint16_t index, const T * values, uint16_t nb, Endian e) {
+        setValues (2 + index * 2, values, nb, e);
+      }
+
+      /**
+       * @overload
+       */
+      template <typename T, Endian e> void setRegisterValues (uint16_t index, Data<T, e> * values, uint16_t nb) {
+        setData (2 + index * 2, values, nb);
+      }
+
+      /**
+       * @overload
+       */
+      template <typename T, Endian e> void setRegisterValues (uint16_t index, const StaticData<T, e> * values, uint16_t nb) {
+        setValues (2 + index * 2, reinterpret_cast<const T *> (values), nb, e);
+      }
+
       /**
        * @brief Sets a bit value for the response
        *
        * Can be used for the functions Read Coils(01), Read Discrete Inputs(02).
-       * This value is at the pdu[2 + index*2].
+       * This value is at the pdu[2 + index / 8].
        */
       void setBitValue (uint16_t index, bool value);
 
@@ -96,7 +150,7 @@ namespace Modbus {
        * @brief Sets bit values for the response
        *
        * Can be used for the functions Read Coils(01), Read Discrete Inputs(02).
-       * This value is at the pdu[2 + index*2].
+       * This value is at the pdu[2 + index / 8].
        */
       void setBitValues (uint16_t index, uint16_t quantity, const bool * values);
 
@@ -131,14 +185,42 @@ namespace Modbus {
        * Can be used for the functions Read Holding Registers(03) and 
        * Read Input Register(04).
        * This value is at the pdu[2 + index*2].
+       * The registers out of the PDU are ignored.
        */
       void registerValues (uint16_t index, uint16_t quantity, uint16_t * values) const;
+
+      /**
+       * @brief Returns values of the response
+       *
+       * Reads @b nb values of type T stored with the order @b e from the
+       * register @b index, in a single conversion pass.
+       * Can be used for the functions Read Holding Registers(03) and
+       * Read Input Register(04).
+       * @throw std::out_of_range if the values are out of the PDU.
+       */
+      template <typename T> void registerValues (uint16_t index, T * values, uint16_t nb, Endian e) const {
+        getValues (2 + index * 2, values, nb, e);
+      }
+
+      /**
+       * @overload
+       */
+      template <typename T, Endian e> void registerValues (uint16_t index, Data<T, e> * values, uint16_t nb) const {
+        getData (2 + index * 2, values, nb);
+      }
+
+      /**
+       * @overload
+       */
+      template <typename T, Endian e> void registerValues (uint16_t index, StaticData<T, e> * values, uint16_t nb) const {
+        getValues (2 + index * 2, reinterpret_cast<T *> (values), nb, e);
+      }
       
       /**
        * @brief Returns a bit value of the response
        * 
        * Can be used for the functions Read Coils(01), Read Discrete Inputs(02).
-       * This value is at the pdu[2 + index*2].
+       * This value is at the pdu[2 + index / 8].
        */
       bool bitValue (uint16_t index) const;
 
@@ -146,7 +228,7 @@ namespace Modbus {
        * @brief Returns bit values of the response
        * 
        * Can be used for the functions Read Coils(01), Read Discrete Inputs(02).
-       * This value is at the pdu[2 + index*2].
+       * This value is at the pdu[2 + index / 8].
        */
       void bitValues (uint16_t index, uint16_t quantity, bool * values) const;
       
@@ -0,0 +1,192 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <functional>
+#include <modbuspp/message.h>
+#include <modbuspp/pimp.h>
+
+namespace Modbus {
+
+  /**
+   * @class RtuFramer
+   * @brief Incremental parser of Modbus RTU frames
+   *
+   * The framer consumes the bytes of a serial line as they arrive and calls
+   * a callback for each complete and valid frame, as soon as its last byte
+   * has been received.
+   *
+   * The end of a frame is detected from the length expected for its
+   * function code, checked by the CRC16 computed incrementally. The frames
+   * whose length cannot be determined from their header (e.g. unknown
+   * function codes) are ended by a silence of 3.5 characters (t3.5), the
+   * timestamps of the received bytes being provided by the application.
+   * A frame with an invalid CRC is discarded with the bytes that follow,
+   * until the next silence.
+   *
+   * @code
+      RtuFramer framer (115200);
+
+      framer.setCallback ([] (Message & msg) {
+        std::cout << msg << std::endl;
+      });
+      for (;;) {
+        ssize_t n = read (fd, buf, sizeof (buf));
+        if (n > 0) {
+          framer.push (buf, n);
+        }
+        else {
+          framer.poll();
+        }
+      }
+   * @endcode
+   *
+   * @author Pascal JEAN, aka epsilonrt
+   * @copyright GNU Lesser General Public License
+   */
+  class RtuFramer {
+
+    public:
+      /**
+       * @enum Direction
+       * @brief Kind of frames expected on the line
+       */
+      enum Direction {
+        Requests = 0x01,  ///< requests of a master (e.g. in a server)
+        Responses = 0x02, ///< responses of slaves (e.g. in a master)
+        Both = Requests | Responses ///< both (e.g. in a bus sniffer)
+      };
+
+      /**
+       * @brief Function called for each valid frame
+       *
+       * The message is flagged as a response if it has been recognized as a
+       * response (see Message::isResponse()), it is valid only during the call.
+       */
+      typedef std::function<void (Message & msg) > Callback;
+
+      /**
+       * @brief Constructor
+       *
+       * @param baudrate speed of the line in bauds, used to compute the
+       * silence time t3.5
+       * @param d kind of frames expected
+       */
+      explicit RtuFramer (int baudrate = 19200, Direction d = Both);
+
+      /**
+       * @brief Destructor
+       */
+      virtual ~RtuFramer();
+
+      /**
+       * @brief Set the callback function called for each valid frame
+       */
+      void setCallback (Callback cb);
+
+      /**
+       * @brief Speed of the line in bauds
+       */
+      int baudrate() const;
+
+      /**
+       * @brief Set the speed of the line in bauds
+       */
+      void setBaudrate (int baudrate);
+
+      /**
+       * @brief Kind of frames expected
+       */
+      Direction direction() const;
+
+      /**
+       * @brief Set the kind of frames expected
+       */
+      void setDirection (Direction d);
+
+      /**
+       * @brief Silence time t3.5 marking the end of a frame, in microseconds
+       *
+       * 3.5 characters of 11 bits up to 19200 bauds, 1750 µs above.
+       */
+      unsigned long silenceTime() const;
+
+      /**
+       * @brief Consumes received bytes
+       *
+       * @param data received bytes
+       * @param len number of bytes
+       * @param timestamp reception time of the last byte in microseconds,
+       * 0 for the current time of a monotonic clock
+       * @return the number of frames passed to the callback
+       */
+      int push (const uint8_t * data, size_t len, uint64_t timestamp = 0);
+
+      /**
+       * @brief Ends the current frame if the line is silent since t3.5
+       *
+       * Must be called when no bytes are received, to end the frames whose
+       * length cannot be determined from their header.
+       *
+       * @param timestamp current time in microseconds, 0 for the current
+       * time of a monotonic clock
+       * @return the number of frames passed to the callback
+       */
+      int poll (uint64_t timestamp = 0);
+
+      /**
+       * @brief Discards the bytes of the current frame
+       */
+      void reset();
+
+      /**
+       * @brief Number of bytes of the current frame
+       */
+      size_t pending() const;
+
+      /**
+       * @brief Number of valid frames received
+       */
+      unsigned long frames() const;
+
+      /**
+       * @brief Number of invalid frames received
+       */
+      unsigned long errors() const;
+
+      /**
+       * @brief Expected length of an ADU from its first bytes
+       *
+       * @param adu first bytes of the ADU, from the slave address
+       * @param len number of bytes of @b adu
+       * @param response true for a response, false for a request
+       * @return the length of the ADU including the CRC, 0 if more bytes are
+       * needed, -1 if the length can not be determined from the header.
+       */
+      static int frameLength (const uint8_t * adu, size_t len, bool response);
+
+    protected:
+      class Private;
+      RtuFramer (Private &dd);
+      std::unique_ptr<Private> d_ptr;
+
+    private:
+      PIMP_DECLARE_PRIVATE (RtuFramer)
+  };
+}
+
+/* ========================================================================== */
@@ -194,6 +194,16 @@ namespace Modbus {
        */
       static uint16_t crc16 (const uint8_t * buf, uint16_t count);
 
+      /**
+       * @brief Continues a Modbus CRC16 generation
+       *
+       * Computes the CRC16 of @b buf following bytes whose CRC16 is @b crc,
+       * so that a CRC can be computed incrementally as the bytes are
+       * received, the initial value being 0xFFFF.
+       * The CRC16 of a frame including its CRC is 0.
+       */
+      static uint16_t crc16 (const uint8_t * buf, uint16_t count, uint16_t crc);
+
     protected:
       class Private;
       RtuLayer (Private &dd);
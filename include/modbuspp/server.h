@@ -287,7 +287,119 @@ namespace Modbus {
        * @brief Returns the list of slaves as a map indexed by identifier number 
        */
       const std::map <int, std::shared_ptr<BufferedSlave>> & slaves() const;
-      
+
+      /**
+       * @brief Takes a snapshot of the data of all the slaves
+       *
+       * The snapshot holds the values of all the blocks of the four tables
+       * of all the slaves, taken at the same point in time: the copy is
+       * made again if a slave is written during it, the writers and the
+       * server are not blocked. It is a
+       * compact binary image (bits packed, no field names), with a version,
+       * its length and a CRC-32, independent of the byte order of the host.
+       * It can be saved for backups or diagnostics and restored with
+       * restore(), by this server or another one with the same slaves.
+       *
+       * @code
+          std::vector<uint8_t> full = srv.snapshot();
+          // ... later, only the values changed since full
+          std::vector<uint8_t> delta = srv.snapshot (full);
+       * @endcode
+       */
+      std::vector<uint8_t> snapshot() const;
+
+      /**
+       * @brief Takes a delta snapshot against a previous snapshot
+       *
+       * Returns only the ranges of values that have changed since the full
+       * snapshot @b previous, and the blocks that it does not hold. A delta
+       * restored by restore() must be applied to the values of @b previous.
+       * If @b previous is not a valid full snapshot, a full snapshot is
+       * returned.
+       */
+      std::vector<uint8_t> snapshot (const std::vector<uint8_t> & previous) const;
+
+      /**
+       * @brief Restores a snapshot taken by snapshot()
+       *
+       * The values are written in the blocks of the slaves at once, the
+       * values of slaves or blocks that do not exist in this server are
+       * ignored. They are not written to the devices of the slaves and are
+       * not reported as changes (see BufferedSlave::changes()).
+       *
+       * @return the number of values restored if successful.
+       * Otherwise it shall return -1 and set errno (EPROTO if @b snapshot
+       * is not a valid snapshot).
+       */
+      int restore (const std::vector<uint8_t> & snapshot);
+
+      /**
+       * @brief Replicates the slaves to standby servers
+       *
+       * The server becomes the primary of a replication: it listens on the
+       * Unix socket @b path for standby servers (see replicateFrom()). A
+       * thread checks the slaves every @b period microseconds and, if they
+       * have been written by a client, by the application or from their
+       * devices, sends the changes to the standbys in a delta snapshot (see
+       * snapshot()) numbered by a sequence number. The writes of a period
+       * are sent in a single delta. A standby that connects first receives
+       * a full snapshot.
+       *
+       * The primary never waits for the standbys: the frames that a standby
+       * has not read yet are kept for it, and a standby that falls too far
+       * behind (several megabytes) is disconnected so that it does not hold
+       * back the other standbys; it must then connect again to receive a
+       * full snapshot.
+       *
+       * The slaves must be added before calling this function.
+       * Not available on Windows.
+       *
+       * @return true if successful.
+       * Otherwise it shall return false and set errno.
+       */
+      bool startReplication (const std::string & path, int period = 500);
+
+      /**
+       * @brief Replicates the slaves of a primary server
+       *
+       * The server becomes a standby of the primary listening on the Unix
+       * socket @b path (see startReplication()): a thread applies the
+       * snapshots received to the slaves, which must be the same as those
+       * of the primary. When the primary stops, isReplicating() returns
+       * false and the standby can take over, for example by opening its
+       * Modbus TCP port with identical data.
+       *
+       * @code
+          standby.replicateFrom ("/run/plc.repl");
+          while (standby.isReplicating()) {
+            std::this_thread::sleep_for (std::chrono::milliseconds (10));
+          }
+          standby.open(); // failover
+          standby.run();
+       * @endcode
+       *
+       * @return true if connected to the primary.
+       * Otherwise it shall return false and set errno.
+       */
+      bool replicateFrom (const std::string & path);
+
+      /**
+       * @brief Stops the replication, as primary or standby
+       */
+      void stopReplication();
+
+      /**
+       * @brief returns true if the server is a primary or a standby connected
+       * to its primary
+       */
+      bool isReplicating() const;
+
+      /**
+       * @brief Sequence number of the last snapshot sent by the primary or
+       * applied by the standby
+       */
+      uint64_t replicationSequence() const;
+
       /**
        * @brief Set the message callback function @b cb
        * 
@@ -304,6 +416,25 @@ namespace Modbus {
        */
       Message::Callback messageCallback() const;
 
+      /**
+       * @brief Set the handler of the function code @b function
+       *
+       * The handler is called for the requests of the code @b function to all
+       * the slaves of the server, except those with their own handler (see
+       * BufferedSlave::setFunctionHandler()). The handlers are in a table
+       * indexed by the function code, the requests of the codes without
+       * handler are replied as usual. An empty @b handler removes the handler.
+       *
+       * @throw std::logic_error if the server is open.
+       */
+      void setFunctionHandler (int function, BufferedSlave::FunctionHandler handler);
+
+      /**
+       * @brief Return the handler of the function code @b function, empty if
+       * none
+       */
+      BufferedSlave::FunctionHandler functionHandler (int function) const;
+
 
     protected:
       class Private;
@@ -0,0 +1,180 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <string>
+#include <modbuspp/global.h>
+#include <modbuspp/pimp.h>
+
+namespace Modbus {
+
+  /**
+   * @class SharedMap
+   * @brief Access to the data of a BufferedSlave from another process
+   *
+   * A BufferedSlave can place the blocks set by BufferedSlave::setBlock() in
+   * a named POSIX shared memory segment (see
+   * BufferedSlave::attachSharedMemory()). A SharedMap opens this segment in
+   * another process of the same host and reads or writes the data directly,
+   * without Modbus round trip. The segment carries a versioned header and a
+   * seqlock: the reads never see a partial write, of the server or of
+   * another process, and the writes between beginUpdate() and endUpdate()
+   * become visible at once.
+   *
+   * @code
+      // acquisition process
+      SharedMap shm ("plc1", true);
+      float t = sensor.read();
+      shm.writeRegisters (InputRegister, 0, (uint16_t *) &t, 2);
+   * @endcode
+   *
+   * The addresses are PDU addresses (from 0), the segment does not know the
+   * addressing mode of the slave. A process that dies while writing blocks
+   * the writers and the readers of the segment.
+   *
+   * Not available on Windows.
+   *
+   * @author Pascal JEAN, aka epsilonrt
+   * @copyright GNU Lesser General Public License
+   */
+  class SharedMap {
+
+    public:
+      /**
+       * @brief Default constructor
+       */
+      SharedMap ();
+
+      /**
+       * @brief Constructor opening the segment @b name
+       *
+       * @throw std::runtime_error if the segment cannot be opened
+       */
+      explicit SharedMap (const std::string & name, bool writable = false);
+
+      /**
+       * @brief Destructor
+       */
+      virtual ~SharedMap();
+
+      /**
+       * @brief Opens the segment @b name created by a BufferedSlave
+       *
+       * @param name name of the segment, a leading '/' is added if missing
+       * @param writable if false, the segment is mapped read-only
+       * @return true if successful.
+       * Otherwise it shall return false and set errno (EPROTO if the segment
+       * is not a libmodbuspp segment or has a different version).
+       */
+      bool open (const std::string & name, bool writable = false);
+
+      /**
+       * @brief Unmaps the segment
+       */
+      void close();
+
+      /**
+       * @brief returns true if the segment is open
+       */
+      bool isOpen() const;
+
+      /**
+       * @brief returns true if the segment is open for writing
+       */
+      bool isWritable() const;
+
+      /**
+       * @brief Name of the segment
+       */
+      std::string name() const;
+
+      /**
+       * @brief PDU address of the first element of the table @b t
+       */
+      int startingAddress (Table t) const;
+
+      /**
+       * @brief Number of elements of the table @b t, 0 if none
+       */
+      int size (Table t) const;
+
+      /**
+       * @brief Reads bits of the table @b t (Coil or DiscreteInput)
+       *
+       * @b nb is limited to the end of the table.
+       * @return the number of bits read if successful.
+       * Otherwise it shall return -1 and set errno.
+       */
+      int readBits (Table t, int addr, bool * dest, int nb = 1) const;
+
+      /**
+       * @brief Reads registers of the table @b t (InputRegister or HoldingRegister)
+       *
+       * @b nb is limited to the end of the table.
+       * @return the number of registers read if successful.
+       * Otherwise it shall return -1 and set errno.
+       */
+      int readRegisters (Table t, int addr, uint16_t * dest, int nb = 1) const;
+
+      /**
+       * @brief Writes bits of the table @b t (Coil or DiscreteInput)
+       *
+       * @return the number of bits written if successful.
+       * Otherwise it shall return -1 and set errno (EBADF if read-only).
+       */
+      int writeBits (Table t, int addr, const bool * src, int nb = 1);
+
+      /**
+       * @brief Writes registers of the table @b t (InputRegister or HoldingRegister)
+       *
+       * @return the number of registers written if successful.
+       * Otherwise it shall return -1 and set errno (EBADF if read-only).
+       */
+      int writeRegisters (Table t, int addr, const uint16_t * src, int nb = 1);
+
+      /**
+       * @brief Starts a group of writes
+       *
+       * The writes until endUpdate() become visible to the other processes
+       * at once. The calls can be nested.
+       */
+      void beginUpdate();
+
+      /**
+       * @brief Ends a group of writes started by beginUpdate()
+       */
+      void endUpdate();
+
+      /**
+       * @brief Removes the segment @b name
+       *
+       * The processes that have mapped the segment can still use it, it is
+       * freed when the last one unmaps it.
+       */
+      static bool remove (const std::string & name);
+
+    protected:
+      class Private;
+      SharedMap (Private &dd);
+      std::unique_ptr<Private> d_ptr;
+
+    private:
+      PIMP_DECLARE_PRIVATE (SharedMap)
+  };
+}
+
+/* ========================================================================== */
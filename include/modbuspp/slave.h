@@ -271,6 +271,60 @@ namespace Modbus {
       virtual int writeReadRegisters (int write_addr, const uint16_t * src, int write_nb,
                               int  read_addr, uint16_t * dest, int read_nb);
 
+      /**
+       * @brief Modify the bits of a single register
+       *
+       * This function shall modify the value of the holding register at the
+       * address @b addr of the remote device using the algorithm:
+       *
+       *   new value = (current value AND @b andMask) OR (@b orMask AND (NOT @b andMask))
+       *
+       * The register is modified by the device, without read-modify-write
+       * by the master, thus without race with the other masters.
+       *
+       * The function uses the Modbus function code 0x16 (mask single register).
+       *
+       * @return 1 if successful.
+       * Otherwise it shall return -1 and set errno.
+       */
+      virtual int maskWriteRegister (int addr, uint16_t andMask, uint16_t orMask);
+
+      /**
+       * @brief Read many records of a file
+       *
+       * This function shall read the @b nb records (16-bit registers) from
+       * the record @b record of the file @b file of the remote device, in the
+       * @b dest array.
+       *
+       * The transfer is split in requests of the maximum size (121 records),
+       * on TCP up to 4 requests are sent without waiting for the responses.
+       *
+       * The function uses the Modbus function code 0x14 (read file record).
+       *
+       * @return the number of read records if successful.
+       * Otherwise it shall return -1 and set errno, EINVAL if the file is not
+       * in [1, 65535] or the records are not in [0, 9999].
+       */
+      virtual int readFileRecord (int file, int record, uint16_t * dest, int nb);
+
+      /**
+       * @brief Write many records of a file
+       *
+       * This function shall write the @b nb records (16-bit registers) of the
+       * @b src array from the record @b record of the file @b file of the
+       * remote device.
+       *
+       * The transfer is split in requests of the maximum size (122 records),
+       * on TCP up to 4 requests are sent without waiting for the responses.
+       *
+       * The function uses the Modbus function code 0x15 (write file record).
+       *
+       * @return the number of written records if successful.
+       * Otherwise it shall return -1 and set errno, EINVAL if the file is not
+       * in [1, 65535] or the records are not in [0, 9999].
+       */
+      virtual int writeFileRecord (int file, int record, const uint16_t * src, int nb);
+
       /**
        * @brief Read a single discrete input (input bit)
        *
@@ -365,20 +419,56 @@ namespace Modbus {
 
         ret = readInputRegisters (addr, buf.data(), buf.size());
         if (static_cast<std::size_t> (ret) == buf.size()) {
-          int n = 0;
 
-          for (int i = 0; i < nb; i++) {
+          Data<T, e>::fromRegisters (dest, buf.data(), nb);
+        }
+        return ret;
+      }
 
-            for (auto & r : dest[i].registers()) {
+      /**
+       * @brief Read many input values
+       *
+       * This function shall read the content of the @b nb input values of
+       * type T to the address @b addr of the device.
+       *
+       * The registers are read directly in the @b dest array, then converted
+       * in place according to the bytes and words order @b e, in one pass.
+       *
+       * The function uses the Modbus function code 0x04 (read input registers).
+       *
+       * @return return the number of read input Modbus registers (16-bit) if successful.
+       * Otherwise it shall return -1 and set errno.
+       */
+      template <typename T> int readInputRegisters (int addr, T * dest, int nb, Endian e) {
+        static_assert ( (sizeof (T) >= 2 && (sizeof (T) % 2) == 0), "Bad typename !");
+        static_assert (std::is_arithmetic<T>::value, "Arithmetic type required !");
+        int n = nb * sizeof (T) / 2;
+
+        int ret = readInputRegisters (addr, reinterpret_cast<uint16_t *> (dest), n);
+        if (ret == n) {
 
-              r = buf[n++];
-            }
-            dest[i].updateValue();
-          }
+          swapRegisters (reinterpret_cast<uint16_t *> (dest), nb, sizeof (T), e);
         }
         return ret;
       }
 
+      /**
+       * @brief Read many input data with a compile-time order
+       *
+       * StaticData arrays have the layout of T arrays, the registers are
+       * read directly in the @b dest array, then converted in place.
+       *
+       * The function uses the Modbus function code 0x04 (read input registers).
+       *
+       * @return return the number of read input Modbus registers (16-bit) if successful.
+       * Otherwise it shall return -1 and set errno.
+       */
+      template <typename T, Endian e> int readInputRegisters (int addr, StaticData<T, e> * dest, int nb = 1) {
+        static_assert (sizeof (StaticData<T, e>) == sizeof (T), "Bad StaticData layout !");
+
+        return readInputRegisters (addr, reinterpret_cast<T *> (dest), nb, e);
+      }
+
       /**
        * @brief Read a single input data
        *
@@ -455,20 +545,56 @@ namespace Modbus {
 
         ret = readRegisters (addr, buf.data(), buf.size());
         if (static_cast<std::size_t> (ret) == buf.size()) {
-          int n = 0;
 
-          for (int i = 0; i < nb; i++) {
+          Data<T, e>::fromRegisters (dest, buf.data(), nb);
+        }
+        return ret;
+      }
 
-            for (auto & r : dest[i].registers()) {
+      /**
+       * @brief Read many holding values
+       *
+       * This function shall read the content of the @b nb holding values of
+       * type T to the address @b addr of the device.
+       *
+       * The registers are read directly in the @b dest array, then converted
+       * in place according to the bytes and words order @b e, in one pass.
+       *
+       * The function uses the Modbus function code 0x03 (read holding registers).
+       *
+       * @return return the number of read holding Modbus registers (16-bit) if successful.
+       * Otherwise it shall return -1 and set errno.
+       */
+      template <typename T> int readRegisters (int addr, T * dest, int nb, Endian e) {
+        static_assert ( (sizeof (T) >= 2 && (sizeof (T) % 2) == 0), "Bad typename !");
+        static_assert (std::is_arithmetic<T>::value, "Arithmetic type required !");
+        int n = nb * sizeof (T) / 2;
+
+        int ret = readRegisters (addr, reinterpret_cast<uint16_t *> (dest), n);
+        if (ret == n) {
 
-              r = buf[n++];
-            }
-            dest[i].updateValue();
-          }
+          swapRegisters (reinterpret_cast<uint16_t *> (dest), nb, sizeof (T), e);
         }
         return ret;
       }
 
+      /**
+       * @brief Read many holding data with a compile-time order
+       *
+       * StaticData arrays have the layout of T arrays, the registers are
+       * read directly in the @b dest array, then converted in place.
+       *
+       * The function uses the Modbus function code 0x03 (read holding registers).
+       *
+       * @return return the number of read holding Modbus registers (16-bit) if successful.
+       * Otherwise it shall return -1 and set errno.
+       */
+      template <typename T, Endian e> int readRegisters (int addr, StaticData<T, e> * dest, int nb = 1) {
+        static_assert (sizeof (StaticData<T, e>) == sizeof (T), "Bad StaticData layout !");
+
+        return readRegisters (addr, reinterpret_cast<T *> (dest), nb, e);
+      }
+
       /**
        * @brief Write many holding data
        *
@@ -484,16 +610,80 @@ namespace Modbus {
        * Otherwise it shall return -1 and set errno.
        */
       template <typename T, Endian e> int writeRegisters (int addr, Data<T, e> * src, int nb = 1) {
-        std::vector<uint16_t> buf;
-
-        for (int i = 0; i < nb; i++) {
-          
-          src[i].updateRegisters();
-          for (auto & r : src[i].registers()) {
-            buf.push_back (r);
-          }
+        std::vector<uint16_t> buf (nb * sizeof (T) / 2);
+
+        Data<T, e>::toRegisters (buf.data(), src, nb);
+        return writeRegisters (addr, buf.data(), buf.size());
+      }
+
+      /**
+       * @brief Write many holding values
+       *
+       * This function shall write the content of the @b nb holding values
+       * of type T from the array @b src at address @b addr of the device.
+       *
+       * The values are converted to registers according to the bytes and
+       * words order @b e, in one pass.
+       *
+       * The function uses the Modbus function code 0x10 (preset multiple registers).
+       *
+       * @return number of written holding Modbus registers (16-bit) if successful.
+       * Otherwise it shall return -1 and set errno.
+       */
+      template <typename T> int writeRegisters (int addr, const T * src, int nb, Endian e) {
+        static_assert ( (sizeof (T) >= 2 && (sizeof (T) % 2) == 0), "Bad typename !");
+        static_assert (std::is_arithmetic<T>::value, "Arithmetic type required !");
+        std::vector<uint16_t> buf (nb * sizeof (T) / 2);
+
+        swapRegisters (buf.data(), src, nb, sizeof (T), e);
+        return writeRegisters (addr, buf.data(), buf.size());
+      }
+
+      /**
+       * @brief Write many holding data with a compile-time order
+       *
+       * The function uses the Modbus function code 0x10 (preset multiple registers).
+       *
+       * @return number of written holding Modbus registers (16-bit) if successful.
+       * Otherwise it shall return -1 and set errno.
+       */
+      template <typename T, Endian e> int writeRegisters (int addr, const StaticData<T, e> * src, int nb = 1) {
+        static_assert (sizeof (StaticData<T, e>) == sizeof (T), "Bad StaticData layout !");
+
+        return writeRegisters (addr, reinterpret_cast<const T *> (src), nb, e);
+      }
+
+      /**
+       * @brief Write and read many holding values in a single transaction
+       *
+       * This function shall write the content of the @b write_nb holding
+       * values of type T from the array @b src at address @b write_addr of
+       * the device, then shall read the @b read_nb holding values of type T
+       * at address @b read_addr in the @b dest array.
+       *
+       * The values are converted according to the bytes and words order
+       * @b e, the read registers are converted in place.
+       *
+       * The function uses the Modbus function code 0x17 (write/read registers).
+       *
+       * @return the number of read holding Modbus registers (16-bit) if successful.
+       * Otherwise it shall return -1 and set errno.
+       */
+      template <typename T> int writeReadRegisters (int write_addr, const T * src, int write_nb,
+          int read_addr, T * dest, int read_nb, Endian e) {
+        static_assert ( (sizeof (T) >= 2 && (sizeof (T) % 2) == 0), "Bad typename !");
+        static_assert (std::is_arithmetic<T>::value, "Arithmetic type required !");
+        std::vector<uint16_t> buf (write_nb * sizeof (T) / 2);
+        int n = read_nb * sizeof (T) / 2;
+
+        swapRegisters (buf.data(), src, write_nb, sizeof (T), e);
+        int ret = writeReadRegisters (write_addr, buf.data(), buf.size(),
+                                      read_addr, reinterpret_cast<uint16_t *> (dest), n);
+        if (ret == n) {
+
+          swapRegisters (reinterpret_cast<uint16_t *> (dest), read_nb, sizeof (T), e);
         }
-        return writeRegisters (addr, buf.data(), buf.size());;
+        return ret;
       }
 
       /**
@@ -0,0 +1,275 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <vector>
+#include <modbuspp/data.h>
+
+namespace Modbus {
+
+  class BufferedSlave;
+
+  /**
+   * @class Deadband
+   * @brief Change filter of a subscription
+   *
+   * A change of a value is reported only if its difference with the last
+   * reported value exceeds the deadband.
+   * - @b None: every change is reported.
+   * - @b Absolute: the difference must be greater than value().
+   * - @b Percent: the difference must be greater than value() percent of
+   * the last reported value (any change of a null value is reported).
+   */
+  class Deadband {
+    public:
+      /**
+       * @enum Type
+       * @brief Type of deadband
+       */
+      enum Type {
+        None = 0,
+        Absolute,
+        Percent
+      };
+
+      /**
+       * @brief Constructor
+       */
+      Deadband (Type t = None, double v = 0) : m_type (t), m_value (std::fabs (v)) {}
+
+      /**
+       * @brief Type of the deadband
+       */
+      Type type() const {
+        return m_type;
+      }
+
+      /**
+       * @brief Value of the deadband (absolute value or percentage)
+       */
+      double value() const {
+        return m_value;
+      }
+
+      /**
+       * @brief Returns true if @b current must be reported regarding @b previous
+       */
+      bool exceeded (double previous, double current) const {
+        double diff = std::fabs (current - previous);
+
+        switch (m_type) {
+          case Absolute:
+            return diff > m_value;
+          case Percent:
+            return (previous == 0) ? (diff != 0) :
+                   (diff * 100.0 / std::fabs (previous)) > m_value;
+          default:
+            break;
+        }
+        return current != previous;
+      }
+
+    private:
+      Type m_type;
+      double m_value;
+  };
+
+  /**
+   * @class DataChange
+   * @brief Diff record delivered by a subscription
+   *
+   * @b address is the data address of the first register of the value.
+   */
+  template <typename T>
+  struct DataChange {
+    int address;
+    T previous;
+    T current;
+  };
+
+  /**
+   * @class Subscription
+   * @brief Interest in a range of registers of a BufferedSlave
+   *
+   * The bits of the coils and discrete inputs are seen as registers
+   * containing 0 or 1, one register per bit.
+   *
+   * Base class of DataSubscription, it is created by
+   * BufferedSlave::subscribe() and the returned pointer is the handle used
+   * to unsubscribe.
+   */
+  class Subscription {
+    public:
+      /**
+       * @brief Constructor
+       *
+       * @param t table
+       * @param addr data address of the first register
+       * @param nb number of Modbus registers (16-bit) or bits
+       */
+      Subscription (Table t, int addr, int nb) :
+        m_table (t), m_address (addr), m_size (nb) {}
+
+      /**
+       * @brief Destructor
+       */
+      virtual ~Subscription() {}
+
+      /**
+       * @brief Table of the subscription
+       */
+      Table table() const {
+        return m_table;
+      }
+
+      /**
+       * @brief Data address of the first register
+       */
+      int address() const {
+        return m_address;
+      }
+
+      /**
+       * @brief Number of Modbus registers (16-bit) or bits of the subscription
+       */
+      int size() const {
+        return m_size;
+      }
+
+      friend class BufferedSlave;
+
+    protected:
+#ifndef __DOXYGEN__
+      // sets the reference values from the registers of the range
+      virtual void reset (const uint16_t * regs) = 0;
+      // compares the registers of the range with the reference values
+      // and calls the callback if needed, returns true if called
+      virtual bool check (const uint16_t * regs) = 0;
+#endif /* __DOXYGEN__ not defined */
+
+    private:
+      Table m_table;
+      int m_address;
+      int m_size;
+  };
+
+  /**
+   * @class DataSubscription
+   * @brief Subscription on an array of Data<T,e>
+   *
+   * The registers of the range are compared word by word with a shadow copy
+   * so that an unchanged range costs a single memcmp(). Only the values of
+   * which the difference with the last reported value exceeds the deadband
+   * are delivered to the callback, in a single call.
+   */
+  template <typename T, Endian e = EndianBig>
+  class DataSubscription : public Subscription {
+    public:
+      /**
+       * @brief Callback function receiving the changes
+       */
+      typedef std::function<void (const std::vector<DataChange<T>> &) > Callback;
+
+      /**
+       * @brief Constructor
+       *
+       * @param t table, T is usually uint16_t for a table of bits
+       * @param addr data address of the first value
+       * @param nb number of values Data<T,e>
+       * @param cb function called with the changes
+       * @param db deadband
+       */
+      DataSubscription (Table t, int addr, int nb, Callback cb, Deadband db = Deadband()) :
+        Subscription (t, addr, nb * Registers), m_cb (cb), m_deadband (db),
+        m_shadow (nb * Registers), m_values (nb) {}
+
+      /**
+       * @brief Deadband of the subscription
+       */
+      const Deadband & deadband() const {
+        return m_deadband;
+      }
+
+      /**
+       * @brief Last reported values
+       */
+      const std::vector<T> & values() const {
+        return m_values;
+      }
+
+    protected:
+#ifndef __DOXYGEN__
+      static const int Registers = sizeof (T) / 2;
+
+      void reset (const uint16_t * regs) {
+
+        std::memcpy (m_shadow.data(), regs, m_shadow.size() * sizeof (uint16_t));
+        for (std::size_t i = 0; i < m_values.size(); i++) {
+
+          m_values[i] = decode (&regs[i * Registers]);
+        }
+      }
+
+      bool check (const uint16_t * regs) {
+
+        if (std::memcmp (m_shadow.data(), regs, m_shadow.size() * sizeof (uint16_t)) == 0) {
+
+          return false;
+        }
+        std::memcpy (m_shadow.data(), regs, m_shadow.size() * sizeof (uint16_t));
+
+        m_changes.clear();
+        for (std::size_t i = 0; i < m_values.size(); i++) {
+          T v = decode (&regs[i * Registers]);
+
+          if (m_deadband.exceeded (static_cast<double> (m_values[i]), static_cast<double> (v))) {
+
+            m_changes.push_back ({static_cast<int> (address() + i * Registers), m_values[i], v});
+            m_values[i] = v;
+          }
+        }
+
+        if (!m_changes.empty() && m_cb) {
+
+          m_cb (m_changes);
+          return true;
+        }
+        return false;
+      }
+
+      static T decode (const uint16_t * regs) {
+        Data<T, e> d;
+
+        std::memcpy (d.registers().data(), regs, sizeof (T));
+        d.updateValue();
+        return d.value();
+      }
+#endif /* __DOXYGEN__ not defined */
+
+    private:
+      Callback m_cb;
+      Deadband m_deadband;
+      std::vector<uint16_t> m_shadow;
+      std::vector<T> m_values;
+      std::vector<DataChange<T>> m_changes;
+  };
+}
+
+/* ========================================================================== */
@@ -18,6 +18,8 @@
 
 #ifndef __DOXYGEN__
 
+#include <cstdint>
+#include <cstring>    // memcpy
 #include <algorithm>  // std::swap until C++11
 #include <utility>    // std::swap since C++11
 
@@ -40,12 +42,14 @@ T swapBytes (T input) { // swap bytes
  */
 template <typename T>
 T swapWords (T input) { // swap words
-  uint16_t * ptr = reinterpret_cast<uint16_t*> (&input);
+  uint16_t ptr[sizeof (T) / 2]; // memcpy avoids breaking strict aliasing
 
+  std::memcpy (ptr, &input, sizeof (T));
   for (std::size_t i = 0; i < sizeof (T) / 4; ++i) {
 
     std::swap (ptr[i], ptr[ (sizeof (T) / 2) - 1 - i ]);
   }
+  std::memcpy (&input, ptr, sizeof (T));
   return input;
 }
 
@@ -54,12 +58,14 @@ T swapWords (T input) { // swap words
  */
 template <typename T>
 T swapBytesInWords (T input) { // swap bytes in each words
-  uint16_t * ptr = reinterpret_cast<uint16_t*> (&input);
+  uint16_t ptr[sizeof (T) / 2]; // memcpy avoids breaking strict aliasing
 
+  std::memcpy (ptr, &input, sizeof (T));
   for (std::size_t i = 0; i < sizeof (T) / 2; ++i) {
 
     ptr[i] = swapBytes (ptr[i]);
   }
+  std::memcpy (&input, ptr, sizeof (T));
   return input;
 }
 
@@ -87,4 +93,57 @@ T ntoh (T input) {
 #endif
 }
 #endif /* __DOXYGEN__ not defined */
+
+#include <modbuspp/global.h>
+
+namespace Modbus {
+
+  /**
+   * @brief Converts an array of values from or to Modbus registers
+   *
+   * The @b regs array contains @b nmemb values of @b size bytes, each value
+   * being stored in @b size / 2 registers in the host byte order (as read
+   * or written by Slave::readRegisters() or Slave::writeRegisters()).
+   * The function converts the registers in place to the memory
+   * representation of the values according to the order @b e, as
+   * Data::updateValue() does for a single value. The conversion being
+   * symmetric, the same function converts values to registers, as
+   * Data::updateRegisters() does.
+   *
+   * The array is processed in one pass with SSE2/AVX2 or NEON instructions
+   * if available.
+   *
+   * @param regs array of registers converted in place
+   * @param nmemb number of values
+   * @param size size of a value in bytes, 2, 4, 8 or 16
+   * @param e bytes and words order of the values in the registers
+   */
+  void swapRegisters (uint16_t * regs, std::size_t nmemb, std::size_t size, Endian e);
+
+  /**
+   * @overload
+   *
+   * The @b src registers are converted to the @b dest array, the arrays
+   * may be the same but must not overlap otherwise. They do not need to be
+   * aligned on a register.
+   */
+  void swapRegisters (void * dest, const void * src, std::size_t nmemb,
+                      std::size_t size, Endian e);
+
+  /**
+   * @brief Converts an array of values from or to registers in the network
+   * byte order
+   *
+   * Same as swapRegisters() but the registers are stored in the network
+   * byte order (big endian), as in the PDU of a Message. The swap of the
+   * bytes of the registers and the conversion of the values are done in a
+   * single pass. With @b size equal to 2 and @b e equal to EndianBig, the
+   * function converts registers between the PDU and the host byte order.
+   *
+   * The arrays may be the same but must not overlap otherwise. They do not
+   * need to be aligned on a register, as the PDU of a Message.
+   */
+  void swapNetworkRegisters (void * dest, const void * src, std::size_t nmemb,
+                             std::size_t size, Endian e);
+}
 /* ========================================================================== */
@@ -0,0 +1,353 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitset>
+#include <algorithm>
+#include <modbuspp/bitarray.h>
+#include "config.h"
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+#endif
+
+namespace Modbus {
+
+  static_assert (sizeof (bool) == 1, "bool must be a byte !");
+
+  namespace {
+
+    inline void putBit (uint8_t * dest, std::size_t i, bool value) {
+      uint8_t m = static_cast<uint8_t> (1 << (i % 8));
+
+      if (value) {
+        dest[i / 8] |= m;
+      }
+      else {
+        dest[i / 8] &= ~m;
+      }
+    }
+
+    // -------------------------------------------------------------------------
+    // 16 bits by iteration, returns the number of bits packed
+    std::size_t packBlocks (uint8_t * dest, const uint8_t * src, std::size_t n) {
+      std::size_t i = 0;
+
+#if defined(__SSE2__)
+      const __m128i zero = _mm_setzero_si128();
+
+      for (; (i + 16) <= n; i += 16) {
+        __m128i x = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (src + i));
+        // the bit j of the mask is set if the byte j is zero
+        int m = ~_mm_movemask_epi8 (_mm_cmpeq_epi8 (x, zero));
+
+        *dest++ = static_cast<uint8_t> (m);
+        *dest++ = static_cast<uint8_t> (m >> 8);
+      }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+      static const uint8_t w[16] = {
+        1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128
+      };
+      const uint8x16_t weights = vld1q_u8 (w);
+
+      for (; (i + 16) <= n; i += 16) {
+        uint8x16_t x = vld1q_u8 (src + i);
+
+        x = vandq_u8 (vtstq_u8 (x, x), weights);
+        uint8x8_t s = vpadd_u8 (vget_low_u8 (x), vget_high_u8 (x));
+        s = vpadd_u8 (s, s);
+        s = vpadd_u8 (s, s);
+        *dest++ = vget_lane_u8 (s, 0);
+        *dest++ = vget_lane_u8 (s, 1);
+      }
+#endif
+      for (; (i + 8) <= n; i += 8) {
+        uint8_t b = 0;
+
+        for (int j = 0; j < 8; j++) {
+
+          b |= (src[i + j] != 0) << j;
+        }
+        *dest++ = b;
+      }
+      return i;
+    }
+
+    // -------------------------------------------------------------------------
+    // 16 bits by iteration, returns the number of bits unpacked
+    std::size_t unpackBlocks (uint8_t * dest, const uint8_t * src, std::size_t n) {
+      std::size_t i = 0;
+
+#if defined(__SSE2__)
+      const __m128i sel = _mm_set_epi8 (-128, 64, 32, 16, 8, 4, 2, 1,
+                                        -128, 64, 32, 16, 8, 4, 2, 1);
+      const __m128i one = _mm_set1_epi8 (1);
+
+      for (; (i + 16) <= n; i += 16, src += 2) {
+        // each byte is broadcast in 8 lanes then tested against its bit
+        __m128i x = _mm_set_epi64x (static_cast<long long> (src[1] * 0x0101010101010101ULL),
+                                    static_cast<long long> (src[0] * 0x0101010101010101ULL));
+
+        x = _mm_cmpeq_epi8 (_mm_and_si128 (x, sel), sel);
+        _mm_storeu_si128 (reinterpret_cast<__m128i *> (dest + i), _mm_and_si128 (x, one));
+      }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+      static const uint8_t w[16] = {
+        1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128
+      };
+      const uint8x16_t sel = vld1q_u8 (w);
+      const uint8x16_t one = vdupq_n_u8 (1);
+
+      for (; (i + 16) <= n; i += 16, src += 2) {
+        uint8x16_t x = vcombine_u8 (vdup_n_u8 (src[0]), vdup_n_u8 (src[1]));
+
+        vst1q_u8 (dest + i, vandq_u8 (vtstq_u8 (x, sel), one));
+      }
+#endif
+      for (; (i + 8) <= n; i += 8, src++) {
+
+        for (int j = 0; j < 8; j++) {
+
+          dest[i + j] = (*src >> j) & 1;
+        }
+      }
+      return i;
+    }
+
+    // -------------------------------------------------------------------------
+    inline uint64_t mask (std::size_t n) {
+      return n >= 64 ? ~uint64_t (0) : (uint64_t (1) << n) - 1;
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  void packBits (uint8_t * dest, std::size_t offset, const uint8_t * src, std::size_t n) {
+    std::size_t i = 0;
+
+    // leading bits up to a byte boundary
+    for (; i < n && ((offset + i) % 8) != 0; i++) {
+
+      putBit (dest, offset + i, src[i] != 0);
+    }
+    if (i < n) {
+
+      i += packBlocks (dest + (offset + i) / 8, src + i, n - i);
+    }
+    for (; i < n; i++) {
+
+      putBit (dest, offset + i, src[i] != 0);
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  void packBits (uint8_t * dest, std::size_t offset, const bool * src, std::size_t n) {
+
+    packBits (dest, offset, reinterpret_cast<const uint8_t *> (src), n);
+  }
+
+  // ---------------------------------------------------------------------------
+  void unpackBits (uint8_t * dest, const uint8_t * src, std::size_t offset, std::size_t n) {
+    std::size_t i = 0;
+
+    for (; i < n && ((offset + i) % 8) != 0; i++) {
+
+      dest[i] = (src[ (offset + i) / 8] >> ( (offset + i) % 8)) & 1;
+    }
+    if (i < n) {
+
+      i += unpackBlocks (dest + i, src + (offset + i) / 8, n - i);
+    }
+    for (; i < n; i++) {
+
+      dest[i] = (src[ (offset + i) / 8] >> ( (offset + i) % 8)) & 1;
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  void unpackBits (bool * dest, const uint8_t * src, std::size_t offset, std::size_t n) {
+
+    unpackBits (reinterpret_cast<uint8_t *> (dest), src, offset, n);
+  }
+
+  // ---------------------------------------------------------------------------
+  //
+  //                         BitArray Class
+  //
+  // ---------------------------------------------------------------------------
+
+  // ---------------------------------------------------------------------------
+  BitArray::BitArray (std::size_t n, bool value) : m_size (0) {
+
+    resize (n, value);
+  }
+
+  // ---------------------------------------------------------------------------
+  void BitArray::resize (std::size_t n, bool value) {
+    std::size_t old = m_size;
+
+    m_words.resize ( (n + 63) / 64, 0);
+    m_size = n;
+    if (n > old) {
+
+      set (old, n - old, value);
+    }
+    else if (n % 64) {
+
+      // the bits beyond the size are always cleared
+      m_words.back() &= mask (n % 64);
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  void BitArray::set (std::size_t pos, std::size_t n, bool value) {
+
+    while (n > 0) {
+      std::size_t k = std::min (n, 64 - pos % 64);
+
+      setField (pos, k, value ? ~uint64_t (0) : 0);
+      pos += k;
+      n -= k;
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  void BitArray::fill (bool value) {
+
+    std::fill (m_words.begin(), m_words.end(), value ? ~uint64_t (0) : 0);
+    if (value && (m_size % 64)) {
+
+      m_words.back() &= mask (m_size % 64);
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  std::size_t BitArray::count (std::size_t pos, std::size_t n) const {
+    std::size_t c = 0;
+
+    while (n > 0) {
+      std::size_t k = std::min (n, 64 - pos % 64);
+
+      c += std::bitset<64> (field (pos, k)).count();
+      pos += k;
+      n -= k;
+    }
+    return c;
+  }
+
+  // ---------------------------------------------------------------------------
+  void BitArray::unpack (bool * dest, std::size_t pos, std::size_t n) const {
+
+    while (n > 0) {
+      std::size_t k = std::min<std::size_t> (n, 64);
+      uint64_t v = field (pos, k);
+      uint8_t bytes[8];
+
+      for (int i = 0; i < 8; i++) {
+
+        bytes[i] = static_cast<uint8_t> (v >> (8 * i));
+      }
+      unpackBits (dest, bytes, 0, k);
+      dest += k;
+      pos += k;
+      n -= k;
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  void BitArray::assign (std::size_t pos, const bool * src, std::size_t n) {
+
+    while (n > 0) {
+      std::size_t k = std::min<std::size_t> (n, 64);
+      uint8_t bytes[8] = {0};
+      uint64_t v = 0;
+
+      packBits (bytes, 0, src, k);
+      for (int i = 0; i < 8; i++) {
+
+        v |= uint64_t (bytes[i]) << (8 * i);
+      }
+      setField (pos, k, v);
+      src += k;
+      pos += k;
+      n -= k;
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  void BitArray::toBytes (uint8_t * dest, std::size_t pos, std::size_t n) const {
+
+    while (n > 0) {
+      std::size_t k = std::min<std::size_t> (n, 64);
+      uint64_t v = field (pos, k);
+
+      for (std::size_t i = 0; i < (k + 7) / 8; i++) {
+
+        *dest++ = static_cast<uint8_t> (v >> (8 * i));
+      }
+      pos += k;
+      n -= k;
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  void BitArray::fromBytes (std::size_t pos, const uint8_t * src, std::size_t n) {
+
+    while (n > 0) {
+      std::size_t k = std::min<std::size_t> (n, 64);
+      uint64_t v = 0;
+
+      for (std::size_t i = 0; i < (k + 7) / 8; i++) {
+
+        v |= uint64_t (*src++) << (8 * i);
+      }
+      setField (pos, k, v);
+      pos += k;
+      n -= k;
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // returns the n bits (n <= 64) from the bit pos
+  uint64_t BitArray::field (std::size_t pos, std::size_t n) const {
+    std::size_t w = pos / 64;
+    std::size_t s = pos % 64;
+    uint64_t v = m_words[w] >> s;
+
+    if (s && (s + n) > 64) {
+
+      v |= m_words[w + 1] << (64 - s);
+    }
+    return v & mask (n);
+  }
+
+  // ---------------------------------------------------------------------------
+  // sets the n bits (n <= 64) from the bit pos
+  void BitArray::setField (std::size_t pos, std::size_t n, uint64_t v) {
+    std::size_t w = pos / 64;
+    std::size_t s = pos % 64;
+    uint64_t m = mask (n);
+
+    v &= m;
+    m_words[w] = (m_words[w] & ~ (m << s)) | (v << s);
+    if (s && (s + n) > 64) {
+
+      m_words[w + 1] = (m_words[w + 1] & ~ (m >> (64 - s))) | (v >> (64 - s));
+    }
+  }
+}
+
+/* ========================================================================== */
@@ -14,6 +14,12 @@
  * You should have received a copy of the GNU Lesser General Public License
  * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
  */
+#include <set>
+#include <chrono>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/eventfd.h>
+#endif
 #include "bufferedslave_p.h"
 #include "config.h"
 
@@ -48,23 +54,225 @@ namespace Modbus {
   int BufferedSlave::setBlock (Table t, int nmemb, int startAddr) {
     PIMP_D (BufferedSlave);
 
+    int rc = -1;
+
     if (startAddr < 0) {
 
       startAddr = d->pduAddressing ? 0 : 1;
     }
 
+    if (d->overlaps (t, pduAddress (startAddr), nmemb)) {
+
+      errno = EINVAL;
+      return -1;
+    }
+
+    if (d->shm.isOpen() || d->persistent.isOpen()) {
+      // the block is in the shared memory or in the persistent file
+
+      errno = EBUSY;
+      return -1;
+    }
+
     switch (t) {
       case DiscreteInput:
-        return d->setDiscreteInputBlock (startAddr, nmemb);
+        rc = d->setDiscreteInputBlock (startAddr, nmemb);
+        break;
       case Coil:
-        return d->setCoilBlock (startAddr, nmemb);
+        rc = d->setCoilBlock (startAddr, nmemb);
+        break;
       case InputRegister:
-        return d->setInputRegisterBlock (startAddr, nmemb);
+        rc = d->setInputRegisterBlock (startAddr, nmemb);
+        break;
       case HoldingRegister:
-        return d->setHoldingRegisterBlock (startAddr, nmemb);
+        rc = d->setHoldingRegisterBlock (startAddr, nmemb);
+        break;
+      default:
+        errno = EINVAL;
+        return -1;
     }
-    errno = EINVAL;
-    return -1;
+    d->updateIndex (t);
+    return rc;
+  }
+
+  // ---------------------------------------------------------------------------
+  int BufferedSlave::addBlock (Table t, int nmemb, int startAddr) {
+    PIMP_D (BufferedSlave);
+
+    if (d->shm.isOpen() || d->persistent.isOpen()) {
+      // the block would not be in the shared memory or in the persistent file
+
+      errno = EBUSY;
+      return -1;
+    }
+    return d->addBlock (t, pduAddress (startAddr), nmemb);
+  }
+
+  // ---------------------------------------------------------------------------
+  bool BufferedSlave::removeBlock (Table t, int startAddr) {
+    PIMP_D (BufferedSlave);
+
+    if (d->persistent.isOpen()) {
+
+      errno = EBUSY;
+      return false;
+    }
+    return d->removeBlock (t, pduAddress (startAddr)) == 0;
+  }
+
+  // ---------------------------------------------------------------------------
+  int BufferedSlave::blockCount (Table t) const {
+    PIMP_D (const BufferedSlave);
+
+    switch (t) {
+      case DiscreteInput:
+      case Coil:
+      case InputRegister:
+      case HoldingRegister:
+        return d->blocks[t].index.size();
+      default:
+        break;
+    }
+    return 0;
+  }
+
+  // ---------------------------------------------------------------------------
+  int BufferedSlave::addFile (int file, int records, const std::string & path) {
+    PIMP_D (BufferedSlave);
+    std::lock_guard<std::mutex> lock (d->filesMutex);
+
+    if (file < 1 || file > 0xFFFF) {
+
+      errno = EINVAL;
+      return -1;
+    }
+    if (d->files.count (file) > 0) {
+
+      errno = EEXIST;
+      return -1;
+    }
+
+    std::shared_ptr<RecordFile> f = std::make_shared<RecordFile>();
+    if (!f->open (records, path)) {
+
+      return -1;
+    }
+    d->files[file] = f;
+    return records;
+  }
+
+  // ---------------------------------------------------------------------------
+  bool BufferedSlave::removeFile (int file) {
+    PIMP_D (BufferedSlave);
+    std::lock_guard<std::mutex> lock (d->filesMutex);
+
+    return d->files.erase (file) > 0;
+  }
+
+  // ---------------------------------------------------------------------------
+  int BufferedSlave::fileSize (int file) const {
+    PIMP_D (const BufferedSlave);
+    std::lock_guard<std::mutex> lock (d->filesMutex);
+    auto it = d->files.find (file);
+
+    return (it != d->files.end()) ? it->second->size() : -1;
+  }
+
+  // ---------------------------------------------------------------------------
+  bool BufferedSlave::attachSharedMemory (const std::string & name) {
+    PIMP_D (BufferedSlave);
+
+    return d->attach (name);
+  }
+
+  // ---------------------------------------------------------------------------
+  void BufferedSlave::detachSharedMemory() {
+    PIMP_D (BufferedSlave);
+
+    d->detach();
+  }
+
+  // ---------------------------------------------------------------------------
+  bool BufferedSlave::isSharedMemoryAttached() const {
+    PIMP_D (const BufferedSlave);
+
+    return d->shm.isOpen();
+  }
+
+  // ---------------------------------------------------------------------------
+  int BufferedSlave::setPersistentFile (const std::string & path,
+                                        int flushInterval, bool flushOnWrite) {
+    PIMP_D (BufferedSlave);
+
+    d->closePersistentFile();
+    d->flushInterval = std::chrono::milliseconds (std::max (flushInterval, 0));
+    d->flushOnWrite = flushOnWrite;
+    return d->openPersistentFile (path);
+  }
+
+  // ---------------------------------------------------------------------------
+  void BufferedSlave::closePersistentFile() {
+    PIMP_D (BufferedSlave);
+
+    d->closePersistentFile();
+  }
+
+  // ---------------------------------------------------------------------------
+  bool BufferedSlave::isPersistent() const {
+    PIMP_D (const BufferedSlave);
+
+    return d->persistent.isOpen();
+  }
+
+  // ---------------------------------------------------------------------------
+  bool BufferedSlave::syncPersistentFile() {
+    PIMP_D (BufferedSlave);
+
+    return d->flush();
+  }
+
+  // ---------------------------------------------------------------------------
+  void BufferedSlave::setMaxAge (int maxAge, bool staleWhileRevalidate) {
+    PIMP_D (BufferedSlave);
+    std::lock_guard<std::mutex> lock (d->cacheMutex);
+
+    d->maxAge = std::chrono::milliseconds (std::max (maxAge, 0));
+    d->staleWhileRevalidate = staleWhileRevalidate;
+  }
+
+  // ---------------------------------------------------------------------------
+  int BufferedSlave::maxAge() const {
+    PIMP_D (const BufferedSlave);
+
+    return d->maxAge.count();
+  }
+
+  // ---------------------------------------------------------------------------
+  void BufferedSlave::invalidate() {
+    PIMP_D (BufferedSlave);
+    std::lock_guard<std::mutex> lock (d->cacheMutex);
+
+    for (auto & f : d->freshness) {
+
+      for (auto & b : f) {
+
+        b.time = std::chrono::steady_clock::time_point();
+      }
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  void BufferedSlave::beginUpdate() {
+    PIMP_D (BufferedSlave);
+
+    d->seqlock.lock();
+  }
+
+  // ---------------------------------------------------------------------------
+  void BufferedSlave::endUpdate() {
+    PIMP_D (BufferedSlave);
+
+    d->seqlock.unlock();
   }
 
   // ---------------------------------------------------------------------------
@@ -85,12 +293,193 @@ namespace Modbus {
     return d->afterReplyCB;
   }
 
+  // ---------------------------------------------------------------------------
+  void BufferedSlave::setFunctionHandler (int function, FunctionHandler handler) {
+    PIMP_D (BufferedSlave);
+
+    // the server reads the handlers without lock
+    if (d->server && d->server->isOpen()) {
+
+      throw std::logic_error ("Unable to set a function handler when open !");
+    }
+    if (d->handlers.empty()) {
+
+      d->handlers.resize (256);
+    }
+    d->handlers[function & 0xFF] = handler;
+  }
+
+  // ---------------------------------------------------------------------------
+  BufferedSlave::FunctionHandler BufferedSlave::functionHandler (int function) const {
+    PIMP_D (const BufferedSlave);
+    const FunctionHandler * h = d->handler (function);
+
+    return h ? *h : FunctionHandler();
+  }
+
   // ---------------------------------------------------------------------------
   void BufferedSlave::setAfterReplyCallback (Message::Callback cb) {
     PIMP_D (BufferedSlave);
     d->afterReplyCB = cb;
   }
 
+  // ---------------------------------------------------------------------------
+  bool BufferedSlave::subscribe (std::shared_ptr<Subscription> s) {
+    PIMP_D (BufferedSlave);
+
+    if (s && d->isTable (s->table())) {
+      std::lock_guard<std::mutex> lock (d->subscriptionsMutex);
+      const uint16_t * image = d->subscriptionImage (s->table(),
+                               pduAddress (s->address()), s->size());
+
+      if (image) {
+
+        s->reset (image);
+        d->subscriptions.push_back (s);
+        return true;
+      }
+    }
+    errno = EINVAL;
+    return false;
+  }
+
+  // ---------------------------------------------------------------------------
+  bool BufferedSlave::unsubscribe (const std::shared_ptr<Subscription> & s) {
+    PIMP_D (BufferedSlave);
+    std::lock_guard<std::mutex> lock (d->subscriptionsMutex);
+
+    auto it = std::find (d->subscriptions.begin(), d->subscriptions.end(), s);
+    if (it != d->subscriptions.end()) {
+
+      d->subscriptions.erase (it);
+      return true;
+    }
+    return false;
+  }
+
+  // ---------------------------------------------------------------------------
+  int BufferedSlave::checkSubscriptions (Table t) {
+    PIMP_D (BufferedSlave);
+
+    return d->notify (t, 0, 0x10000);
+  }
+
+  // ---------------------------------------------------------------------------
+  std::vector<BufferedSlave::Range> BufferedSlave::changes (Table t) {
+    PIMP_D (BufferedSlave);
+    std::vector<Range> ranges;
+
+    if (t == Coil || t == HoldingRegister) {
+      std::lock_guard<std::mutex> lock (d->changesMutex);
+      std::vector<uint64_t> & bits = d->dirty[t];
+      Range r = { -1, 0 };
+
+      if (d->pending[t]) {
+
+        for (size_t w = 0; w < bits.size(); w++) {
+
+          if (bits[w]) {
+
+            for (int b = 0; b < 64; b++) {
+
+              if (bits[w] & (1ULL << b)) {
+                int addr = w * 64 + b;
+
+                if (r.size > 0 && pduAddress (r.address) + r.size == addr) {
+
+                  r.size++;
+                }
+                else {
+
+                  if (r.size > 0) {
+                    ranges.push_back (r);
+                  }
+                  r.address = dataAddress (addr);
+                  r.size = 1;
+                }
+              }
+            }
+            bits[w] = 0;
+          }
+        }
+        if (r.size > 0) {
+          ranges.push_back (r);
+        }
+        d->pending[t] = false;
+      }
+
+#ifdef __linux__
+      if (d->changesFd >= 0 && !d->pending[Coil] && !d->pending[HoldingRegister]) {
+        uint64_t n;
+
+        // no more changes, resets the event
+        if (::read (d->changesFd, &n, sizeof (n)) < 0) {
+          // EAGAIN, already reset
+        }
+      }
+#endif
+    }
+    return ranges;
+  }
+
+  // ---------------------------------------------------------------------------
+  bool BufferedSlave::hasChanges (Table t) const {
+    PIMP_D (const BufferedSlave);
+
+    if (t == Coil || t == HoldingRegister) {
+      std::lock_guard<std::mutex> lock (d->changesMutex);
+
+      return d->pending[t];
+    }
+    return false;
+  }
+
+  // ---------------------------------------------------------------------------
+  bool BufferedSlave::waitForChanges (int timeout) {
+    PIMP_D (BufferedSlave);
+    std::unique_lock<std::mutex> lock (d->changesMutex);
+    auto changed = [d] {
+      return d->pending[Coil] || d->pending[HoldingRegister];
+    };
+
+    if (timeout < 0) {
+
+      d->changesCond.wait (lock, changed);
+      return true;
+    }
+    return d->changesCond.wait_for (lock, std::chrono::milliseconds (timeout),
+                                    changed);
+  }
+
+  // ---------------------------------------------------------------------------
+  int BufferedSlave::changesDescriptor() {
+#ifdef __linux__
+    PIMP_D (BufferedSlave);
+    std::lock_guard<std::mutex> lock (d->changesMutex);
+
+    if (d->changesFd < 0) {
+
+      d->changesFd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+      if (d->changesFd >= 0 && (d->pending[Coil] || d->pending[HoldingRegister])) {
+
+        d->signal();
+      }
+    }
+    return d->changesFd;
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+  }
+
+  // ---------------------------------------------------------------------------
+  // returns the registers of the block t, addr is a data address
+  uint16_t * BufferedSlave::registers (Table t, int addr, int nb) {
+    PIMP_D (BufferedSlave);
+
+    return d->registers (t, pduAddress (addr), nb);
+  }
+
   // ---------------------------------------------------------------------------
   int BufferedSlave::readFromDevice (const Request * req) {
 
@@ -98,53 +487,80 @@ namespace Modbus {
       PIMP_D (BufferedSlave);
 
       if (isOpen()) {
-        int offset;
         int start = req->startingAddress();
         int nb = req->quantity();
 
+        // the addresses out of the blocks are not read, the reply will be an
+        // illegal data address exception
         switch (req->function()) {
 
           case ReadCoils: {
-            start = std::max (start, d->map->start_bits);
-            start = std::min (start, d->map->start_bits + d->map->nb_bits - 1);
-            offset = start - d->map->start_bits;
-            nb = std::min (nb, (d->map->nb_bits - offset));
-            bool * dest = reinterpret_cast <bool *> (&d->map->tab_bits[offset]);
+            if (d->isCached()) {
+
+              return d->fetch (Coil, start, nb);
+            }
+            uint8_t * dest = d->findBits (Coil, start, nb);
+
+            if (dest) {
+              std::vector<uint8_t> buf (nb);
+              int rc = Slave::readCoils (dataAddress (start),
+                                         reinterpret_cast <bool *> (buf.data()), nb);
 
-            return Slave::readCoils (start + pduAddressing() ? 0 : 1, dest, nb);
+              d->copy (dest, buf.data(), rc);
+              return rc;
+            }
           }
           break;
 
           case ReadDiscreteInputs: {
-            start = std::max (start, d->map->start_input_bits);
-            start = std::min (start, d->map->start_input_bits + d->map->nb_input_bits - 1);
-            offset = start - d->map->start_input_bits;
-            nb = std::min (nb, (d->map->nb_input_bits - offset));
-            bool * dest = reinterpret_cast <bool *> (&d->map->tab_input_bits[offset]);
+            if (d->isCached()) {
+
+              return d->fetch (DiscreteInput, start, nb);
+            }
+            uint8_t * dest = d->findBits (DiscreteInput, start, nb);
+
+            if (dest) {
+              std::vector<uint8_t> buf (nb);
+              int rc = Slave::readDiscreteInputs (dataAddress (start),
+                                           reinterpret_cast <bool *> (buf.data()), nb);
 
-            return Slave::readDiscreteInputs (start + pduAddressing() ? 0 : 1, dest, nb);
+              d->copy (dest, buf.data(), rc);
+              return rc;
+            }
           }
           break;
 
           case ReadHoldingRegisters: {
-            start = std::max (start, d->map->start_registers);
-            start = std::min (start, d->map->start_registers + d->map->nb_registers - 1);
-            offset = start - d->map->start_registers;
-            nb = std::min (nb, (d->map->nb_registers - offset));
-            uint16_t * dest = &d->map->tab_registers[offset];
+            if (d->isCached()) {
+
+              return d->fetch (HoldingRegister, start, nb);
+            }
+            uint16_t * dest = d->findRegisters (HoldingRegister, start, nb);
+
+            if (dest) {
+              std::vector<uint16_t> buf (nb);
+              int rc = Slave::readRegisters (dataAddress (start), buf.data(), nb);
 
-            return Slave::readRegisters (start + pduAddressing() ? 0 : 1, dest, nb);
+              d->copy (dest, buf.data(), rc);
+              return rc;
+            }
           }
           break;
 
           case ReadInputRegisters: {
-            start = std::max (start, d->map->start_input_registers);
-            start = std::min (start, d->map->start_input_registers + d->map->nb_input_registers - 1);
-            offset = start - d->map->start_input_registers;
-            nb = std::min (nb, (d->map->nb_input_registers - offset));
-            uint16_t * dest = &d->map->tab_input_registers[offset];
+            if (d->isCached()) {
+
+              return d->fetch (InputRegister, start, nb);
+            }
+            uint16_t * dest = d->findRegisters (InputRegister, start, nb);
+
+            if (dest) {
+              std::vector<uint16_t> buf (nb);
+              int rc = Slave::readInputRegisters (dataAddress (start), buf.data(), nb);
 
-            return Slave::readInputRegisters (start + pduAddressing() ? 0 : 1, dest, nb);
+              d->copy (dest, buf.data(), rc);
+              return rc;
+            }
           }
           break;
 
@@ -160,9 +576,53 @@ namespace Modbus {
           }
           break;
 
-          case ReadWriteMultipleRegisters:
-            // TODO
-            break;
+          case ReadFileRecord: {
+            std::vector<FileRecordFormat::SubRequest> subs;
+            int n = 0;
+
+            // the records out of the files are not read, the reply will be
+            // an exception
+            if (FileRecordFormat::parse (*req, subs) != 0) {
+              break;
+            }
+            for (const auto & s : subs) {
+
+              if (fileSize (s.file) >= (s.record + s.count)) {
+                std::vector<uint16_t> buf (s.count);
+                int rc = readFileRecord (s.file, s.record, buf.data(), s.count);
+
+                if (rc < 0) {
+                  return rc;
+                }
+                n += rc;
+              }
+            }
+            return n;
+          }
+          break;
+
+          case ReadWriteMultipleRegisters: {
+            // written then read by the device in a single transaction, the
+            // map is written with the same values by the reply
+            int waddr = req->writeAddress();
+            int wnb = req->writeQuantity();
+            int n = nb;
+            uint16_t * dest = d->findRegisters (HoldingRegister, start, n);
+            int wn = wnb;
+
+            if (dest && n == nb && d->findRegisters (HoldingRegister, waddr, wn) && wn == wnb) {
+              std::vector<uint16_t> src (wnb);
+              std::vector<uint16_t> buf (nb);
+
+              req->writeRegisterValues (0, wnb, src.data());
+              int rc = Slave::writeReadRegisters (dataAddress (waddr), src.data(), wnb,
+                                                  dataAddress (start), buf.data(), nb);
+
+              d->copy (dest, buf.data(), rc);
+              return rc;
+            }
+          }
+          break;
 
           default:
             break;
@@ -186,67 +646,132 @@ namespace Modbus {
     if (req) {
       PIMP_D (BufferedSlave);
 
+      // the data have just been written by a client
+      switch (req->function()) {
+        case WriteSingleCoil:
+          d->written (Coil, req->startingAddress(), 1);
+          break;
+        case WriteMultipleCoils:
+          d->written (Coil, req->startingAddress(), req->quantity());
+          break;
+        case WriteSingleRegister:
+        case MaskWriteRegister:
+          d->written (HoldingRegister, req->startingAddress(), 1);
+          break;
+        case WriteMultipleRegisters:
+          d->written (HoldingRegister, req->startingAddress(), req->quantity());
+          break;
+        case ReadWriteMultipleRegisters:
+          d->written (HoldingRegister, req->writeAddress(), req->writeQuantity());
+          break;
+        default:
+          break;
+      }
+
       if (isOpen()) {
-        int offset;
         int start = req->startingAddress();
         int nb = req->quantity();
 
         switch (req->function()) {
 
           case WriteSingleCoil: {
-            start = std::max (start, d->map->start_bits);
-            start = std::min (start, d->map->start_bits + d->map->nb_bits - 1);
-            offset = start - d->map->start_bits;
+            const uint8_t * src = d->findBits (Coil, start, nb = 1);
 
-            return Slave::writeCoil (start + pduAddressing() ? 0 : 1, d->map->tab_bits[offset] != 0);
+            if (src) {
+              return Slave::writeCoil (dataAddress (start), src[0] != 0);
+            }
           }
           break;
 
           case WriteMultipleCoils: {
-            start = std::max (start, d->map->start_bits);
-            start = std::min (start, d->map->start_bits + d->map->nb_bits - 1);
-            offset = start - d->map->start_bits;
-            nb = std::min (nb, (d->map->nb_bits - offset));
-            bool * src = reinterpret_cast <bool *> (&d->map->tab_bits[offset]);
+            bool * src = reinterpret_cast <bool *> (d->findBits (Coil, start, nb));
 
-            return Slave::writeCoils (start + pduAddressing() ? 0 : 1, src, nb);
+            if (src) {
+              return Slave::writeCoils (dataAddress (start), src, nb);
+            }
           }
           break;
 
           case WriteSingleRegister: {
-            start = std::max (start, d->map->start_registers);
-            start = std::min (start, d->map->start_registers + d->map->nb_registers - 1);
-            offset = start - d->map->start_registers;
+            const uint16_t * src = d->findRegisters (HoldingRegister, start, nb = 1);
 
-            return Slave::writeRegister (start + pduAddressing() ? 0 : 1, d->map->tab_registers[offset]);
+            if (src) {
+              return Slave::writeRegister (dataAddress (start), src[0]);
+            }
           }
           break;
 
           case WriteMultipleRegisters: {
-            start = std::max (start, d->map->start_registers);
-            start = std::min (start, d->map->start_registers + d->map->nb_registers - 1);
-            offset = start - d->map->start_registers;
-            nb = std::min (nb, (d->map->nb_registers - offset));
-            uint16_t * src = &d->map->tab_registers[offset];
+            uint16_t * src = d->findRegisters (HoldingRegister, start, nb);
 
-            return Slave::writeRegisters (start + pduAddressing() ? 0 : 1, src, nb);
+            if (src) {
+              return Slave::writeRegisters (dataAddress (start), src, nb);
+            }
           }
           break;
 
-          case ReadWriteMultipleRegisters:
-            // TODO
-            break;
+          case MaskWriteRegister: {
+            // the masks are forwarded, the device modifies its register
+            // without read-modify-write
+            if (d->findRegisters (HoldingRegister, start, nb = 1)) {
 
-          default:
-            break;
-        }
-      }
+              return Slave::maskWriteRegister (dataAddress (start),
+                                               req->andMask(), req->orMask());
+            }
+          }
+          break;
+
+          case WriteFileRecord: {
+            std::vector<FileRecordFormat::SubRequest> subs;
+            int n = 0;
+
+            if (FileRecordFormat::parse (*req, subs) != 0) {
+              break;
+            }
+            // nothing was written if a sub-request was out of the files
+            for (const auto & s : subs) {
+
+              if (fileSize (s.file) < (s.record + s.count)) {
+                return 0;
+              }
+            }
+            for (const auto & s : subs) {
+              std::vector<uint16_t> buf (s.count);
+              int rc;
+
+              for (int k = 0; k < s.count; k++) {
+
+                buf[k] = req->word (s.values + k * 2);
+              }
+              rc = Slave::writeFileRecord (s.file, s.record, buf.data(), s.count);
+              if (rc < 0) {
+                return rc;
+              }
+              n += rc;
+            }
+            return n;
+          }
+          break;
+
+          case ReadWriteMultipleRegisters:
+            // already written by readFromDevice() with the read
+            break;
+
+          default:
+            break;
+        }
+      }
       return 0;
     }
     errno = EINVAL;
     return -1;
   }
 
+  // ---------------------------------------------------------------------------
+  int BufferedSlave::writeToDevice (const Request & req) {
+
+    return writeToDevice (&req);
+  }
 
   // ---------------------------------------------------------------------------
   // overload
@@ -254,22 +779,40 @@ namespace Modbus {
     PIMP_D (BufferedSlave);
 
     int pduAddr = pduAddress (addr);
+    uint8_t * src = d->findBits (Coil, pduAddr, nb);
 
-    if ( (pduAddr >= d->map->start_bits) &&
-         (pduAddr < (d->map->start_bits + d->map->nb_bits))) {
-      int offset = pduAddr - d->map->start_bits;
-      uint8_t * src = &d->map->tab_bits[offset];
+    if (src) {
+
+      if (isOpen() && !d->isCached()) {
+        int rc = Slave::readCoils (addr, dest, nb);
+        if (rc < 0) {
 
-      nb = std::min (nb, (d->map->nb_bits - offset));
+          return rc;
+        }
+        if (static_cast<void *> (src) != dest) {
 
+          d->seqlock.lock();
+          memcpy (src, dest, nb * sizeof (dest[0]));
+          d->seqlock.unlock();
+        }
+        d->notify (Coil, pduAddr, nb);
+        return nb;
+      }
       if (isOpen()) {
-        int rc = Slave::readCoils (addr, (bool *) src, nb);
+        // read from the device if the block is stale
+        int rc = d->fetch (Coil, pduAddr, nb);
+
         if (rc < 0) {
 
           return rc;
         }
       }
-      memcpy (dest, src, nb * sizeof (dest[0]));
+      if (static_cast<void *> (src) != dest) {
+
+        d->seqlock.read ([ = ] {
+          memcpy (dest, src, nb * sizeof (dest[0]));
+        });
+      }
       return nb;
     }
     errno = EINVAL;
@@ -282,22 +825,40 @@ namespace Modbus {
     PIMP_D (BufferedSlave);
 
     int pduAddr = pduAddress (addr);
+    uint8_t * src = d->findBits (DiscreteInput, pduAddr, nb);
 
-    if ( (pduAddr >= d->map->start_input_bits) &&
-         (pduAddr < (d->map->start_input_bits + d->map->nb_input_bits))) {
-      int offset = pduAddr - d->map->start_input_bits;
-      uint8_t * src = &d->map->tab_input_bits[offset];
+    if (src) {
 
-      nb = std::min (nb, (d->map->nb_input_bits - offset));
+      if (isOpen() && !d->isCached()) {
+        int rc = Slave::readDiscreteInputs (addr, dest, nb);
+        if (rc < 0) {
+
+          return rc;
+        }
+        if (static_cast<void *> (src) != dest) {
 
+          d->seqlock.lock();
+          memcpy (src, dest, nb * sizeof (dest[0]));
+          d->seqlock.unlock();
+        }
+        d->notify (DiscreteInput, pduAddr, nb);
+        return nb;
+      }
       if (isOpen()) {
-        int rc = Slave::readDiscreteInputs (addr, (bool *) src, nb);
+        // read from the device if the block is stale
+        int rc = d->fetch (DiscreteInput, pduAddr, nb);
+
         if (rc < 0) {
 
           return rc;
         }
       }
-      memcpy (dest, src, nb * sizeof (dest[0]));
+      if (static_cast<void *> (src) != dest) {
+
+        d->seqlock.read ([ = ] {
+          memcpy (dest, src, nb * sizeof (dest[0]));
+        });
+      }
       return nb;
 
     }
@@ -311,22 +872,40 @@ namespace Modbus {
     PIMP_D (BufferedSlave);
 
     int pduAddr = pduAddress (addr);
+    uint16_t * src = d->findRegisters (HoldingRegister, pduAddr, nb);
 
-    if ( (pduAddr >= d->map->start_registers) &&
-         (pduAddr < (d->map->start_registers + d->map->nb_registers))) {
-      int offset = pduAddr - d->map->start_registers;
-      uint16_t * src = &d->map->tab_registers[offset];
+    if (src) {
+
+      if (isOpen() && !d->isCached()) {
+        int rc = Slave::readRegisters (addr, dest, nb);
+        if (rc < 0) {
 
-      nb = std::min (nb, (d->map->nb_registers - offset));
+          return rc;
+        }
+        if (src != dest) {
 
+          d->seqlock.lock();
+          memcpy (src, dest, nb * sizeof (dest[0]));
+          d->seqlock.unlock();
+        }
+        d->notify (HoldingRegister, pduAddr, nb);
+        return nb;
+      }
       if (isOpen()) {
-        int rc = Slave::readRegisters (addr, src, nb);
+        // read from the device if the block is stale
+        int rc = d->fetch (HoldingRegister, pduAddr, nb);
+
         if (rc < 0) {
 
           return rc;
         }
       }
-      memcpy (dest, src, nb * sizeof (dest[0]));
+      if (src != dest) {
+
+        d->seqlock.read ([ = ] {
+          memcpy (dest, src, nb * sizeof (dest[0]));
+        });
+      }
       return nb;
     }
     errno = EINVAL;
@@ -339,23 +918,40 @@ namespace Modbus {
     PIMP_D (BufferedSlave);
 
     int pduAddr = pduAddress (addr);
+    uint16_t * src = d->findRegisters (InputRegister, pduAddr, nb);
 
-    if ( (pduAddr >= d->map->start_input_registers) &&
-         (pduAddr < (d->map->start_input_registers + d->map->nb_input_registers))) {
-      int offset = pduAddr - d->map->start_input_registers;
-      uint16_t * src = &d->map->tab_input_registers[offset];
+    if (src) {
 
-      nb = std::min (nb, (d->map->nb_input_registers - offset));
+      if (isOpen() && !d->isCached()) {
+        int rc = Slave::readInputRegisters (addr, dest, nb);
+        if (rc < 0) {
+
+          return rc;
+        }
+        if (src != dest) {
 
+          d->seqlock.lock();
+          memcpy (src, dest, nb * sizeof (dest[0]));
+          d->seqlock.unlock();
+        }
+        d->notify (InputRegister, pduAddr, nb);
+        return nb;
+      }
       if (isOpen()) {
-        int rc = Slave::readInputRegisters (addr, src, nb);
+        // read from the device if the block is stale
+        int rc = d->fetch (InputRegister, pduAddr, nb);
+
         if (rc < 0) {
 
           return rc;
         }
       }
+      if (src != dest) {
 
-      memcpy (dest, src, nb * sizeof (dest[0]));
+        d->seqlock.read ([ = ] {
+          memcpy (dest, src, nb * sizeof (dest[0]));
+        });
+      }
       return nb;
     }
     errno = EINVAL;
@@ -368,375 +964,1714 @@ namespace Modbus {
     PIMP_D (BufferedSlave);
 
     int pduAddr = pduAddress (addr);
+    uint8_t * dest = d->findBits (Coil, pduAddr, nb);
 
-    if ( (pduAddr >= d->map->start_bits) &&
-         (pduAddr < (d->map->start_bits + d->map->nb_bits)))  {
-      int offset = pduAddr - d->map->start_bits;
-      uint8_t * dest = &d->map->tab_bits[offset];
-
-      nb = std::min (nb, (d->map->nb_bits - offset));
+    if (dest)  {
 
+      d->seqlock.lock();
       memcpy (dest, src, nb * sizeof (dest[0]));
+      d->seqlock.unlock();
+      d->notify (Coil, pduAddr, nb);
       if (isOpen()) {
 
         if (nb == 1) {
 
-          return Slave::writeCoil (addr, dest[0] != 0);
+          return Slave::writeCoil (addr, src[0]);
+        }
+        else {
+
+          return  Slave::writeCoils (addr, src, nb);
+        }
+      }
+
+      return nb;
+    }
+    errno = EINVAL;
+    return -1;
+  }
+
+  // ---------------------------------------------------------------------------
+  // overload
+  int BufferedSlave::writeCoil (int addr, bool value) {
+
+    return writeCoils (addr, &value, 1);
+  }
+
+  // ---------------------------------------------------------------------------
+  // overload
+  int BufferedSlave::writeRegisters (int addr, const uint16_t * src, int nb) {
+    PIMP_D (BufferedSlave);
+
+    int pduAddr = pduAddress (addr);
+    uint16_t * dest = d->findRegisters (HoldingRegister, pduAddr, nb);
+
+    if (dest)  {
+
+      d->seqlock.lock();
+      memcpy (dest, src, nb * sizeof (dest[0]));
+      d->seqlock.unlock();
+      d->notify (HoldingRegister, pduAddr, nb);
+      if (isOpen()) {
+        if (nb == 1) {
+
+          return Slave::writeRegister (addr, src[0]);
         }
         else {
 
-          return  Slave::writeCoils (addr, (bool *) dest, nb);
+          return  Slave::writeRegisters (addr, src, nb);
+        }
+      }
+      return nb;
+    }
+    errno = EINVAL;
+    return -1;
+  }
+
+  // ---------------------------------------------------------------------------
+  // overload
+  int BufferedSlave::writeRegister (int addr, uint16_t value) {
+
+    return writeRegisters (addr, &value, 1);
+  }
+
+  // ---------------------------------------------------------------------------
+  // overload
+  int BufferedSlave::writeReadRegisters (int write_addr, const uint16_t * write_src, int write_nb,
+                                         int read_addr, uint16_t * read_dest, int read_nb) {
+    PIMP_D (BufferedSlave);
+
+    int pduReadAddr = pduAddress (read_addr);
+    int pduWriteAddr = pduAddress (write_addr);
+    uint16_t * destRead = d->findRegisters (HoldingRegister, pduReadAddr, read_nb);
+    uint16_t * srcWrite = d->findRegisters (HoldingRegister, pduWriteAddr, write_nb);
+
+    if (destRead && srcWrite)  {
+
+      d->seqlock.lock();
+      memcpy (srcWrite, write_src, write_nb * sizeof (srcWrite[0]));
+      d->seqlock.unlock();
+      if (isOpen()) {
+
+        read_nb =  Slave::writeReadRegisters (write_addr, write_src, write_nb,
+                                              read_addr, read_dest, read_nb);
+        if (read_nb > 0) {
+
+          d->seqlock.lock();
+          memcpy (destRead, read_dest, read_nb * sizeof (srcWrite[0]));
+          d->seqlock.unlock();
+        }
+      }
+      else {
+
+        d->seqlock.read ([ = ] {
+          memcpy (read_dest, destRead, read_nb * sizeof (srcWrite[0]));
+        });
+      }
+
+      d->notify (HoldingRegister, pduWriteAddr, write_nb);
+      if (read_nb >= 0) {
+
+        d->notify (HoldingRegister, pduReadAddr, read_nb);
+      }
+      return read_nb;
+
+    }
+    errno = EINVAL;
+    return -1;
+  }
+
+  // ---------------------------------------------------------------------------
+  // overload
+  int BufferedSlave::maskWriteRegister (int addr, uint16_t andMask, uint16_t orMask) {
+    PIMP_D (BufferedSlave);
+
+    int pduAddr = pduAddress (addr);
+    int nb = 1;
+    uint16_t * dest = d->findRegisters (HoldingRegister, pduAddr, nb);
+
+    if (dest)  {
+
+      // same algorithm as the device, the readers see the old or the new value
+      d->seqlock.lock();
+      dest[0] = (dest[0] & andMask) | (orMask & ~andMask);
+      d->seqlock.unlock();
+      d->notify (HoldingRegister, pduAddr, 1);
+      if (isOpen()) {
+
+        return Slave::maskWriteRegister (addr, andMask, orMask);
+      }
+      return 1;
+    }
+    errno = EINVAL;
+    return -1;
+  }
+
+  // ---------------------------------------------------------------------------
+  // overload
+  int BufferedSlave::readFileRecord (int file, int record, uint16_t * dest, int nb) {
+    PIMP_D (BufferedSlave);
+    std::unique_lock<std::mutex> lock (d->filesMutex);
+    RecordFile * f = d->findFile (file, record, nb);
+
+    if (f) {
+
+      if (isOpen()) {
+
+        // the server is not blocked during the transfer
+        lock.unlock();
+        nb = Slave::readFileRecord (file, record, dest, nb);
+        if (nb > 0) {
+
+          lock.lock();
+          f = d->findFile (file, record, nb);
+          if (f) {
+
+            memcpy (f->data() + record, dest, nb * sizeof (dest[0]));
+          }
+        }
+        return nb;
+      }
+      memcpy (dest, f->data() + record, nb * sizeof (dest[0]));
+      return nb;
+    }
+    errno = EINVAL;
+    return -1;
+  }
+
+  // ---------------------------------------------------------------------------
+  // overload
+  int BufferedSlave::writeFileRecord (int file, int record, const uint16_t * src, int nb) {
+    PIMP_D (BufferedSlave);
+    std::unique_lock<std::mutex> lock (d->filesMutex);
+    RecordFile * f = d->findFile (file, record, nb);
+
+    if (f) {
+
+      memcpy (f->data() + record, src, nb * sizeof (src[0]));
+      lock.unlock();
+      if (isOpen()) {
+
+        return Slave::writeFileRecord (file, record, src, nb);
+      }
+      return nb;
+    }
+    errno = EINVAL;
+    return -1;
+  }
+
+  // ---------------------------------------------------------------------------
+  // overload
+  int BufferedSlave::reportSlaveId (uint16_t max_dest, uint8_t * dest) {
+    PIMP_D (BufferedSlave);
+
+    if (isOpen()) {
+
+      d->idReport.resize (MaxPduLength, 0);
+
+      int rc = Slave::reportSlaveId (d->idReport.size(), d->idReport.data());
+      if (rc < 0) {
+
+        return rc;
+      }
+      d->idReport.resize (rc);
+    }
+    max_dest = std::min (max_dest, static_cast<uint16_t> (d->idReport.size()));
+    memcpy (dest, d->idReport.data(), max_dest);
+    return max_dest;
+  }
+
+// ---------------------------------------------------------------------------
+  int BufferedSlave::writeDiscreteInputs (int addr, const bool * src, int nb) {
+    PIMP_D (BufferedSlave);
+
+    addr = pduAddress (addr);
+    uint8_t * dest = d->findBits (DiscreteInput, addr, nb);
+
+    if (dest)  {
+
+      d->seqlock.lock();
+      memcpy (dest, src, nb * sizeof (dest[0]));
+      d->seqlock.unlock();
+      d->notify (DiscreteInput, addr, nb);
+      return nb;
+    }
+    errno = EINVAL;
+    return -1;
+  }
+
+  // ---------------------------------------------------------------------------
+  int BufferedSlave::writeDiscreteInput (int addr, bool value) {
+
+    return writeDiscreteInputs (addr, &value, 1);
+  }
+
+  // ---------------------------------------------------------------------------
+  int BufferedSlave::writeInputRegisters (int addr, const uint16_t * src, int nb) {
+    PIMP_D (BufferedSlave);
+
+    addr = pduAddress (addr);
+    uint16_t * dest = d->findRegisters (InputRegister, addr, nb);
+
+    if (dest)  {
+
+      d->seqlock.lock();
+      memcpy (dest, src, nb * sizeof (dest[0]));
+      d->seqlock.unlock();
+      d->notify (InputRegister, addr, nb);
+      return nb;
+    }
+    errno = EINVAL;
+    return -1;
+  }
+
+  // ---------------------------------------------------------------------------
+  int BufferedSlave::writeInputRegister (int addr, uint16_t value) {
+
+    return writeInputRegisters (addr, &value, 1);
+  }
+
+  // ---------------------------------------------------------------------------
+  int BufferedSlave::updateSlaveFromBlock (Table t) {
+    PIMP_D (BufferedSlave);
+
+    switch (t) {
+      case Coil:
+      case HoldingRegister:
+        return d->updateSlaveFromBlock (t);
+      default:
+        break;
+    }
+    errno = EINVAL;
+    return -1;
+  }
+
+  // ---------------------------------------------------------------------------
+  bool BufferedSlave::updateSlaveFromBlock () {
+
+    return updateSlaveFromBlock (Coil) >= 0 &&
+           updateSlaveFromBlock (HoldingRegister) >= 0;
+  }
+
+  // ---------------------------------------------------------------------------
+  int BufferedSlave::updateBlockFromSlave (Table t) {
+    PIMP_D (BufferedSlave);
+
+    switch (t) {
+      case DiscreteInput:
+      case Coil:
+      case InputRegister:
+      case HoldingRegister:
+        return d->updateBlockFromSlave (t);
+      default:
+        break;
+    }
+    errno = EINVAL;
+    return -1;
+  }
+
+  // ---------------------------------------------------------------------------
+  bool BufferedSlave::updateBlockFromSlave () {
+
+    return updateBlockFromSlave (Coil) >= 0 &&
+           updateBlockFromSlave (HoldingRegister) >= 0 &&
+           updateBlockFromSlave (DiscreteInput) >= 0 &&
+           updateBlockFromSlave (InputRegister) >= 0;
+  }
+
+  // ---------------------------------------------------------------------------
+  // protected
+  modbus_mapping_t * BufferedSlave::map() {
+    PIMP_D (BufferedSlave);
+
+    return d->map;
+  }
+
+  // ---------------------------------------------------------------------------
+  // protected
+  const modbus_mapping_t * BufferedSlave::map() const {
+    PIMP_D (const BufferedSlave);
+
+    return d->map;
+  }
+
+  // ---------------------------------------------------------------------------
+  // protected
+  modbus_mapping_t * BufferedSlave::map (const Request & req) {
+    PIMP_D (BufferedSlave);
+
+    return d->replyMap (req);
+  }
+
+  // ---------------------------------------------------------------------------
+  // protected
+  int BufferedSlave::reply (modbus_t * ctx, const Request & req, int len) {
+    PIMP_D (BufferedSlave);
+
+    return d->reply (ctx, req, len);
+  }
+
+  // ---------------------------------------------------------------------------
+  // protected
+  int BufferedSlave::reply (const Request & req, Response & rsp) {
+    PIMP_D (BufferedSlave);
+
+    return d->reply (req, rsp);
+  }
+
+  // ---------------------------------------------------------------------------
+  //
+  //                         BufferedSlave::Private Class
+  //
+  // ---------------------------------------------------------------------------
+
+  // ---------------------------------------------------------------------------
+  BufferedSlave::Private::Private (BufferedSlave * q) :
+    Slave::Private (q), map (modbus_mapping_new (0, 0, 0, 0)),
+    beforeReplyCB (0), afterReplyCB (0) {
+
+    scratch = *map;
+    image = *map;
+    dirty[Coil].resize (0x10000 / 64);
+    dirty[HoldingRegister].resize (0x10000 / 64);
+    pending.fill (false);
+    changesFd = -1;
+    flushInterval = std::chrono::milliseconds (1000);
+    flushOnWrite = false;
+    flushRequested = false;
+    flushStop = false;
+    maxAge = std::chrono::milliseconds (0);
+    staleWhileRevalidate = false;
+    revalidatorStop = false;
+    server = nullptr;
+    for (Table t : { DiscreteInput, Coil, InputRegister, HoldingRegister }) {
+
+      updateIndex (t);
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  BufferedSlave::Private::Private (BufferedSlave * q, int s, Device * d) :
+    Private (q) {
+
+    id = s;
+    dev = d;
+  }
+
+  // ---------------------------------------------------------------------------
+  BufferedSlave::Private::~Private() {
+
+    if (revalidatorThread.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock (cacheMutex);
+
+        revalidatorStop = true;
+        cacheCond.notify_one();
+      }
+      revalidatorThread.join();
+    }
+    closePersistentFile();
+    detach();
+#ifdef __linux__
+    if (changesFd >= 0) {
+
+      ::close (changesFd);
+    }
+#endif
+    modbus_mapping_free (map);
+  }
+
+  // ---------------------------------------------------------------------------
+  // the data [addr, addr + nb[ of the table t have been written by a client,
+  // addr is a PDU address
+  void BufferedSlave::Private::written (Table t, int addr, int nb) {
+    int n = nb;
+
+    notify (t, addr, nb);
+    if (t == HoldingRegister) {
+
+      if (findRegisters (t, addr, n) == nullptr) {
+        n = 0;
+      }
+    }
+    else if (findBits (t, addr, n) == nullptr) {
+      n = 0;
+    }
+
+    // a range out of the blocks has been rejected by an exception
+    if (nb > 0 && n == nb) {
+      std::lock_guard<std::mutex> lock (changesMutex);
+      std::vector<uint64_t> & bits = dirty[t];
+
+      for (int i = addr; i < addr + nb; i++) {
+
+        bits[i / 64] |= 1ULL << (i % 64);
+      }
+      if (!pending[t]) {
+
+        pending[t] = true;
+        signal();
+      }
+      changesCond.notify_all();
+    }
+
+    if (t == Coil || t == HoldingRegister) {
+      std::lock_guard<std::mutex> lock (flushMutex);
+
+      if (flushOnWrite) {
+
+        flushRequested = true;
+        flushCond.notify_one();
+      }
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // signals the changes on the eventfd, changesMutex must be locked
+  void BufferedSlave::Private::signal() {
+#ifdef __linux__
+    if (changesFd >= 0) {
+      uint64_t n = 1;
+
+      if (::write (changesFd, &n, sizeof (n)) < 0) {
+        // EAGAIN, already signaled
+      }
+    }
+#endif
+  }
+
+  // ---------------------------------------------------------------------------
+  // opens the persistent file for the blocks of coils and holding registers,
+  // restores their values if the file has the same blocks
+  int BufferedSlave::Private::openPersistentFile (const std::string & path) {
+    std::vector<PersistentFormat::Block> b = persistentBlocks();
+    std::vector<uint8_t> data;
+    int rc = 0;
+
+    if (b.empty()) {
+
+      errno = EINVAL;
+      return -1;
+    }
+
+    std::lock_guard<std::mutex> lock (fileMutex);
+    if (!persistent.open (path, b, data)) {
+
+      return -1;
+    }
+
+    if (!data.empty()) {
+
+      restore (data);
+      flushed.swap (data);
+      rc = 1;
+    }
+    else {
+
+      // the file is valid from its creation
+      collect (flushed);
+      if (!persistent.write (flushed)) {
+        int saved_errno = errno;
+
+        persistent.close();
+        errno = saved_errno;
+        return -1;
+      }
+    }
+
+    flushRequested = false;
+    flushStop = false;
+    flushThread = std::thread (&Private::flusher, this);
+    return rc;
+  }
+
+  // ---------------------------------------------------------------------------
+  // stops the flusher thread, flushes the values and closes the file
+  void BufferedSlave::Private::closePersistentFile() {
+
+    if (flushThread.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock (flushMutex);
+
+        flushStop = true;
+        flushOnWrite = false;
+        flushCond.notify_one();
+      }
+      flushThread.join();
+    }
+
+    if (persistent.isOpen()) {
+
+      flush();
+      std::lock_guard<std::mutex> lock (fileMutex);
+      persistent.close();
+      flushed.clear();
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // blocks saved in the persistent file, in the order of their values
+  std::vector<PersistentFormat::Block> BufferedSlave::Private::persistentBlocks() {
+    std::vector<PersistentFormat::Block> v;
+
+    for (Table t : { Coil, HoldingRegister }) {
+
+      for (const auto & e : blocks[t].index) {
+        PersistentFormat::Block b = {};
+
+        b.table = t;
+        b.start = e.start;
+        b.size = e.end - e.start;
+        v.push_back (b);
+      }
+    }
+    return v;
+  }
+
+  // ---------------------------------------------------------------------------
+  // copies the values of the blocks of coils and holding registers to data
+  void BufferedSlave::Private::collect (std::vector<uint8_t> & data) {
+
+    data.resize (PersistentFile::dataSize (persistentBlocks()));
+    seqlock.read ([this, &data] {
+      uint8_t * p = data.data();
+
+      for (const auto & e : blocks[Coil].index) {
+        int n = e.end - e.start;
+
+        memcpy (p, findBits (Coil, e.start, n), n);
+        p += n;
+      }
+      for (const auto & e : blocks[HoldingRegister].index) {
+        int n = e.end - e.start;
+
+        memcpy (p, findRegisters (HoldingRegister, e.start, n), n * sizeof (uint16_t));
+        p += n * sizeof (uint16_t);
+      }
+    });
+  }
+
+  // ---------------------------------------------------------------------------
+  // copies data, collected by collect(), to the blocks
+  void BufferedSlave::Private::restore (const std::vector<uint8_t> & data) {
+    const uint8_t * p = data.data();
+
+    seqlock.lock();
+    for (const auto & e : blocks[Coil].index) {
+      int n = e.end - e.start;
+
+      memcpy (findBits (Coil, e.start, n), p, n);
+      p += n;
+    }
+    for (const auto & e : blocks[HoldingRegister].index) {
+      int n = e.end - e.start;
+
+      memcpy (findRegisters (HoldingRegister, e.start, n), p, n * sizeof (uint16_t));
+      p += n * sizeof (uint16_t);
+    }
+    seqlock.unlock();
+  }
+
+  // ---------------------------------------------------------------------------
+  // writes a snapshot of the values in the persistent file if they have
+  // changed since the last one
+  bool BufferedSlave::Private::flush() {
+    std::lock_guard<std::mutex> lock (fileMutex);
+    std::vector<uint8_t> data;
+
+    if (!persistent.isOpen()) {
+
+      errno = EBADF;
+      return false;
+    }
+
+    collect (data);
+    if (data == flushed) {
+
+      return true;
+    }
+
+    if (persistent.write (data)) {
+
+      flushed.swap (data);
+      return true;
+    }
+    return false;
+  }
+
+  // ---------------------------------------------------------------------------
+  // flusher thread, flushes the values periodically or when requested by
+  // written()
+  void BufferedSlave::Private::flusher() {
+    std::unique_lock<std::mutex> lock (flushMutex);
+
+    while (!flushStop) {
+
+      if (!flushRequested) {
+
+        if (flushInterval.count() > 0) {
+
+          flushCond.wait_for (lock, flushInterval);
+        }
+        else {
+
+          flushCond.wait (lock);
+        }
+        if (flushStop) {
+          break;
+        }
+      }
+      flushRequested = false;
+
+      lock.unlock();
+      flush();
+      lock.lock();
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // reads from the device the block of the table t containing the PDU
+  // address addr if it is older than maxAge, returns the number of elements
+  // of [addr, addr + nb[ in the block, 0 if none, -1 if error
+  int BufferedSlave::Private::fetch (Table t, int addr, int nb) {
+    const Entry * e = find (t, addr);
+
+    if (!e) {
+
+      return 0;
+    }
+
+    nb = std::min (nb, e->end - addr);
+    {
+      std::lock_guard<std::mutex> lock (cacheMutex);
+      Freshness & f = freshness[t][e - blocks[t].index.data()];
+      auto now = std::chrono::steady_clock::now();
+
+      if (f.time != std::chrono::steady_clock::time_point()) {
+
+        if ( (now - f.time) <= maxAge) {
+
+          return nb;
+        }
+
+        if (staleWhileRevalidate) {
+
+          if (!f.refreshing) {
+
+            f.refreshing = true;
+            stale.push_back (std::make_pair (t, e->start));
+            if (!revalidatorThread.joinable()) {
+
+              revalidatorThread = std::thread (&Private::revalidator, this);
+            }
+            cacheCond.notify_one();
+          }
+          return nb;
+        }
+      }
+    }
+
+    int rc = refresh (t, e->start);
+    return (rc < 0) ? rc : nb;
+  }
+
+  // ---------------------------------------------------------------------------
+  // reads from the device the whole block of the table t starting at the
+  // PDU address start, if it has not been read since maxAge. The device is
+  // locked for the whole block, the revalidator thread shares it with the
+  // other slaves and the application.
+  int BufferedSlave::Private::refresh (Table t, int start) {
+    PIMP_Q (BufferedSlave);
+    std::lock_guard<std::recursive_mutex> device (transaction());
+    const Entry * e = find (t, start);
+
+    if (!e || e->start != start) {
+
+      errno = EINVAL;
+      return -1;
+    }
+
+    size_t i = e - blocks[t].index.data();
+    auto requested = std::chrono::steady_clock::now();
+    {
+      std::lock_guard<std::mutex> lock (cacheMutex);
+      Freshness & f = freshness[t][i];
+
+      // read by another thread in the meantime
+      if (f.time != std::chrono::steady_clock::time_point() &&
+          (requested - f.time) <= maxAge) {
+
+        f.refreshing = false;
+        return e->end - e->start;
+      }
+    }
+
+    int size = e->end - e->start;
+    int max = (t == Coil || t == DiscreteInput) ?
+              MODBUS_MAX_READ_BITS : MODBUS_MAX_READ_REGISTERS;
+    std::vector<uint8_t> bits;
+    std::vector<uint16_t> registers;
+    int rc = 0;
+
+    if (t == Coil || t == DiscreteInput) {
+      bits.resize (size);
+    }
+    else {
+      registers.resize (size);
+    }
+
+    for (int n = 0; n < size && rc >= 0; n += max) {
+      int addr = q->dataAddress (start + n);
+      int nb = std::min (max, size - n);
+
+      switch (t) {
+        case DiscreteInput:
+          rc = q->Slave::readDiscreteInputs (addr, reinterpret_cast<bool *> (&bits[n]), nb);
+          break;
+        case Coil:
+          rc = q->Slave::readCoils (addr, reinterpret_cast<bool *> (&bits[n]), nb);
+          break;
+        case InputRegister:
+          rc = q->Slave::readInputRegisters (addr, &registers[n], nb);
+          break;
+        default:
+          rc = q->Slave::readRegisters (addr, &registers[n], nb);
+          break;
+      }
+    }
+
+    if (rc >= 0) {
+      int nb = size;
+
+      if (t == Coil || t == DiscreteInput) {
+
+        copy (findBits (t, start, nb), bits.data(), size);
+      }
+      else {
+
+        copy (findRegisters (t, start, nb), registers.data(), size);
+      }
+      notify (t, start, size);
+    }
+
+    std::lock_guard<std::mutex> lock (cacheMutex);
+    Freshness & f = freshness[t][i];
+
+    f.refreshing = false;
+    if (rc >= 0) {
+
+      f.time = requested;
+      return size;
+    }
+    return -1;
+  }
+
+  // ---------------------------------------------------------------------------
+  // thread reading the stale blocks returned by fetch()
+  void BufferedSlave::Private::revalidator() {
+    std::unique_lock<std::mutex> lock (cacheMutex);
+
+    while (!revalidatorStop) {
+
+      if (stale.empty()) {
+
+        cacheCond.wait (lock);
+        continue;
+      }
+
+      std::vector<std::pair<Table, int>> v;
+      v.swap (stale);
+      lock.unlock();
+      for (const auto & b : v) {
+
+        refresh (b.first, b.second);
+      }
+      lock.lock();
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // adds the block [addr, addr + nmemb[ to the table t, addr is a PDU address
+  int BufferedSlave::Private::addBlock (Table t, int addr, int nmemb) {
+    int start, size;
+
+    mapBlock (t, start, size);
+    if (!isTable (t) || nmemb <= 0 || addr < 0 || (addr + nmemb) > 0x10000 ||
+        overlaps (t, addr, nmemb) ||
+        (size > 0 && addr < (start + size) && start < (addr + nmemb))) {
+
+      errno = EINVAL;
+      return -1;
+    }
+
+    std::vector<Block> & added = blocks[t].added;
+    auto it = std::find_if (added.begin(), added.end(),
+    [addr] (const Block & b) {
+      return b.start > addr;
+    });
+    Block b;
+
+    b.start = addr;
+    b.size = nmemb;
+    if (t == Coil || t == DiscreteInput) {
+
+      b.bits.assign (nmemb, 0);
+    }
+    else {
+
+      b.registers.assign (nmemb, 0);
+    }
+    added.insert (it, std::move (b));
+    updateIndex (t);
+    return nmemb;
+  }
+
+  // ---------------------------------------------------------------------------
+  // removes the block added at the PDU address addr
+  int BufferedSlave::Private::removeBlock (Table t, int addr) {
+
+    if (isTable (t)) {
+      std::vector<Block> & added = blocks[t].added;
+
+      for (auto it = added.begin(); it != added.end(); ++it) {
+
+        if (it->start == addr) {
+
+          added.erase (it);
+          updateIndex (t);
+          return 0;
+        }
+      }
+    }
+    errno = EINVAL;
+    return -1;
+  }
+
+  // ---------------------------------------------------------------------------
+  // returns true if [addr, addr + nmemb[ overlaps a block added to the table t
+  bool BufferedSlave::Private::overlaps (Table t, int addr, int nmemb) const {
+
+    if (isTable (t)) {
+
+      for (const auto & b : blocks[t].added) {
+
+        if (addr < (b.start + b.size) && b.start < (addr + nmemb)) {
+
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  // ---------------------------------------------------------------------------
+  // block of the table t in the map, set by setBlock()
+  void BufferedSlave::Private::mapBlock (Table t, int & start, int & size) const {
+
+    switch (t) {
+      case DiscreteInput:
+        start = map->start_input_bits;
+        size = map->nb_input_bits;
+        break;
+      case Coil:
+        start = map->start_bits;
+        size = map->nb_bits;
+        break;
+      case InputRegister:
+        start = map->start_input_registers;
+        size = map->nb_input_registers;
+        break;
+      case HoldingRegister:
+        start = map->start_registers;
+        size = map->nb_registers;
+        break;
+      default:
+        start = 0;
+        size = 0;
+        break;
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // rebuilds the index of the table t after a change of its blocks
+  void BufferedSlave::Private::updateIndex (Table t) {
+    Blocks & b = blocks[t];
+    int start, size;
+
+    b.index.clear();
+    for (size_t i = 0; i < b.added.size(); i++) {
+      const Block & a = b.added[i];
+
+      b.index.push_back ({a.start, a.start + a.size, static_cast<int> (i) });
+    }
+
+    mapBlock (t, start, size);
+    if (size > 0) {
+      auto it = std::find_if (b.index.begin(), b.index.end(),
+      [start] (const Entry & e) {
+        return e.start > start;
+      });
+
+      b.index.insert (it, {start, start + size, -1});
+    }
+
+    // the blocks must be read again
+    {
+      std::lock_guard<std::mutex> lock (cacheMutex);
+
+      freshness[t].assign (b.index.size(), Freshness());
+    }
+
+    b.pages.resize ( (0x10000 >> PageBits));
+    size_t i = 0;
+    for (size_t p = 0; p < b.pages.size(); p++) {
+      int addr = p << PageBits;
+
+      while (i < b.index.size() && b.index[i].end <= addr) {
+        i++;
+      }
+      b.pages[p] = i;
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // returns the block of the table t containing the PDU address addr,
+  // nullptr if none
+  const BufferedSlave::Private::Entry *
+  BufferedSlave::Private::find (Table t, int addr) const {
+
+    if (isTable (t) && addr >= 0 && addr < 0x10000) {
+      const Blocks & b = blocks[t];
+
+      // the entries before the page end before addr, the first entry
+      // ending after addr is the only one that can contain it
+      for (size_t i = b.pages[addr >> PageBits]; i < b.index.size(); i++) {
+        const Entry & e = b.index[i];
+
+        if (e.end > addr) {
+
+          return (e.start <= addr) ? &e : nullptr;
+        }
+      }
+    }
+    return nullptr;
+  }
+
+  // ---------------------------------------------------------------------------
+  // returns the bits from the PDU address addr of the table t, nb is limited
+  // to the end of the block, nullptr if addr is not in a block
+  uint8_t * BufferedSlave::Private::findBits (Table t, int addr, int & nb) {
+
+    if (t == Coil || t == DiscreteInput) {
+      const Entry * e = find (t, addr);
+
+      if (e) {
+
+        nb = std::min (nb, e->end - addr);
+        if (e->block < 0) {
+          uint8_t * tab = (t == Coil) ? map->tab_bits : map->tab_input_bits;
+
+          return &tab[addr - e->start];
         }
+        return &blocks[t].added[e->block].bits[addr - e->start];
       }
-
-      return nb;
     }
-    errno = EINVAL;
-    return -1;
+    return nullptr;
   }
 
   // ---------------------------------------------------------------------------
-  // overload
-  int BufferedSlave::writeCoil (int addr, bool value) {
+  // returns the registers from the PDU address addr of the table t, nb is
+  // limited to the end of the block, nullptr if addr is not in a block
+  uint16_t * BufferedSlave::Private::findRegisters (Table t, int addr, int & nb) {
 
-    return writeCoils (addr, &value, 1);
+    if (t == HoldingRegister || t == InputRegister) {
+      const Entry * e = find (t, addr);
+
+      if (e) {
+
+        nb = std::min (nb, e->end - addr);
+        if (e->block < 0) {
+          uint16_t * tab = (t == HoldingRegister) ?
+                           map->tab_registers : map->tab_input_registers;
+
+          return &tab[addr - e->start];
+        }
+        return &blocks[t].added[e->block].registers[addr - e->start];
+      }
+    }
+    return nullptr;
   }
 
   // ---------------------------------------------------------------------------
-  // overload
-  int BufferedSlave::writeRegisters (int addr, const uint16_t * src, int nb) {
-    PIMP_D (BufferedSlave);
-
-    int pduAddr = pduAddress (addr);
+  // returns the map used by modbus_reply() for req: the map itself, or the
+  // scratch map pointing to the added block containing the addressed data.
+  // The requests out of the blocks are replied from the map, libmodbus
+  // returns an illegal data address exception.
+  modbus_mapping_t * BufferedSlave::Private::replyMap (const Request & req) {
+    Table t;
+    int addr = req.startingAddress();
+    int nb = req.quantity();
+
+    switch (req.function()) {
+      case ReadCoils:
+      case WriteMultipleCoils:
+        t = Coil;
+        break;
+      case WriteSingleCoil:
+        t = Coil;
+        nb = 1;
+        break;
+      case ReadDiscreteInputs:
+        t = DiscreteInput;
+        break;
+      case ReadInputRegisters:
+        t = InputRegister;
+        break;
+      case ReadHoldingRegisters:
+      case WriteMultipleRegisters:
+      case ReadWriteMultipleRegisters:
+        t = HoldingRegister;
+        break;
+      case WriteSingleRegister:
+      case MaskWriteRegister:
+        t = HoldingRegister;
+        nb = 1;
+        break;
+      default:
+        return map;
+    }
 
-    if ( (pduAddr >= d->map->start_registers) &&
-         (pduAddr < (d->map->start_registers + d->map->nb_registers)))  {
-      int offset = pduAddr - d->map->start_registers;
-      uint16_t * dest = &d->map->tab_registers[offset];
+    const Entry * e = find (t, addr);
+    if (!e || e->block < 0 || (addr + nb) > e->end) {
 
-      nb = std::min (nb, (d->map->nb_registers - offset));
+      return map;
+    }
 
-      memcpy (dest, src, nb * sizeof (dest[0]));
-      if (isOpen()) {
-        if (nb == 1) {
+    if (req.function() == ReadWriteMultipleRegisters) {
+      // the written registers must be in the same block
+      int waddr = req.word (5);
 
-          return Slave::writeRegister (addr, dest[0]);
-        }
-        else {
+      if (find (t, waddr) != e || (waddr + req.word (7)) > e->end) {
 
-          return  Slave::writeRegisters (addr, dest, nb);
-        }
+        return map;
       }
-      return nb;
     }
-    errno = EINVAL;
-    return -1;
+
+    Block & b = blocks[t].added[e->block];
+    scratch = *map;
+    switch (t) {
+      case DiscreteInput:
+        scratch.start_input_bits = b.start;
+        scratch.nb_input_bits = b.size;
+        scratch.tab_input_bits = b.bits.data();
+        break;
+      case Coil:
+        scratch.start_bits = b.start;
+        scratch.nb_bits = b.size;
+        scratch.tab_bits = b.bits.data();
+        break;
+      case InputRegister:
+        scratch.start_input_registers = b.start;
+        scratch.nb_input_registers = b.size;
+        scratch.tab_input_registers = b.registers.data();
+        break;
+      case HoldingRegister:
+        scratch.start_registers = b.start;
+        scratch.nb_registers = b.size;
+        scratch.tab_registers = b.registers.data();
+        break;
+    }
+    return &scratch;
   }
 
   // ---------------------------------------------------------------------------
-  // overload
-  int BufferedSlave::writeRegister (int addr, uint16_t value) {
+  // returns a map of a copy of the data read by req, m if req does not read
+  // data or reads data out of m (libmodbus replies with an exception)
+  modbus_mapping_t *
+  BufferedSlave::Private::snapshot (modbus_mapping_t * m, const Request & req) {
+    int addr = req.startingAddress();
+    int nb = req.quantity();
+    const uint8_t * bits = nullptr;
+    const uint16_t * regs = nullptr;
+
+    switch (req.function()) {
+      case ReadCoils:
+        if (addr >= m->start_bits && (addr + nb) <= (m->start_bits + m->nb_bits)) {
+          bits = &m->tab_bits[addr - m->start_bits];
+        }
+        break;
+      case ReadDiscreteInputs:
+        if (addr >= m->start_input_bits &&
+            (addr + nb) <= (m->start_input_bits + m->nb_input_bits)) {
+          bits = &m->tab_input_bits[addr - m->start_input_bits];
+        }
+        break;
+      case ReadHoldingRegisters:
+        if (addr >= m->start_registers &&
+            (addr + nb) <= (m->start_registers + m->nb_registers)) {
+          regs = &m->tab_registers[addr - m->start_registers];
+        }
+        break;
+      case ReadInputRegisters:
+        if (addr >= m->start_input_registers &&
+            (addr + nb) <= (m->start_input_registers + m->nb_input_registers)) {
+          regs = &m->tab_input_registers[addr - m->start_input_registers];
+        }
+        break;
+      default:
+        break;
+    }
 
-    return writeRegisters (addr, &value, 1);
+    if (bits) {
+
+      bitImage.resize (nb);
+      seqlock.read ([this, bits, nb] {
+        memcpy (bitImage.data(), bits, nb);
+      });
+    }
+    else if (regs) {
+
+      registerImage.resize (nb);
+      seqlock.read ([this, regs, nb] {
+        memcpy (registerImage.data(), regs, nb * sizeof (uint16_t));
+      });
+    }
+    else {
+
+      return m;
+    }
+
+    // the copy is addressed as the data of m
+    image = *m;
+    switch (req.function()) {
+      case ReadCoils:
+        image.start_bits = addr;
+        image.nb_bits = nb;
+        image.tab_bits = bitImage.data();
+        break;
+      case ReadDiscreteInputs:
+        image.start_input_bits = addr;
+        image.nb_input_bits = nb;
+        image.tab_input_bits = bitImage.data();
+        break;
+      case ReadHoldingRegisters:
+        image.start_registers = addr;
+        image.nb_registers = nb;
+        image.tab_registers = registerImage.data();
+        break;
+      default:
+        image.start_input_registers = addr;
+        image.nb_input_registers = nb;
+        image.tab_input_registers = registerImage.data();
+        break;
+    }
+    return &image;
   }
 
   // ---------------------------------------------------------------------------
-  // overload
-  int BufferedSlave::writeReadRegisters (int write_addr, const uint16_t * write_src, int write_nb,
-                                         int read_addr, uint16_t * read_dest, int read_nb) {
-    PIMP_D (BufferedSlave);
+  // replies to req with libmodbus: the data read are copied before sending
+  // the response. The server replies to the writes with reply (req, rsp),
+  // which releases the seqlock before the send, modbus_reply() writing the
+  // map and sending the response in a single call.
+  int BufferedSlave::Private::reply (modbus_t * ctx, const Request & req, int len) {
+    modbus_mapping_t * m = replyMap (req);
+    int rc;
+
+    switch (req.function()) {
+      case WriteSingleCoil:
+      case WriteSingleRegister:
+      case WriteMultipleCoils:
+      case WriteMultipleRegisters:
+      case MaskWriteRegister:
+      case ReadWriteMultipleRegisters:
+        seqlock.lock();
+        rc = modbus_reply (ctx, req.adu(), len, m);
+        seqlock.unlock();
+        break;
+      default:
+        rc = modbus_reply (ctx, req.adu(), len, snapshot (m, req));
+        break;
+    }
+    return rc;
+  }
 
-    int pduReadAddr = pduAddress (read_addr);
-    int pduWriteAddr = pduAddress (write_addr);
+  // ---------------------------------------------------------------------------
+  // builds in rsp the response to a write or to a request not handled by
+  // libmodbus, returns the exception code, 0 if none
+  int BufferedSlave::Private::reply (const Request & req, Response & rsp) {
+    std::vector<FileRecordFormat::SubRequest> subs;
+    int code = IllegalFunction;
+
+    switch (req.function()) {
+      case ReadFileRecord:
+      case WriteFileRecord:
+        code = FileRecordFormat::parse (req, subs);
+        break;
+      case WriteSingleCoil:
+      case WriteSingleRegister:
+      case WriteMultipleCoils:
+      case WriteMultipleRegisters:
+      case MaskWriteRegister:
+      case ReadWriteMultipleRegisters:
+        code = write (req, rsp);
+        if (code == 0) {
+
+          return 0;
+        }
+        break;
+      default:
+        break;
+    }
 
-    if ( (pduReadAddr >= d->map->start_registers) &&
-         (pduWriteAddr >= d->map->start_registers) &&
-         (pduReadAddr < (d->map->start_registers + d->map->nb_registers)) &&
-         (pduWriteAddr < (d->map->start_registers + d->map->nb_registers)))  {
-      int offsetRead = pduReadAddr - d->map->start_registers;
-      int offsetWrite = pduWriteAddr - d->map->start_registers;
-      uint16_t * destRead = &d->map->tab_registers[offsetRead];
-      uint16_t * srcWrite = &d->map->tab_registers[offsetWrite];
+    if (code == 0) {
+      std::lock_guard<std::mutex> lock (filesMutex);
 
-      read_nb = std::min (read_nb, (d->map->nb_registers - offsetRead));
-      write_nb = std::min (write_nb, (d->map->nb_registers - offsetWrite));
+      for (const auto & s : subs) {
 
-      memcpy (srcWrite, write_src, write_nb * sizeof (srcWrite[0]));
-      if (isOpen()) {
+        if (!findFile (s.file, s.record, s.count)) {
 
-        read_nb =  Slave::writeReadRegisters (write_addr, srcWrite, write_nb,
-                                              read_addr, destRead, read_nb);
+          code = IllegalDataAddress;
+          break;
+        }
       }
 
-      if (read_nb >= 0) {
+      if (code == 0) {
 
-        memcpy (read_dest, destRead, read_nb * sizeof (srcWrite[0]));
-      }
-      return read_nb;
+        if (req.function() == ReadFileRecord) {
+          int i = 2;
 
-    }
-    errno = EINVAL;
-    return -1;
-  }
+          for (const auto & s : subs) {
+            const uint16_t * src = findFile (s.file, s.record, s.count)->data() + s.record;
 
-  // ---------------------------------------------------------------------------
-  // overload
-  int BufferedSlave::reportSlaveId (uint16_t max_dest, uint8_t * dest) {
-    PIMP_D (BufferedSlave);
+            rsp.setByte (i, 1 + s.count * 2);
+            rsp.setByte (i + 1, FileRecordFormat::RefType);
+            for (int k = 0; k < s.count; k++) {
 
-    if (isOpen()) {
+              rsp.setWord (i + 2 + k * 2, src[k]);
+            }
+            i += 2 + s.count * 2;
+          }
+          rsp.setByte (1, i - 2);
+          rsp.setSize (i);
+        }
+        else {
 
-      d->idReport.resize (MaxPduLength, 0);
+          for (const auto & s : subs) {
+            uint16_t * dest = findFile (s.file, s.record, s.count)->data() + s.record;
 
-      int rc = Slave::reportSlaveId (d->idReport.size(), d->idReport.data());
-      if (rc < 0) {
+            for (int k = 0; k < s.count; k++) {
 
-        return rc;
+              dest[k] = req.word (s.values + k * 2);
+            }
+          }
+          // echo of the request
+          rsp.setSize (2 + req.byte (1));
+        }
+        return 0;
       }
-      d->idReport.resize (rc);
     }
-    max_dest = std::min (max_dest, static_cast<uint16_t> (d->idReport.size()));
-    memcpy (dest, d->idReport.data(), max_dest);
-    return max_dest;
+
+    rsp.setExceptionCode (static_cast<ExceptionCode> (code));
+    rsp.setSize (2);
+    return code;
   }
 
-// ---------------------------------------------------------------------------
-  int BufferedSlave::writeDiscreteInputs (int addr, const bool * src, int nb) {
-    PIMP_D (BufferedSlave);
+  // ---------------------------------------------------------------------------
+  // writes the data of the request req of a client and builds the response
+  // in rsp, returns the exception code, 0 if none. The data are written under
+  // the seqlock, the response is sent once it is released. The requests are
+  // checked as by modbus_reply().
+  int BufferedSlave::Private::write (const Request & req, Response & rsp) {
+    int addr = req.word (1);
+    int nb = req.word (3); // value of the single writes
+    int n;
+
+    switch (req.function()) {
+
+      case WriteSingleCoil: {
+        uint8_t * bits = findBits (Coil, addr, n = 1);
+
+        if (!bits) {
+          return IllegalDataAddress;
+        }
+        if (nb != 0xFF00 && nb != 0) {
+          return IllegalDataValue;
+        }
+        seqlock.lock();
+        bits[0] = (nb != 0);
+        seqlock.unlock();
+        rsp.setSize (5); // echo of the request
+      }
+      break;
 
-    addr = pduAddress (addr);
+      case WriteMultipleCoils: {
+        if (nb < 1 || nb > MODBUS_MAX_WRITE_BITS || (req.byte (5) * 8) < nb) {
+          return IllegalDataValue;
+        }
+        uint8_t * bits = findBits (Coil, addr, n = nb);
 
-    if ( (addr >= d->map->start_input_bits) &&
-         (addr < (d->map->start_input_bits + d->map->nb_input_bits)))  {
-      int offset = addr - d->map->start_input_bits;
-      uint8_t * dest = &d->map->tab_input_bits[offset];
+        if (!bits || n != nb) {
+          return IllegalDataAddress;
+        }
+        seqlock.lock();
+        for (int i = 0; i < nb; i++) {
 
-      nb = std::min (nb, (d->map->nb_input_bits - offset));
-      memcpy (dest, src, nb * sizeof (dest[0]));
-      return nb;
-    }
-    errno = EINVAL;
-    return -1;
-  }
+          bits[i] = (req.byte (6 + i / 8) >> (i % 8)) & 1;
+        }
+        seqlock.unlock();
+        rsp.setSize (5); // address and quantity of the request
+      }
+      break;
 
-  // ---------------------------------------------------------------------------
-  int BufferedSlave::writeDiscreteInput (int addr, bool value) {
+      case WriteSingleRegister: {
+        uint16_t * regs = registers (HoldingRegister, addr, 1);
 
-    return writeDiscreteInputs (addr, &value, 1);
-  }
+        if (!regs) {
+          return IllegalDataAddress;
+        }
+        seqlock.lock();
+        regs[0] = nb;
+        seqlock.unlock();
+        rsp.setSize (5); // echo of the request
+      }
+      break;
 
-  // ---------------------------------------------------------------------------
-  int BufferedSlave::writeInputRegisters (int addr, const uint16_t * src, int nb) {
-    PIMP_D (BufferedSlave);
+      case WriteMultipleRegisters: {
+        if (nb < 1 || nb > MODBUS_MAX_WRITE_REGISTERS || req.byte (5) != (nb * 2)) {
+          return IllegalDataValue;
+        }
+        uint16_t * regs = registers (HoldingRegister, addr, nb);
 
-    addr = pduAddress (addr);
+        if (!regs) {
+          return IllegalDataAddress;
+        }
+        seqlock.lock();
+        for (int i = 0; i < nb; i++) {
 
-    if ( (addr >= d->map->start_input_registers) &&
-         (addr < (d->map->start_input_registers + d->map->nb_input_registers)))  {
-      int offset = addr - d->map->start_input_registers;
-      uint16_t * dest = &d->map->tab_input_registers[offset];
+          regs[i] = req.word (6 + i * 2);
+        }
+        seqlock.unlock();
+        rsp.setSize (5); // address and quantity of the request
+      }
+      break;
 
-      nb = std::min (nb, (d->map->nb_input_registers - offset));
-      memcpy (dest, src, nb * sizeof (dest[0]));
-      return nb;
-    }
-    errno = EINVAL;
-    return -1;
-  }
+      case MaskWriteRegister: {
+        uint16_t * regs = registers (HoldingRegister, addr, 1);
+        uint16_t andMask = req.word (3);
+        uint16_t orMask = req.word (5);
 
-  // ---------------------------------------------------------------------------
-  int BufferedSlave::writeInputRegister (int addr, uint16_t value) {
+        if (!regs) {
+          return IllegalDataAddress;
+        }
+        seqlock.lock();
+        regs[0] = (regs[0] & andMask) | (orMask & ~andMask);
+        seqlock.unlock();
+        rsp.setSize (7); // echo of the request
+      }
+      break;
 
-    return writeInputRegisters (addr, &value, 1);
-  }
+      case ReadWriteMultipleRegisters: {
+        int waddr = req.word (5);
+        int wnb = req.word (7);
 
-  // ---------------------------------------------------------------------------
-  int BufferedSlave::updateSlaveFromBlock (Table t) {
-    PIMP_D (BufferedSlave);
+        if (wnb < 1 || wnb > MODBUS_MAX_WR_WRITE_REGISTERS ||
+            nb < 1 || nb > MODBUS_MAX_WR_READ_REGISTERS || req.byte (9) != (wnb * 2)) {
+          return IllegalDataValue;
+        }
+        uint16_t * rregs = registers (HoldingRegister, addr, nb);
+        uint16_t * wregs = registers (HoldingRegister, waddr, wnb);
 
-    switch (t) {
-      case Coil:
-        return d->updateSlaveCoilFromBlock();
-      case HoldingRegister:
-        return d->updateSlaveHoldingRegisterFromBlock();
+        if (!rregs || !wregs) {
+          return IllegalDataAddress;
+        }
+        // the registers are read after the write
+        seqlock.lock();
+        for (int i = 0; i < wnb; i++) {
+
+          wregs[i] = req.word (10 + i * 2);
+        }
+        for (int i = 0; i < nb; i++) {
+
+          rsp.setWord (2 + i * 2, rregs[i]);
+        }
+        seqlock.unlock();
+        rsp.setByte (1, nb * 2);
+        rsp.setSize (2 + nb * 2);
+      }
+      break;
+
+      default:
+        return IllegalFunction;
     }
-    errno = EINVAL;
-    return -1;
+    return 0;
   }
 
   // ---------------------------------------------------------------------------
-  bool BufferedSlave::updateSlaveFromBlock () {
+  // returns the file containing the records [record, record + nb[, filesMutex
+  // must be locked
+  RecordFile * BufferedSlave::Private::findFile (int file, int record, int nb) {
+    auto it = files.find (file);
 
-    return updateSlaveFromBlock (Coil) >= 0 &&
-           updateSlaveFromBlock (HoldingRegister) >= 0;
+    if (it != files.end() && record >= 0 && nb >= 0 &&
+        (record + nb) <= it->second->size()) {
+
+      return it->second.get();
+    }
+    return nullptr;
   }
 
   // ---------------------------------------------------------------------------
-  int BufferedSlave::updateBlockFromSlave (Table t) {
-    PIMP_D (BufferedSlave);
+  // returns the address of the pointer to the data of the table t in the map
+  void ** BufferedSlave::Private::mapData (Table t) {
 
     switch (t) {
       case DiscreteInput:
-        return d->updateDiscreteInputBlockFromSlave();
+        return reinterpret_cast<void **> (&map->tab_input_bits);
       case Coil:
-        return d->updateCoilBlockFromSlave();
+        return reinterpret_cast<void **> (&map->tab_bits);
       case InputRegister:
-        return d->updateInputRegisterBlockFromSlave();
+        return reinterpret_cast<void **> (&map->tab_input_registers);
       case HoldingRegister:
-        return d->updateHoldingRegisterBlockFromSlave();
+        return reinterpret_cast<void **> (&map->tab_registers);
     }
-    errno = EINVAL;
-    return -1;
+    return nullptr;
   }
 
   // ---------------------------------------------------------------------------
-  bool BufferedSlave::updateBlockFromSlave () {
+  // moves the blocks of the map to the shared memory segment name
+  bool BufferedSlave::Private::attach (const std::string & name) {
+    SharedMapFormat::Header h;
+
+    detach();
+    for (int i = 0; i < SharedMapFormat::Tables; i++) {
+      SharedMapFormat::Area & a = h.areas[i];
+      int start, size;
+
+      mapBlock (static_cast<Table> (i), start, size);
+      a.start = start;
+      a.size = size;
+      a.reserved = 0;
+    }
 
-    return updateBlockFromSlave (Coil) >= 0 &&
-           updateBlockFromSlave (HoldingRegister) >= 0 &&
-           updateBlockFromSlave (DiscreteInput) >= 0 &&
-           updateBlockFromSlave (InputRegister) >= 0;
-  }
+    if (!shm.create (name, h)) {
 
-  // ---------------------------------------------------------------------------
-  // protected
-  modbus_mapping_t * BufferedSlave::map() {
-    PIMP_D (BufferedSlave);
+      return false;
+    }
 
-    return d->map;
-  }
+    seqlock.lock();
+    for (Table t : { DiscreteInput, Coil, InputRegister, HoldingRegister }) {
+      size_t len = h.areas[t].size * SharedMapFormat::elementSize (t);
+      void ** data = mapData (t);
 
-  // ---------------------------------------------------------------------------
-  // protected
-  const modbus_mapping_t * BufferedSlave::map() const {
-    PIMP_D (const BufferedSlave);
+      // the values of an existing segment are kept
+      if (len > 0 && !shm.reused) {
 
-    return d->map;
+        memcpy (shm.data (t), *data, len);
+      }
+      free (*data);
+      *data = (len > 0) ? shm.data (t) : nullptr;
+    }
+    seqlock.unlock();
+    seqlock.setCounter (&shm.header()->sequence);
+    return true;
   }
 
   // ---------------------------------------------------------------------------
-  //
-  //                         BufferedSlave::Private Class
-  //
-  // ---------------------------------------------------------------------------
+  // moves the blocks of the map from the shared memory segment to the heap
+  void BufferedSlave::Private::detach() {
 
-  // ---------------------------------------------------------------------------
-  BufferedSlave::Private::Private (BufferedSlave * q) :
-    Slave::Private (q), map (modbus_mapping_new (0, 0, 0, 0)),
-    beforeReplyCB (0), afterReplyCB (0) {
+    if (shm.isOpen()) {
 
-  }
+      for (Table t : { DiscreteInput, Coil, InputRegister, HoldingRegister }) {
+        int start, size;
+        void ** data = mapData (t);
+        void * p = nullptr;
 
-  // ---------------------------------------------------------------------------
-  BufferedSlave::Private::Private (BufferedSlave * q, int s, Device * d) :
-    Private (q) {
+        mapBlock (t, start, size);
+        if (size > 0) {
+          size_t len = size * SharedMapFormat::elementSize (t);
 
-    id = s;
-    dev = d;
+          p = malloc (len);
+          seqlock.read ([p, data, len] {
+            memcpy (p, *data, len);
+          });
+        }
+        *data = p;
+      }
+      seqlock.setCounter (nullptr);
+      shm.close();
+    }
   }
 
   // ---------------------------------------------------------------------------
-  BufferedSlave::Private::~Private() {
+  // copies the n elements read from the device to the data
+  template <typename T>
+  void BufferedSlave::Private::copy (T * dest, const T * src, int n) {
 
-    modbus_mapping_free (map);
+    if (n > 0) {
+
+      seqlock.lock();
+      memcpy (dest, src, n * sizeof (T));
+      seqlock.unlock();
+    }
   }
 
   // ---------------------------------------------------------------------------
-  int BufferedSlave::Private::updateDiscreteInputBlockFromSlave() {
-    PIMP_Q (Slave);
+  // reads all the blocks of the table t from the slave
+  int BufferedSlave::Private::updateBlockFromSlave (Table t) {
+    PIMP_Q (BufferedSlave);
+    int rc = 0;
+
+    if (q->isOpen()) {
+      // the values are read aside, the read functions copy them in the
+      // block under the seqlock
+      std::vector<uint8_t> bits;
+      std::vector<uint16_t> registers;
+
+      for (const auto & e : blocks[t].index) {
+        int addr = q->dataAddress (e.start);
+        int nb = e.end - e.start;
+        int n;
+
+        switch (t) {
+          case DiscreteInput:
+            bits.resize (nb);
+            n = q->readDiscreteInputs (addr, reinterpret_cast<bool *> (bits.data()), nb);
+            break;
+          case Coil:
+            bits.resize (nb);
+            n = q->readCoils (addr, reinterpret_cast<bool *> (bits.data()), nb);
+            break;
+          case InputRegister:
+            registers.resize (nb);
+            n = q->readInputRegisters (addr, registers.data(), nb);
+            break;
+          default:
+            registers.resize (nb);
+            n = q->readRegisters (addr, registers.data(), nb);
+            break;
+        }
 
-    int nb = map->nb_input_bits;
-    if (q->isOpen() && nb > 0) {
-      int addr = q->dataAddress (map->start_input_bits);
-      uint8_t * dest = map->tab_input_bits;
+        if (n < 0) {
 
-      return  q->readDiscreteInputs (addr, (bool *) dest, nb);
+          return n;
+        }
+        rc += n;
+      }
     }
-    return 0;
+    return rc;
   }
 
   // ---------------------------------------------------------------------------
-  int BufferedSlave::Private::updateCoilBlockFromSlave() {
-    PIMP_Q (Slave);
+  // writes all the blocks of the table t to the slave
+  int BufferedSlave::Private::updateSlaveFromBlock (Table t) {
+    PIMP_Q (BufferedSlave);
+    int rc = 0;
 
-    int nb = map->nb_bits;
-    if (q->isOpen() && nb > 0) {
-      int addr = q->dataAddress (map->start_bits);
-      uint8_t * dest = map->tab_bits;
+    if (q->isOpen()) {
 
-      return  q->readCoils (addr, (bool *) dest, nb);
-    }
-    return 0;
-  }
+      for (const auto & e : blocks[t].index) {
+        int addr = q->dataAddress (e.start);
+        int nb = e.end - e.start;
+        int n;
 
-  // ---------------------------------------------------------------------------
-  int BufferedSlave::Private::updateHoldingRegisterBlockFromSlave() {
-    PIMP_Q (Slave);
+        if (t == Coil) {
+          uint8_t * src = findBits (t, e.start, nb);
+
+          n = q->writeCoils (addr, (bool *) src, nb);
+        }
+        else {
+          uint16_t * src = findRegisters (t, e.start, nb);
+
+          n = q->writeRegisters (addr, src, nb);
+        }
 
-    int nb = map->nb_registers;
-    if (q->isOpen() && nb > 0) {
-      int addr = q->dataAddress (map->start_registers);
-      uint16_t * dest = map->tab_registers;
+        if (n < 0) {
 
-      return  q->readRegisters (addr, dest, nb);
+          return n;
+        }
+        rc += n;
+      }
     }
-    return 0;
+    return rc;
   }
 
   // ---------------------------------------------------------------------------
-  int BufferedSlave::Private::updateInputRegisterBlockFromSlave() {
-    PIMP_Q (Slave);
+  // returns the registers [addr, addr + nb[ of the table t, nullptr if they
+  // are not in a single block, addr is a PDU address
+  uint16_t * BufferedSlave::Private::registers (Table t, int addr, int nb) {
+    int n = nb;
+    uint16_t * tab = findRegisters (t, addr, n);
 
-    int nb = map->nb_input_registers;
-    if (q->isOpen() && nb > 0) {
-      int addr = q->dataAddress (map->start_input_registers);
-      uint16_t * dest = map->tab_input_registers;
+    if (tab && nb > 0 && n == nb) {
 
-      return  q->readInputRegisters (addr, dest, nb);
+      return tab;
     }
-    return 0;
+    return nullptr;
   }
-
   // ---------------------------------------------------------------------------
-  int BufferedSlave::Private::updateSlaveCoilFromBlock() {
-    PIMP_Q (Slave);
+  // returns a copy of the nb values [addr, addr + nb[ of the table t checked
+  // by a subscription, a bit being 0 or 1 in a register, nullptr if they are
+  // not in a single block. The values compared are never half-written,
+  // subscriptionsMutex must be locked
+  const uint16_t * BufferedSlave::Private::subscriptionImage (Table t, int addr, int nb) {
+    int n = nb;
 
-    int nb = map->nb_bits;
-    if (q->isOpen() && nb > 0) {
-      int addr = q->dataAddress (map->start_bits);
-      uint8_t * src = map->tab_bits;
+    if (nb <= 0) {
 
-      if (nb == 1) {
+      return nullptr;
+    }
+    subscriptionRegisters.resize (nb);
+    if (t == Coil || t == DiscreteInput) {
+      const uint8_t * bits = findBits (t, addr, n);
+
+      if (!bits || n != nb) {
 
-        return q->writeCoil (addr, src[0] != 0);
+        return nullptr;
       }
-      else {
+      seqlock.read ([this, bits, nb] {
+        for (int i = 0; i < nb; i++) {
+          subscriptionRegisters[i] = bits[i] ? 1 : 0;
+        }
+      });
+    }
+    else {
+      const uint16_t * regs = findRegisters (t, addr, n);
+
+      if (!regs || n != nb) {
 
-        return  q->writeCoils (addr, (bool *) src, nb);
+        return nullptr;
       }
+      seqlock.read ([this, regs, nb] {
+        memcpy (subscriptionRegisters.data(), regs, nb * sizeof (uint16_t));
+      });
     }
-    return 0;
+    return subscriptionRegisters.data();
   }
 
   // ---------------------------------------------------------------------------
-  int BufferedSlave::Private::updateSlaveHoldingRegisterFromBlock() {
-    PIMP_Q (Slave);
+  // checks the subscriptions overlapping the data [addr, addr + nb[
+  // of the table t, addr is a PDU address
+  int BufferedSlave::Private::notify (Table t, int addr, int nb) {
+    PIMP_Q (BufferedSlave);
+    int count = 0;
+    std::lock_guard<std::mutex> lock (subscriptionsMutex);
 
-    int nb = map->nb_registers;
-    if (q->isOpen() && nb > 0) {
-      int addr = q->dataAddress (map->start_registers);
-      uint16_t * src = map->tab_registers;
+    for (auto & s : subscriptions) {
 
-      if (nb == 1) {
+      if (s->table() == t) {
+        int start = q->pduAddress (s->address());
 
-        return q->writeRegister (addr, src[0]);
-      }
-      else {
+        if (start < (addr + nb) && addr < (start + s->size())) {
+          const uint16_t * image = subscriptionImage (t, start, s->size());
 
-        return  q->writeRegisters (addr, src, nb);
+          if (image && s->check (image)) {
+
+            count++;
+          }
+        }
       }
     }
-    return 0;
+    return count;
   }
 
   // ---------------------------------------------------------------------------
@@ -848,7 +2783,7 @@ namespace Modbus {
 
           if ( (map->tab_registers) && (nmemb > map->nb_registers)) {
 
-            memset (&map->tab_registers[map->nb_registers * sizeof (uint16_t)],
+            memset (&map->tab_registers[map->nb_registers],
                     0, (nmemb - map->nb_registers) * sizeof (uint16_t));
           }
         }
@@ -892,7 +2827,7 @@ namespace Modbus {
 
           if ( (map->tab_input_registers) && (nmemb > map->nb_input_registers)) {
 
-            memset (&map->tab_input_registers[map->nb_input_registers * sizeof (uint16_t)],
+            memset (&map->tab_input_registers[map->nb_input_registers],
                     0, (nmemb - map->nb_input_registers) * sizeof (uint16_t));
           }
         }
@@ -921,6 +2856,7 @@ namespace Modbus {
 
       setConfig (reinterpret_cast<Slave *> (s), j);
       if (j.contains ("blocks")) {
+        std::set<Table> tables;
 
         auto blocks = j["blocks"];
         for (const auto & block : blocks) {
@@ -942,7 +2878,15 @@ namespace Modbus {
             nmemb *= dt.size() / sizeof (uint16_t);
           }
 
-          s->setBlock (table, nmemb, startAddr);
+          // the first block of a table is the block of the map
+          if (tables.insert (table).second) {
+
+            s->setBlock (table, nmemb, startAddr);
+          }
+          else {
+
+            s->addBlock (table, nmemb, startAddr);
+          }
 
           if (block.contains ("values")) {
 
@@ -960,6 +2904,17 @@ namespace Modbus {
 
         }
       }
+
+      // the values of the file replace the initial values of the blocks
+      if (j.contains ("persistent-file")) {
+        int interval = 1000;
+
+        if (j.contains ("flush-interval")) {
+
+          j["flush-interval"].get_to (interval);
+        }
+        s->setPersistentFile (j["persistent-file"].get<std::string>(), interval);
+      }
     }
 
 
@@ -16,37 +16,163 @@
  */
 #pragma once
 
+#include <map>
+#include <array>
 #include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
 #include <modbuspp/bufferedslave.h>
 #include "slave_p.h"
+#include "seqlock_p.h"
+#include "sharedmap_p.h"
+#include "persistentfile_p.h"
+#include "filerecord_p.h"
 
 namespace Modbus {
 
   class BufferedSlave::Private : public Slave::Private {
 
     public:
+      // block added by addBlock()
+      struct Block {
+        int start; // PDU address
+        int size;
+        std::vector<uint8_t> bits;
+        std::vector<uint16_t> registers;
+      };
+
+      // block of the index, [start, end[ in PDU addresses
+      struct Entry {
+        int start;
+        int end;
+        int block; // index in Blocks::added, -1 for the block of the map
+      };
+
+      // blocks of a table, the index is sorted by addresses and the page p
+      // gives the first entry ending after the address p << PageBits
+      struct Blocks {
+        std::vector<Block> added;
+        std::vector<Entry> index;
+        std::vector<uint16_t> pages;
+      };
+
+      static const int PageBits = 8;
+
+      // freshness of a block of the index read from the device
+      struct Freshness {
+        std::chrono::steady_clock::time_point time; // of the last read, 0 if none
+        bool refreshing; // read by the revalidator
+      };
+
       Private (BufferedSlave * q);
       Private (BufferedSlave * q, int s, Device * d);
       virtual ~Private();
-      
+
+      static bool isTable (Table t) {
+        return t == DiscreteInput || t == Coil ||
+               t == InputRegister || t == HoldingRegister;
+      }
+
+      int addBlock (Table t, int addr, int nmemb);
+      int removeBlock (Table t, int addr);
+      bool overlaps (Table t, int addr, int nmemb) const;
+      void mapBlock (Table t, int & start, int & size) const;
+      void updateIndex (Table t);
+      const Entry * find (Table t, int addr) const;
+      uint8_t * findBits (Table t, int addr, int & nb);
+      uint16_t * findRegisters (Table t, int addr, int & nb);
+      modbus_mapping_t * replyMap (const Request & req);
+      modbus_mapping_t * snapshot (modbus_mapping_t * m, const Request & req);
+      int reply (modbus_t * ctx, const Request & req, int len);
+      int reply (const Request & req, Response & rsp);
+      int write (const Request & req, Response & rsp);
+      RecordFile * findFile (int file, int record, int nb);
+      const FunctionHandler * handler (int function) const {
+        return (!handlers.empty() && handlers[function & 0xFF]) ?
+               &handlers[function & 0xFF] : nullptr;
+      }
+      template <typename T> void copy (T * dest, const T * src, int n);
+      void ** mapData (Table t);
+      bool attach (const std::string & name);
+      void detach();
       int setDiscreteInputBlock (int addr, int nmemb);
       int setCoilBlock (int addr, int nmemb);
       int setHoldingRegisterBlock (int addr, int nmemb);
       int setInputRegisterBlock (int addr, int nmemb);
-      int updateDiscreteInputBlockFromSlave();
-      int updateCoilBlockFromSlave();
-      int updateHoldingRegisterBlockFromSlave();
-      int updateInputRegisterBlockFromSlave();
-      int updateSlaveCoilFromBlock();
-      int updateSlaveHoldingRegisterFromBlock();
+      int updateBlockFromSlave (Table t);
+      int updateSlaveFromBlock (Table t);
+      uint16_t * registers (Table t, int addr, int nb);
+      int notify (Table t, int addr, int nb);
+      const uint16_t * subscriptionImage (Table t, int addr, int nb);
+      void written (Table t, int addr, int nb);
+      void signal();
+      int openPersistentFile (const std::string & path);
+      void closePersistentFile();
+      std::vector<PersistentFormat::Block> persistentBlocks();
+      void collect (std::vector<uint8_t> & data);
+      void restore (const std::vector<uint8_t> & data);
+      bool flush();
+      void flusher();
+      bool isCached() const {
+        return maxAge.count() > 0;
+      }
+      int fetch (Table t, int addr, int nb);
+      int refresh (Table t, int addr);
+      void revalidator();
 
       modbus_mapping_t * map;
+      modbus_mapping_t scratch; // map of the block addressed by a request
+      std::array<Blocks, HoldingRegister + 1> blocks;
+      SeqLock seqlock; // data of the blocks
+      SharedMapFormat::Segment shm; // holds the blocks of the map if open
+      modbus_mapping_t image; // map of the copy of the data read by a request
+      std::vector<uint8_t> bitImage;
+      std::vector<uint16_t> registerImage;
       std::vector<uint8_t> idReport;
       Message::Callback beforeReplyCB;
       Message::Callback afterReplyCB;
+      std::vector<std::shared_ptr<Subscription>> subscriptions;
+      std::vector<uint16_t> subscriptionRegisters; // copy of the range checked
+      std::mutex subscriptionsMutex;
+      // addresses written by the clients, a bit per PDU address of the
+      // coils and the holding registers
+      std::array<std::vector<uint64_t>, HoldingRegister + 1> dirty;
+      std::array<bool, HoldingRegister + 1> pending;
+      mutable std::mutex changesMutex;  // dirty, pending and changesFd
+      std::condition_variable changesCond;
+      int changesFd; // eventfd, -1 if not created
+      // coils and holding registers saved in a file
+      PersistentFile persistent;
+      std::vector<uint8_t> flushed; // values of the last snapshot
+      std::mutex fileMutex; // persistent and flushed
+      std::thread flushThread;
+      std::mutex flushMutex; // flush* flags
+      std::condition_variable flushCond;
+      std::chrono::milliseconds flushInterval;
+      bool flushOnWrite;
+      bool flushRequested;
+      bool flushStop;
+      // cache of the values read from the device
+      std::chrono::milliseconds maxAge; // 0 if disabled
+      bool staleWhileRevalidate;
+      std::array<std::vector<Freshness>, HoldingRegister + 1> freshness;
+      std::mutex cacheMutex; // freshness and stale
+      std::condition_variable cacheCond;
+      std::vector<std::pair<Table, int>> stale; // blocks to revalidate
+      std::thread revalidatorThread;
+      bool revalidatorStop;
+      // files of records
+      std::map<int, std::shared_ptr<RecordFile>> files;
+      mutable std::mutex filesMutex; // files and their records
+      // handlers indexed by function code, empty if none
+      std::vector<FunctionHandler> handlers;
+      Device * server; // replying for the slave, nullptr if none
 
       PIMP_DECLARE_PUBLIC (BufferedSlave)
   };
+
 }
 
 /* ========================================================================== */
@@ -0,0 +1,522 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <modbuspp/message.h>
+#include <modbuspp/rtulayer.h>
+#include "capture_p.h"
+#include "config.h"
+
+namespace Modbus {
+
+  // ---------------------------------------------------------------------------
+  //
+  //                         Capture Class
+  //
+  // ---------------------------------------------------------------------------
+
+  // ---------------------------------------------------------------------------
+  Capture::Capture (Capture::Private &dd) : d_ptr (&dd) {}
+
+  // ---------------------------------------------------------------------------
+  Capture::Capture () : d_ptr (new Private (this)) {}
+
+  // ---------------------------------------------------------------------------
+  Capture::Capture (const std::string & path, Net net, Format format) : Capture () {
+
+    if (! open (path, net, format)) {
+
+      throw std::runtime_error ("Unable to open the capture file " + path);
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  Capture::~Capture() {
+
+    close();
+  }
+
+  // ---------------------------------------------------------------------------
+  bool Capture::open (const std::string & path, Net net, Format format, size_t capacity) {
+    PIMP_D (Capture);
+
+    if (isOpen()) {
+
+      close();
+    }
+    return d->open (path, net, format, capacity);
+  }
+
+  // ---------------------------------------------------------------------------
+  void Capture::close() {
+    PIMP_D (Capture);
+
+    d->close();
+  }
+
+  // ---------------------------------------------------------------------------
+  bool Capture::isOpen() const {
+    PIMP_D (const Capture);
+
+    return d->running;
+  }
+
+  // ---------------------------------------------------------------------------
+  const std::string & Capture::path() const {
+    PIMP_D (const Capture);
+
+    return d->path;
+  }
+
+  // ---------------------------------------------------------------------------
+  Net Capture::net() const {
+    PIMP_D (const Capture);
+
+    return d->net;
+  }
+
+  // ---------------------------------------------------------------------------
+  bool Capture::record (const uint8_t * adu, size_t len, Direction dir,
+                        bool response, uint64_t timestamp) {
+    PIMP_D (Capture);
+
+    return d->push (adu, len, dir, response, true, timestamp);
+  }
+
+  // ---------------------------------------------------------------------------
+  bool Capture::record (const Message & msg, Direction dir) {
+
+    return record (msg.adu(), msg.aduSize(), dir, msg.isResponse());
+  }
+
+  // ---------------------------------------------------------------------------
+  bool Capture::recordPdu (const uint8_t * data, size_t len, Direction dir,
+                           bool response, uint64_t timestamp) {
+    PIMP_D (Capture);
+
+    return d->push (data, len, dir, response, false, timestamp);
+  }
+
+  // ---------------------------------------------------------------------------
+  void Capture::setSampling (unsigned int n) {
+    PIMP_D (Capture);
+
+    d->sampling = std::max (n, 1U);
+  }
+
+  // ---------------------------------------------------------------------------
+  unsigned int Capture::sampling() const {
+    PIMP_D (const Capture);
+
+    return d->sampling;
+  }
+
+  // ---------------------------------------------------------------------------
+  void Capture::setSlaveFilter (int slave) {
+    PIMP_D (Capture);
+
+    d->slave = slave;
+  }
+
+  // ---------------------------------------------------------------------------
+  int Capture::slaveFilter() const {
+    PIMP_D (const Capture);
+
+    return d->slave;
+  }
+
+  // ---------------------------------------------------------------------------
+  void Capture::setFunctionFilter (Function func, bool enable) {
+    PIMP_D (Capture);
+    uint8_t fc = func & 0x7F;
+    uint64_t m = uint64_t (1) << (fc % 64);
+
+    if (enable) {
+
+      d->functions[fc / 64].fetch_or (m);
+    }
+    else {
+
+      d->functions[fc / 64].fetch_and (~m);
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  void Capture::setFunctionFilter (bool enable) {
+    PIMP_D (Capture);
+
+    for (auto & f : d->functions) {
+
+      f = enable ? ~uint64_t (0) : 0;
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  unsigned long Capture::captured() const {
+    PIMP_D (const Capture);
+
+    return d->captured;
+  }
+
+  // ---------------------------------------------------------------------------
+  unsigned long Capture::dropped() const {
+    PIMP_D (const Capture);
+
+    return d->dropped;
+  }
+
+  // ---------------------------------------------------------------------------
+  // static
+  uint64_t Capture::now() {
+
+    return std::chrono::duration_cast<std::chrono::nanoseconds> (
+             std::chrono::system_clock::now().time_since_epoch()).count();
+  }
+
+  // ---------------------------------------------------------------------------
+  //
+  //                         Capture::Private Class
+  //
+  // ---------------------------------------------------------------------------
+
+  // ---------------------------------------------------------------------------
+  Capture::Private::Private (Capture * q) :
+    q_ptr (q), net (NoNet), format (Pcap), running (false), sampling (1),
+    sampleCount (0), slave (-1), captured (0), dropped (0), ipId (0) {
+
+    for (auto & f : functions) {
+
+      f = ~uint64_t (0);
+    }
+    tcpSeq[0] = tcpSeq[1] = 1;
+  }
+
+  // ---------------------------------------------------------------------------
+  Capture::Private::~Private() = default;
+
+  // ---------------------------------------------------------------------------
+  bool Capture::Private::open (const std::string & p, Net n, Format f, size_t capacity) {
+
+    if ( (n != Tcp && n != Rtu) || capacity == 0) {
+
+      errno = EINVAL;
+      return false;
+    }
+
+    file.open (p, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+
+      return false;
+    }
+
+    path = p;
+    net = n;
+    format = f;
+    ring.reset (new RingBuffer<Frame> (capacity));
+    tcpSeq[0] = tcpSeq[1] = 1;
+    ipId = 0;
+    writeHeader();
+    file.flush();
+
+    running = true;
+    thread = std::thread (writer, this);
+    return true;
+  }
+
+  // ---------------------------------------------------------------------------
+  void Capture::Private::close() {
+
+    if (running) {
+
+      {
+        std::lock_guard<std::mutex> lock (mutex);
+        running = false;
+      }
+      cond.notify_one();
+      thread.join();
+      file.close();
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // filtering and sampling, called by the producers
+  bool Capture::Private::accept (const uint8_t * data, size_t len, bool complete) {
+    size_t i = (complete && net == Tcp) ? 6 : 0; // slave address
+    int s = slave.load (std::memory_order_relaxed);
+    unsigned int n = sampling.load (std::memory_order_relaxed);
+
+    if (len < (i + 2)) {
+
+      return false;
+    }
+
+    if (s >= 0 && data[i] != s) {
+
+      return false;
+    }
+
+    uint8_t fc = data[i + 1] & 0x7F;
+    if ( ( (functions[fc / 64].load (std::memory_order_relaxed) >> (fc % 64)) & 1) == 0) {
+
+      return false;
+    }
+
+    return n <= 1 || (sampleCount.fetch_add (1, std::memory_order_relaxed) % n) == 0;
+  }
+
+  // ---------------------------------------------------------------------------
+  bool Capture::Private::push (const uint8_t * data, size_t len, Direction dir,
+                               bool response, bool complete, uint64_t timestamp) {
+
+    if (!running.load (std::memory_order_relaxed) || len > MaxAduLength ||
+        !accept (data, len, complete)) {
+
+      return false;
+    }
+
+    if (timestamp == 0) {
+
+      timestamp = Capture::now();
+    }
+
+    bool ok = ring->push ([&] (Frame & f) {
+      f.timestamp = timestamp;
+      f.len = len;
+      f.dir = dir;
+      f.response = response;
+      f.complete = complete;
+      std::memcpy (f.data.data(), data, len);
+    });
+
+    if (ok) {
+
+      captured.fetch_add (1, std::memory_order_relaxed);
+    }
+    else {
+
+      dropped.fetch_add (1, std::memory_order_relaxed);
+    }
+    return ok;
+  }
+
+  // ---------------------------------------------------------------------------
+  // static
+  void Capture::Private::writer (Private * d) {
+    auto write = [d] (Frame & f) {
+      d->writeFrame (f);
+    };
+
+    for (;;) {
+      bool stop = !d->running;
+
+      if (!d->ring->pop (write)) {
+
+        if (stop) {
+
+          break;
+        }
+        // the producers do not notify, the queue is polled when idle
+        d->file.flush();
+        std::unique_lock<std::mutex> lock (d->mutex);
+        d->cond.wait_for (lock, std::chrono::milliseconds (50), [d] {
+          return !d->running;
+        });
+      }
+    }
+    d->file.flush();
+  }
+
+  // ---------------------------------------------------------------------------
+  void Capture::Private::put16 (uint16_t v) {
+
+    file.write (reinterpret_cast<const char *> (&v), sizeof (v));
+  }
+
+  // ---------------------------------------------------------------------------
+  void Capture::Private::put32 (uint32_t v) {
+
+    file.write (reinterpret_cast<const char *> (&v), sizeof (v));
+  }
+
+  // ---------------------------------------------------------------------------
+  // host byte order, the readers use the magic number to detect it
+  void Capture::Private::writeHeader() {
+    using namespace CaptureFormat;
+    uint32_t linkType = (net == Tcp) ? LinkTypeRaw : LinkTypeUser0;
+
+    if (format == Pcap) {
+
+      put32 (PcapMagicNs);
+      put16 (2); // version
+      put16 (4);
+      put32 (0); // thiszone
+      put32 (0); // sigfigs
+      put32 (SnapLength);
+      put32 (linkType);
+    }
+    else {
+
+      // Section Header Block
+      put32 (SectionHeader);
+      put32 (28);
+      put32 (0x1A2B3C4D); // byte order magic
+      put16 (1); // version
+      put16 (0);
+      put32 (0xFFFFFFFF); // unspecified section length
+      put32 (0xFFFFFFFF);
+      put32 (28);
+
+      // Interface Description Block, nanosecond timestamps
+      put32 (InterfaceDescription);
+      put32 (32);
+      put16 (linkType);
+      put16 (0);
+      put32 (SnapLength);
+      put16 (9); // if_tsresol
+      put16 (1);
+      put32 (9); // 10^-9, padded
+      put32 (0); // opt_endofopt
+      put32 (32);
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  void Capture::Private::writeFrame (const Frame & f) {
+    using namespace CaptureFormat;
+    std::array < uint8_t, IpTcpHeaderLength + 7 + MaxAduLength + 2 > buf;
+    uint8_t * adu = buf.data() + IpTcpHeaderLength;
+    size_t len = f.len;
+
+    // ADU
+    if (f.complete) {
+
+      std::memcpy (adu, f.data.data(), len);
+    }
+    else if (net == Tcp) {
+
+      adu[0] = adu[1] = 0; // transaction identifier
+      adu[2] = adu[3] = 0; // protocol identifier
+      adu[4] = len >> 8;
+      adu[5] = len & 0xFF;
+      std::memcpy (adu + 6, f.data.data(), len);
+      len += 6;
+    }
+    else {
+      uint16_t crc = RtuLayer::crc16 (f.data.data(), len);
+
+      std::memcpy (adu, f.data.data(), len);
+      adu[len++] = crc >> 8;
+      adu[len++] = crc & 0xFF;
+    }
+
+    uint8_t * pkt = adu;
+    if (net == Tcp) {
+      // the requests go from the client to the server
+      bool toServer = !f.response;
+      uint8_t client[4] = { 10, 0, 0, 2 };
+      uint8_t server[4] = { 10, 0, 0, 1 };
+      uint16_t sport = toServer ? ClientPort : ServerPort;
+      uint16_t dport = toServer ? ServerPort : ClientPort;
+      uint32_t seq = tcpSeq[toServer ? 0 : 1];
+      uint32_t ack = tcpSeq[toServer ? 1 : 0];
+      uint16_t total = IpTcpHeaderLength + len;
+      uint32_t sum = 0;
+
+      pkt = buf.data();
+      // IPv4 header
+      pkt[0] = 0x45;
+      pkt[1] = 0;
+      pkt[2] = total >> 8;
+      pkt[3] = total & 0xFF;
+      pkt[4] = ipId >> 8;
+      pkt[5] = ipId & 0xFF;
+      pkt[6] = 0x40; // don't fragment
+      pkt[7] = 0;
+      pkt[8] = 64; // ttl
+      pkt[9] = 6;  // tcp
+      pkt[10] = pkt[11] = 0;
+      std::memcpy (&pkt[12], toServer ? client : server, 4);
+      std::memcpy (&pkt[16], toServer ? server : client, 4);
+      for (int i = 0; i < 20; i += 2) {
+
+        sum += (pkt[i] << 8) | pkt[i + 1];
+      }
+      while (sum >> 16) {
+
+        sum = (sum & 0xFFFF) + (sum >> 16);
+      }
+      sum = ~sum & 0xFFFF;
+      pkt[10] = sum >> 8;
+      pkt[11] = sum & 0xFF;
+
+      // TCP header, the checksum is not computed
+      uint8_t * tcp = pkt + 20;
+      tcp[0] = sport >> 8;
+      tcp[1] = sport & 0xFF;
+      tcp[2] = dport >> 8;
+      tcp[3] = dport & 0xFF;
+      for (int i = 0; i < 4; i++) {
+
+        tcp[4 + i] = seq >> (24 - 8 * i);
+        tcp[8 + i] = ack >> (24 - 8 * i);
+      }
+      tcp[12] = 5 << 4; // header length
+      tcp[13] = 0x18;   // PSH, ACK
+      tcp[14] = tcp[15] = 0xFF; // window
+      tcp[16] = tcp[17] = 0; // checksum
+      tcp[18] = tcp[19] = 0; // urgent pointer
+
+      tcpSeq[toServer ? 0 : 1] += len;
+      ipId++;
+      len += IpTcpHeaderLength;
+    }
+
+    if (format == Pcap) {
+
+      put32 (f.timestamp / 1000000000);
+      put32 (f.timestamp % 1000000000);
+      put32 (len);
+      put32 (len);
+      file.write (reinterpret_cast<const char *> (pkt), len);
+    }
+    else {
+      size_t padding = (4 - len % 4) % 4;
+      uint32_t blockLength = 44 + len + padding;
+      static const char zero[4] = {0};
+
+      // Enhanced Packet Block
+      put32 (EnhancedPacket);
+      put32 (blockLength);
+      put32 (0); // interface
+      put32 (f.timestamp >> 32);
+      put32 (f.timestamp & 0xFFFFFFFF);
+      put32 (len);
+      put32 (len);
+      file.write (reinterpret_cast<const char *> (pkt), len);
+      file.write (zero, padding);
+      put16 (2); // epb_flags
+      put16 (4);
+      put32 (f.dir == Received ? 1 : 2); // inbound or outbound
+      put32 (0); // opt_endofopt
+      put32 (blockLength);
+    }
+  }
+}
+
+/* ========================================================================== */
@@ -0,0 +1,98 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+#include <modbuspp/capture.h>
+#include "ringbuffer_p.h"
+
+namespace Modbus {
+
+  namespace CaptureFormat {
+
+    const uint32_t PcapMagicNs = 0xA1B23C4D;
+    const uint32_t LinkTypeRaw = 101;    // raw IPv4
+    const uint32_t LinkTypeUser0 = 147;  // DLT_USER0
+    const uint32_t SnapLength = 65535;
+    const uint16_t ServerPort = 502;
+    const uint16_t ClientPort = 49152;
+    const size_t IpTcpHeaderLength = 40;
+
+    // pcapng block types
+    const uint32_t SectionHeader = 0x0A0D0D0A;
+    const uint32_t InterfaceDescription = 0x00000001;
+    const uint32_t EnhancedPacket = 0x00000006;
+  }
+
+  class Capture::Private {
+
+    public:
+      // frame waiting in the ring buffer
+      struct Frame {
+        uint64_t timestamp;
+        uint16_t len;
+        uint8_t dir;
+        bool response;
+        bool complete;   // false if the header or the CRC must be added
+        std::array<uint8_t, MaxAduLength> data;
+      };
+
+      Private (Capture * q);
+      virtual ~Private();
+      bool open (const std::string & path, Net net, Format format, size_t capacity);
+      void close();
+      bool accept (const uint8_t * data, size_t len, bool complete);
+      bool push (const uint8_t * data, size_t len, Direction dir, bool response,
+                 bool complete, uint64_t timestamp);
+
+      // writer thread
+      static void writer (Private * d);
+      void writeHeader();
+      void writeFrame (const Frame & f);
+      void put16 (uint16_t v);
+      void put32 (uint32_t v);
+
+      Capture * const q_ptr;
+      std::string path;
+      Net net;
+      Format format;
+      std::unique_ptr<RingBuffer<Frame>> ring;
+      std::ofstream file;
+      std::thread thread;
+      std::mutex mutex;
+      std::condition_variable cond;
+      std::atomic<bool> running;
+      std::atomic<unsigned int> sampling;
+      std::atomic<unsigned int> sampleCount;
+      std::atomic<int> slave;
+      std::array<std::atomic<uint64_t>, 4> functions; // bitmap of 256 functions
+      std::atomic<unsigned long> captured;
+      std::atomic<unsigned long> dropped;
+      // synthetic TCP sequence numbers, client to server and server to client
+      uint32_t tcpSeq[2];
+      uint16_t ipId;
+
+      PIMP_DECLARE_PUBLIC (Capture)
+  };
+}
+
+/* ========================================================================== */
@@ -17,6 +17,8 @@
 #include <modbuspp/rtulayer.h>
 #include <modbuspp/tcplayer.h>
 #include <modbuspp/message.h>
+#include <modbuspp/capture.h>
+#include <modbuspp/logger.h>
 #include "device_p.h"
 #include "config.h"
 #include <chrono>
@@ -342,6 +344,34 @@ namespace Modbus {
     return d->debug;
   }
 
+  // ---------------------------------------------------------------------------
+  void Device::setCapture (Capture * capture) {
+    PIMP_D (Device);
+
+    d->capture = capture;
+  }
+
+  // ---------------------------------------------------------------------------
+  Capture * Device::capture() const {
+    PIMP_D (const Device);
+
+    return d->capture;
+  }
+
+  // ---------------------------------------------------------------------------
+  void Device::setLogger (Logger * logger) {
+    PIMP_D (Device);
+
+    d->logger = logger;
+  }
+
+  // ---------------------------------------------------------------------------
+  Logger & Device::logger() const {
+    PIMP_D (const Device);
+
+    return d->log();
+  }
+
   // ---------------------------------------------------------------------------
   Net Device::net() const {
 
@@ -362,6 +392,7 @@ namespace Modbus {
 
     if (isValid()) {
       PIMP_D (Device);
+      std::lock_guard<std::recursive_mutex> lock (d->transaction);
       int rc;
 
       if (prepareBefore) {
@@ -375,8 +406,7 @@ namespace Modbus {
 
       if (d->debug) {
 
-        msg->print (std::cout, '[', ']');
-        std::cout << std::endl;
+        d->log().hex (Logger::Debug, msg->adu(), msg->aduSize(), '[', ']');
       }
 
       do {
@@ -406,7 +436,12 @@ namespace Modbus {
       }
       while (d->recoveryLink && rc == -1 && !msg->isResponse());
 
-      if (rc > 0 && rc != msg->size()) {
+      if (rc > 0 && d->capture) {
+
+        d->capture->record (*msg, Capture::Sent);
+      }
+
+      if (rc > 0 && rc != static_cast<int> (msg->aduSize())) {
 
         errno = EMBBADDATA;
         return -1;
@@ -439,7 +474,7 @@ namespace Modbus {
   // ---------------------------------------------------------------------------
   Device::Private::Private (Device * q) :
     q_ptr (q), isOpen (false), backend (0), recoveryLink (false),
-    debug (false) {}
+    debug (false), capture (nullptr), logger (nullptr) {}
 
   // ---------------------------------------------------------------------------
   Device::Private::~Private() {
@@ -470,10 +505,15 @@ namespace Modbus {
       // std::cout << "config > " << config << std::endl; // debug
       setConfig (config);
       if (debug) {
-        std::ostringstream oss;
-        std::cout << "----=== [" << jsonfile << "] ===----" << std::endl;
-        oss << std::setw (2) << j;
-        std::cout << oss.str() << std::endl << std::endl;
+
+        // formatted by the logger thread
+        log().log (Logger::Debug, [jsonfile, j] {
+          std::ostringstream oss;
+
+          oss << "----=== [" << jsonfile << "] ===----" << std::endl;
+          oss << std::setw (2) << j << std::endl;
+          return oss.str();
+        });
       }
 
     }
@@ -556,16 +596,22 @@ namespace Modbus {
   void Device::Private::printError (const char * what) const {
 
     if (debug) {
+      std::string s (modbus_strerror (errno));
 
-      std::cerr << "ERROR " << modbus_strerror (errno);
       if (what) {
 
-        std::cerr << ": " << what;
+        s.append (": ").append (what);
       }
-      std::cerr << std::endl;
+      log().log (Logger::Error, s);
     }
   }
 
+  // ---------------------------------------------------------------------------
+  Logger & Device::Private::log() const {
+
+    return logger ? *logger : Logger::global();
+  }
+
   // ---------------------------------------------------------------------------
   //
   //                        Modbus::Json Namespace
@@ -18,6 +18,7 @@
 
 #include <fstream>
 #include <exception>
+#include <mutex>
 #include <modbuspp/device.h>
 #include <modbuspp/netlayer.h>
 #include "json_p.h"
@@ -47,12 +48,18 @@ namespace Modbus {
       int defaultSlave (int addr) const;
       bool isConnected () const;
       void printError (const char * what = nullptr) const;
+      Logger & log() const;
 
       Device * const q_ptr;
       bool isOpen;
       NetLayer * backend;
       bool recoveryLink;
       bool debug;
+      Capture * capture;
+      Logger * logger;
+      // held from a request to its response, the slaves and the threads of
+      // the application share the backend
+      std::recursive_mutex transaction;
 
       PIMP_DECLARE_PUBLIC (Device)
   };
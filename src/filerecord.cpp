@@ -0,0 +1,268 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cerrno>
+#include <cstring>
+#ifndef _WIN32
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/select.h>
+#endif
+#include <modbuspp/rtulayer.h>
+#include "filerecord_p.h"
+#include "config.h"
+
+namespace Modbus {
+
+  // ---------------------------------------------------------------------------
+  //
+  //                         FileRecordFormat Namespace
+  //
+  // ---------------------------------------------------------------------------
+  namespace FileRecordFormat {
+
+    // -------------------------------------------------------------------------
+    int parse (const Message & req, std::vector<SubRequest> & subs) {
+      bool write = (req.function() == WriteFileRecord);
+      int size = req.size();
+      int n, i, end, length = 0; // byte count of the response
+
+      subs.clear();
+      if (size < 2) {
+
+        return IllegalDataValue;
+      }
+
+      n = req.byte (1);
+      if (n < (write ? 9 : 7) || n > (write ? MaxWriteLength : MaxReadLength) ||
+          (2 + n) > size) {
+
+        return IllegalDataValue;
+      }
+
+      for (i = 2, end = 2 + n; i < end;) {
+        SubRequest s;
+
+        if ( (end - i) < 7) {
+
+          return IllegalDataValue;
+        }
+        if (req.byte (i) != RefType) {
+
+          return IllegalDataAddress;
+        }
+        s.file = req.word (i + 1);
+        s.record = req.word (i + 3);
+        s.count = req.word (i + 5);
+        s.values = i + 7;
+        if (s.file == 0 || s.count == 0 || (s.record + s.count) > MaxRecords) {
+
+          return IllegalDataAddress;
+        }
+
+        i += 7;
+        if (write) {
+
+          if ( (end - i) < (s.count * 2)) {
+
+            return IllegalDataValue;
+          }
+          i += s.count * 2;
+        }
+        else {
+
+          length += 2 + s.count * 2;
+          if (length > MaxReadLength) {
+
+            return IllegalDataValue;
+          }
+        }
+        subs.push_back (s);
+      }
+      return 0;
+    }
+
+    // -------------------------------------------------------------------------
+    bool readAll (int fd, uint8_t * p, size_t n, double timeout) {
+
+#ifndef _WIN32
+      while (n > 0) {
+        fd_set set;
+        struct timeval tv;
+        int rc;
+
+        FD_ZERO (&set);
+        FD_SET (fd, &set);
+        tv.tv_sec = static_cast<long> (timeout);
+        tv.tv_usec = static_cast<long> ( (timeout - tv.tv_sec) * 1000000);
+        rc = select (fd + 1, &set, nullptr, nullptr, &tv);
+        if (rc == 0) {
+
+          errno = ETIMEDOUT;
+          return false;
+        }
+        if (rc > 0) {
+          ssize_t len = ::read (fd, p, n);
+
+          if (len > 0) {
+
+            p += len;
+            n -= len;
+            continue;
+          }
+          if (len == 0) {
+
+            errno = ECONNRESET;
+            return false;
+          }
+        }
+        if (errno != EINTR) {
+
+          return false;
+        }
+      }
+      return true;
+#else
+      errno = ENOSYS;
+      return false;
+#endif
+    }
+
+    // -------------------------------------------------------------------------
+    int receive (int fd, Net net, uint8_t * adu, double timeout) {
+      size_t len;
+
+      if (net == Tcp) {
+
+        // MBAP header, its length counts the unit identifier and the PDU
+        if (!readAll (fd, adu, 6, timeout)) {
+
+          return -1;
+        }
+        len = (adu[4] << 8) | adu[5];
+        if (len < 3 || (len + 6) > MaxAduLength) {
+
+          errno = EMBBADDATA;
+          return -1;
+        }
+        return readAll (fd, adu + 6, len, timeout) ? len + 6 : -1;
+      }
+
+      // | slave | function | byte count or exception code | ... | crc |
+      if (!readAll (fd, adu, 3, timeout)) {
+
+        return -1;
+      }
+      len = (adu[1] & ExceptionFlag) ? 5 : 5 + adu[2];
+      if (!readAll (fd, adu + 3, len - 3, timeout)) {
+
+        return -1;
+      }
+      if (RtuLayer::crc16 (adu, len - 2) != ( (adu[len - 2] << 8) | adu[len - 1])) {
+
+        errno = EMBBADCRC;
+        return -1;
+      }
+      return len;
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  //
+  //                         RecordFile Class
+  //
+  // ---------------------------------------------------------------------------
+
+  // ---------------------------------------------------------------------------
+  RecordFile::RecordFile() : base (nullptr), records (0), fd (-1) {}
+
+  // ---------------------------------------------------------------------------
+  RecordFile::~RecordFile() {
+
+    close();
+  }
+
+  // ---------------------------------------------------------------------------
+  bool RecordFile::open (int n, const std::string & path) {
+
+    close();
+    if (n <= 0 || n > FileRecordFormat::MaxRecords) {
+
+      errno = EINVAL;
+      return false;
+    }
+
+    if (path.empty()) {
+
+      memory.assign (n, 0);
+      base = memory.data();
+      records = n;
+      return true;
+    }
+
+#ifndef _WIN32
+    size_t len = n * sizeof (uint16_t);
+
+    // the records of an existing file are kept, the new ones are null
+    fd = ::open (path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd >= 0) {
+
+      if (ftruncate (fd, len) == 0) {
+        void * m = mmap (nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+        if (m != MAP_FAILED) {
+
+          base = static_cast<uint16_t *> (m);
+          records = n;
+          return true;
+        }
+      }
+
+      int saved_errno = errno;
+      ::close (fd);
+      fd = -1;
+      errno = saved_errno;
+    }
+#else
+    errno = ENOSYS;
+#endif
+    return false;
+  }
+
+  // ---------------------------------------------------------------------------
+  void RecordFile::close() {
+
+#ifndef _WIN32
+    if (fd >= 0) {
+
+      if (base) {
+
+        msync (base, records * sizeof (uint16_t), MS_SYNC);
+        munmap (base, records * sizeof (uint16_t));
+      }
+      ::close (fd);
+      fd = -1;
+    }
+#endif
+    memory.clear();
+    memory.shrink_to_fit();
+    base = nullptr;
+    records = 0;
+  }
+}
+
+/* ========================================================================== */
@@ -0,0 +1,102 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <modbuspp/message.h>
+
+namespace Modbus {
+
+  /*
+   * Read File Record (20) request:
+   * | fc | byte count | SubRequest * |
+   * SubRequest: | ref type (6) | file (u16) | record (u16) | length (u16) |
+   * response:
+   * | fc | byte count | SubResponse * |
+   * SubResponse: | length (u8) | ref type (6) | values (u16 * length) |
+   *
+   * Write File Record (21) request and response:
+   * | fc | byte count | SubRequest * |
+   * SubRequest: | ref type (6) | file (u16) | record (u16) | length (u16) |
+   *             | values (u16 * length) |
+   *
+   * libmodbus does not know these function codes, the frames are sent and
+   * received here, the values are big endian.
+   */
+  namespace FileRecordFormat {
+
+    const int RefType = 6;
+    const int MaxRecords = 10000; // records 0 to 9999 in a file
+    const int MaxReadLength = 0xF5; // byte count of the read responses
+    const int MaxWriteLength = 0xFB; // byte count of the write requests
+    // registers of a sub-request alone in a request
+    const int MaxReadRegisters = (MaxReadLength - 2) / 2;
+    const int MaxWriteRegisters = (MaxWriteLength - 7) / 2;
+    // requests sent without waiting for the responses, on TCP
+    const int Pipeline = 4;
+
+    struct SubRequest {
+      int file;
+      int record;
+      int count;
+      int values; // PDU offset of the values of a write sub-request
+    };
+
+    // checks a request and returns its sub-requests, the exception code if
+    // it is not valid
+    int parse (const Message & req, std::vector<SubRequest> & subs);
+
+    // reads n bytes from fd, false and errno set if error or if the time out
+    // of timeout seconds between two bytes elapses
+    bool readAll (int fd, uint8_t * p, size_t n, double timeout);
+
+    // receives a response frame (ADU) of one of these function codes,
+    // returns its length, -1 and errno set if error
+    int receive (int fd, Net net, uint8_t * adu, double timeout);
+  }
+
+  // file of records of a BufferedSlave, in memory or mapped from a file in
+  // the host byte order
+  class RecordFile {
+
+    public:
+      RecordFile();
+      ~RecordFile();
+
+      // allocates the records in memory if path is empty, maps path otherwise
+      bool open (int records, const std::string & path = std::string());
+      void close();
+      uint16_t * data() {
+        return base;
+      }
+      int size() const {
+        return records;
+      }
+
+    private:
+      RecordFile (const RecordFile &) = delete;
+      RecordFile & operator= (const RecordFile &) = delete;
+
+      std::vector<uint16_t> memory;
+      uint16_t * base;
+      int records;
+      int fd;
+  };
+}
+
+/* ========================================================================== */
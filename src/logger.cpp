@@ -0,0 +1,389 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <ctime>
+#include <cstring>
+#include <iomanip>
+#include <modbuspp/message.h>
+#include "logger_p.h"
+#include "config.h"
+
+namespace Modbus {
+
+  // ---------------------------------------------------------------------------
+  size_t hexEncode (char * dest, const uint8_t * src, size_t n,
+                    char prefix, char suffix) {
+    static const char digits[] = "0123456789ABCDEF";
+    char * p = dest;
+
+    for (size_t i = 0; i < n; i++) {
+
+      if (prefix) {
+        *p++ = prefix;
+      }
+      *p++ = digits[src[i] >> 4];
+      *p++ = digits[src[i] & 0x0F];
+      if (suffix) {
+        *p++ = suffix;
+      }
+    }
+    return p - dest;
+  }
+
+  // ---------------------------------------------------------------------------
+  std::string hexEncode (const uint8_t * src, size_t n, char prefix, char suffix) {
+    std::string s (n * (2 + (prefix != 0) + (suffix != 0)), ' ');
+
+    if (n) {
+
+      hexEncode (&s[0], src, n, prefix, suffix);
+    }
+    return s;
+  }
+
+  // ---------------------------------------------------------------------------
+  //
+  //                         Logger Class
+  //
+  // ---------------------------------------------------------------------------
+
+  // ---------------------------------------------------------------------------
+  Logger::Logger (Logger::Private &dd) : d_ptr (&dd) {}
+
+  // ---------------------------------------------------------------------------
+  Logger::Logger (Level level, size_t capacity) :
+    d_ptr (new Private (this, level, capacity)) {}
+
+  // ---------------------------------------------------------------------------
+  Logger::~Logger() = default;
+
+  // ---------------------------------------------------------------------------
+  Logger::Level Logger::level() const {
+    PIMP_D (const Logger);
+
+    return static_cast<Level> (d->level.load());
+  }
+
+  // ---------------------------------------------------------------------------
+  void Logger::setLevel (Level level) {
+    PIMP_D (Logger);
+
+    d->level = level;
+  }
+
+  // ---------------------------------------------------------------------------
+  bool Logger::isEnabled (Level level) const {
+    PIMP_D (const Logger);
+
+    return level < Off && level >= d->level.load (std::memory_order_relaxed);
+  }
+
+  // ---------------------------------------------------------------------------
+  void Logger::setSink (std::shared_ptr<Sink> sink) {
+    PIMP_D (Logger);
+    std::lock_guard<std::mutex> lock (d->mutex);
+
+    d->sink = sink;
+  }
+
+  // ---------------------------------------------------------------------------
+  std::shared_ptr<Logger::Sink> Logger::sink() const {
+    PIMP_D (const Logger);
+    std::lock_guard<std::mutex> lock (d->mutex);
+
+    return d->sink;
+  }
+
+  // ---------------------------------------------------------------------------
+  bool Logger::log (Level level, const char * text) {
+    PIMP_D (Logger);
+
+    return isEnabled (level) && d->push (level, [text] (Private::Entry & e) {
+      size_t len = std::strlen (text);
+
+      e.kind = Private::Entry::Text;
+      if (len <= e.data.size()) {
+
+        std::memcpy (e.data.data(), text, len);
+        e.len = len;
+      }
+      else {
+
+        e.str.assign (text, len);
+      }
+    });
+  }
+
+  // ---------------------------------------------------------------------------
+  bool Logger::log (Level level, const std::string & text) {
+
+    return log (level, text.c_str());
+  }
+
+  // ---------------------------------------------------------------------------
+  bool Logger::log (Level level, Formatter f) {
+    PIMP_D (Logger);
+
+    return isEnabled (level) && d->push (level, [&f] (Private::Entry & e) {
+
+      e.kind = Private::Entry::Deferred;
+      e.format = std::move (f);
+    });
+  }
+
+  // ---------------------------------------------------------------------------
+  bool Logger::log (Level level, const Message & msg) {
+    bool rsp = msg.isResponse();
+
+    return hex (level, msg.adu(), msg.aduSize(), rsp ? '[' : '<', rsp ? ']' : '>');
+  }
+
+  // ---------------------------------------------------------------------------
+  bool Logger::hex (Level level, const uint8_t * data, size_t len,
+                    char prefix, char suffix) {
+    PIMP_D (Logger);
+
+    if (len > MaxAduLength) {
+
+      return false;
+    }
+
+    return isEnabled (level) && d->push (level, [ = ] (Private::Entry & e) {
+
+      e.kind = Private::Entry::Hex;
+      e.prefix = prefix;
+      e.suffix = suffix;
+      e.len = len;
+      std::memcpy (e.data.data(), data, len);
+    });
+  }
+
+  // ---------------------------------------------------------------------------
+  void Logger::flush() {
+    PIMP_D (Logger);
+    unsigned long target = d->pushed.load();
+    std::unique_lock<std::mutex> lock (d->mutex);
+
+    d->cond.notify_one();
+    d->written.wait (lock, [d, target] { return d->done >= target; });
+  }
+
+  // ---------------------------------------------------------------------------
+  unsigned long Logger::dropped() const {
+    PIMP_D (const Logger);
+
+    return d->dropped;
+  }
+
+  // ---------------------------------------------------------------------------
+  // static
+  const char * Logger::levelName (Level level) {
+    static const char * names[] = {
+      "TRACE", "DEBUG", "INFO", "WARNING", "ERROR", "OFF"
+    };
+
+    return (level >= Trace && level <= Off) ? names[level] : "";
+  }
+
+  // ---------------------------------------------------------------------------
+  // static
+  uint64_t Logger::now() {
+
+    return std::chrono::duration_cast<std::chrono::microseconds> (
+             std::chrono::system_clock::now().time_since_epoch()).count();
+  }
+
+  // ---------------------------------------------------------------------------
+  // static
+  Logger & Logger::global() {
+    static Logger logger (Debug);
+
+    return logger;
+  }
+
+  // ---------------------------------------------------------------------------
+  //
+  //                         Logger::StreamSink Class
+  //
+  // ---------------------------------------------------------------------------
+
+  // ---------------------------------------------------------------------------
+  Logger::StreamSink::StreamSink (std::ostream & out, std::ostream & err,
+                                  bool timestamps) :
+    m_out (out), m_err (err), m_timestamps (timestamps) {}
+
+  // ---------------------------------------------------------------------------
+  void Logger::StreamSink::write (const Record & r) {
+    std::ostream & os = (r.level >= Warning) ? m_err : m_out;
+
+    if (m_timestamps) {
+      std::time_t t = r.timestamp / 1000000;
+      std::tm tm;
+      char buf[32];
+
+#ifdef _WIN32
+      localtime_s (&tm, &t);
+#else
+      localtime_r (&t, &tm);
+#endif
+      std::strftime (buf, sizeof (buf), "%Y-%m-%d %H:%M:%S", &tm);
+      os << buf << '.' << std::setfill ('0') << std::setw (6)
+         << (r.timestamp % 1000000) << ' ';
+    }
+    if (r.level >= Warning) {
+
+      os << levelName (r.level) << ' ';
+    }
+    os << r.text << '\n';
+  }
+
+  // ---------------------------------------------------------------------------
+  void Logger::StreamSink::flush() {
+
+    m_out.flush();
+    m_err.flush();
+  }
+
+  // ---------------------------------------------------------------------------
+  //
+  //                         Logger::Private Class
+  //
+  // ---------------------------------------------------------------------------
+
+  // ---------------------------------------------------------------------------
+  Logger::Private::Private (Logger * q, Level l, size_t capacity) :
+    q_ptr (q), ring (capacity), level (l), sink (std::make_shared<StreamSink>()),
+    stop (false), pushed (0), done (0), dropped (0) {
+
+    thread = std::thread (writer, this);
+  }
+
+  // ---------------------------------------------------------------------------
+  Logger::Private::~Private() {
+
+    {
+      std::lock_guard<std::mutex> lock (mutex);
+      stop = true;
+    }
+    cond.notify_one();
+    thread.join();
+  }
+
+  // ---------------------------------------------------------------------------
+  template <typename F>
+  bool Logger::Private::push (Level l, F fill) {
+    uint64_t t = Logger::now();
+
+    bool ok = ring.push ([&] (Entry & e) {
+
+      e.timestamp = t;
+      e.level = l;
+      fill (e);
+    });
+
+    if (ok) {
+
+      pushed.fetch_add (1, std::memory_order_release);
+    }
+    else {
+
+      dropped.fetch_add (1, std::memory_order_relaxed);
+    }
+    return ok;
+  }
+
+  // ---------------------------------------------------------------------------
+  // called by the writer thread
+  void Logger::Private::write (Entry & e) {
+    Record r;
+
+    r.level = e.level;
+    r.timestamp = e.timestamp;
+    switch (e.kind) {
+
+      case Entry::Text:
+        if (e.str.empty()) {
+
+          r.text.assign (e.data.data(), e.len);
+        }
+        else {
+
+          r.text.swap (e.str);
+        }
+        break;
+
+      case Entry::Hex:
+        r.text = hexEncode (reinterpret_cast<const uint8_t *> (e.data.data()),
+                            e.len, e.prefix, e.suffix);
+        break;
+
+      case Entry::Deferred:
+        try {
+
+          r.text = e.format();
+        }
+        catch (std::exception & ex) {
+
+          r.text = std::string ("formatting failed: ") + ex.what();
+        }
+        // releases the captured variables
+        e.format = nullptr;
+        break;
+    }
+    e.str.clear();
+
+    if (sink) {
+
+      sink->write (r);
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // static
+  void Logger::Private::writer (Private * d) {
+    auto write = [d] (Entry & e) {
+      d->write (e);
+    };
+    std::unique_lock<std::mutex> lock (d->mutex);
+
+    for (;;) {
+      unsigned long n = 0;
+
+      // the sink is protected by the mutex
+      while (d->ring.pop (write)) {
+        n++;
+      }
+      if (n && d->sink) {
+
+        d->sink->flush();
+      }
+      d->done += n;
+      d->written.notify_all();
+
+      if (d->stop && d->ring.empty()) {
+
+        break;
+      }
+      // the producers do not notify, the queue is polled when idle
+      d->cond.wait_for (lock, std::chrono::milliseconds (50), [d] {
+        return d->stop || !d->ring.empty();
+      });
+    }
+  }
+}
+
+/* ========================================================================== */
@@ -0,0 +1,74 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <modbuspp/logger.h>
+#include "ringbuffer_p.h"
+
+namespace Modbus {
+
+  class Logger::Private {
+
+    public:
+      // message waiting in the ring buffer
+      struct Entry {
+        enum Kind {
+          Text,     // text in data if it fits, in str otherwise
+          Hex,      // bytes in data
+          Deferred  // formatted by format
+        };
+        uint64_t timestamp;
+        Level level;
+        Kind kind;
+        char prefix;
+        char suffix;
+        uint16_t len;
+        std::array<char, MaxAduLength> data;
+        std::string str;
+        Formatter format;
+      };
+
+      Private (Logger * q, Level level, size_t capacity);
+      virtual ~Private();
+      template <typename F> bool push (Level level, F fill);
+      void write (Entry & e);
+
+      static void writer (Private * d);
+
+      Logger * const q_ptr;
+      RingBuffer<Entry> ring;
+      std::atomic<int> level;
+      std::shared_ptr<Sink> sink;
+      mutable std::mutex mutex;   // sink, stop and the counters below
+      std::condition_variable cond;
+      std::condition_variable written;
+      std::thread thread;
+      bool stop;
+      std::atomic<unsigned long> pushed;
+      unsigned long done;
+      std::atomic<unsigned long> dropped;
+
+      PIMP_DECLARE_PUBLIC (Logger)
+  };
+}
+
+/* ========================================================================== */
@@ -14,7 +14,9 @@
  * You should have received a copy of the GNU Lesser General Public License
  * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
  */
+#include <cerrno>
 #include <sstream>
+#include <modbuspp/capture.h>
 #include "master_p.h"
 #include "slave_p.h"
 #include "config.h"
@@ -137,11 +139,16 @@ namespace Modbus {
 
     if (isValid()) {
       PIMP_D (Device);
+      std::lock_guard<std::recursive_mutex> lock (d->transaction);
       int rc = modbus_set_slave (d->ctx(), req[0]);
       if (rc == 0) {
         
         rc = modbus_send_raw_request (d->ctx(), req, len);
       }
+      if (rc > 0 && d->capture) {
+
+        d->capture->recordPdu (req, len, Capture::Sent, false);
+      }
       return rc;
     }
     throw std::runtime_error ("Backend not set !");
@@ -158,8 +165,14 @@ namespace Modbus {
 
     if (isValid()) {
       PIMP_D (Device);
+      std::lock_guard<std::recursive_mutex> lock (d->transaction);
+      int rc = modbus_receive_confirmation (d->ctx(), rsp);
+
+      if (rc > 0 && d->capture) {
 
-      return modbus_receive_confirmation (d->ctx(), rsp);
+        d->capture->record (rsp, rc, Capture::Received, true);
+      }
+      return rc;
     }
     throw std::runtime_error ("Backend not set !");
   }
@@ -176,6 +189,19 @@ namespace Modbus {
     return rc;
   }
 
+  // ---------------------------------------------------------------------------
+  int Master::writeReadRegisters (int slaveAddr, int write_addr, const uint16_t * src,
+                                  int write_nb, int read_addr, uint16_t * dest, int read_nb) {
+    Slave * s = slavePtr (slaveAddr);
+
+    if (s) {
+
+      return s->writeReadRegisters (write_addr, src, write_nb, read_addr, dest, read_nb);
+    }
+    errno = EINVAL;
+    return -1;
+  }
+
   // ---------------------------------------------------------------------------
   //
   //                         Master::Private Class
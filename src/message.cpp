@@ -14,12 +14,10 @@
  * You should have received a copy of the GNU Lesser General Public License
  * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
  */
-#include <iomanip>
-#include <sstream>
 #include <cstring>
 #include <modbuspp/device.h>
+#include <modbuspp/logger.h>
 #include <modbuspp/rtulayer.h>
-#include <modbuspp/tcplayer.h>
 #include "message_p.h"
 #include "config.h"
 
@@ -44,7 +42,7 @@ namespace Modbus {
 
   // ---------------------------------------------------------------------------
   Message::Message (NetLayer & backend, const std::vector<uint8_t> & adu) :
-    d_ptr (new Private (this, &backend, adu)) {}
+    Message (backend, adu.data(), adu.size()) {}
 
   // ---------------------------------------------------------------------------
   Message::Message (Device & dev, const std::vector<uint8_t> & adu) :
@@ -52,11 +50,11 @@ namespace Modbus {
 
   // ---------------------------------------------------------------------------
   Message::Message (NetLayer & backend, const uint8_t * adu, size_t len) :
-    Message (backend, std::vector<uint8_t> (adu, adu + len)) {}
+    d_ptr (new Private (this, &backend, adu, len)) {}
 
   // ---------------------------------------------------------------------------
   Message::Message (Device & dev, const uint8_t * adu, size_t len) :
-    Message (dev, std::vector<uint8_t> (adu, adu + len)) {}
+    Message (dev.backend(), adu, len) {}
 
   // ---------------------------------------------------------------------------
   Message::Message (NetLayer & backend, Function f) :
@@ -72,11 +70,11 @@ namespace Modbus {
 
   // ---------------------------------------------------------------------------
   Message::Message (Net net, const std::vector<uint8_t> & adu) :
-    d_ptr (new Private (this, net, adu)) {}
+    Message (net, adu.data(), adu.size()) {}
 
   // ---------------------------------------------------------------------------
   Message::Message (Net net, const uint8_t * adu, size_t len) :
-    Message (net, std::vector<uint8_t> (adu, adu + len)) {}
+    d_ptr (new Private (this, net, adu, len)) {}
 
   // ---------------------------------------------------------------------------
   Message::Message (Net net, Function f) :
@@ -84,16 +82,30 @@ namespace Modbus {
 
   // ---------------------------------------------------------------------------
   Message::Message (const Message & other) :
-    d_ptr (new Private (*other.d_ptr)) {}
+    d_ptr (new Private (*other.d_ptr)) {
+
+    d_ptr->q_ptr = this;
+  }
 
   // ---------------------------------------------------------------------------
   Message::Message (Message && other) :
-    d_ptr (std::move (other.d_ptr)) {}
+    d_ptr (std::move (other.d_ptr)) {
+
+    if (d_ptr) {
+      d_ptr->q_ptr = this;
+    }
+  }
 
   // ---------------------------------------------------------------------------
   Message& Message::operator= (Message && other) {
 
-    d_ptr = std::move (other.d_ptr);
+    if (this != &other) {
+
+      d_ptr = std::move (other.d_ptr);
+      if (d_ptr) {
+        d_ptr->q_ptr = this;
+      }
+    }
     return *this;
   }
 
@@ -101,15 +113,39 @@ namespace Modbus {
   void Message::swap (Message &other) {
 
     d_ptr.swap (other.d_ptr);
+    if (d_ptr) {
+      d_ptr->q_ptr = this;
+    }
+    if (other.d_ptr) {
+      other.d_ptr->q_ptr = &other;
+    }
   }
 
   // ---------------------------------------------------------------------------
   Message& Message::operator= (const Message &other) {
 
-    Message (other).swap (*this);
+    if (this != &other) {
+
+      if (d_ptr) {
+
+        // copy in place, without allocation
+        *d_ptr = *other.d_ptr;
+        d_ptr->q_ptr = this;
+      }
+      else {
+
+        Message (other).swap (*this);
+      }
+    }
     return *this;
   }
 
+  // ---------------------------------------------------------------------------
+  bool Message::isValid() const {
+
+    return d_ptr != nullptr;
+  }
+
   // ---------------------------------------------------------------------------
   bool Message::operator== (const Message & other) {
 
@@ -190,7 +226,7 @@ namespace Modbus {
   void Message::clear() {
     PIMP_D (Message);
 
-    d->adu.resize (d->maxAduLength, 0);
+    d->adu.fill (0);
     d->aduSize = 0;
     if (d->net == Tcp) {
       setSlaveId (MODBUS_TCP_SLAVE);
@@ -405,14 +441,8 @@ namespace Modbus {
   // ---------------------------------------------------------------------------
   void Message::print (std::ostream& os, char prefix, char suffix) const {
     PIMP_D (const Message);
-    std::ostringstream oss;
 
-    for (size_t i = 0; i < d->aduSize; i++) {
-
-      oss << prefix << std::uppercase << std::setfill ('0') << std::setw (2)
-          << std::hex << static_cast<unsigned int> (d->adu[i]) << suffix;
-    }
-    os << oss.str();
+    os << hexEncode (d->adu.data(), d->aduSize, prefix, suffix);
   }
 
   // ---------------------------------------------------------------------------
@@ -451,22 +481,16 @@ namespace Modbus {
 
   // ---------------------------------------------------------------------------
   Message::Private::Private (Message * q, NetLayer * b) :
-    q_ptr (q), net (b->net()), pduBegin (modbus_get_header_length (b->context())),
-    aduSize (0), maxAduLength (b->maxAduLength()), isResponse (false),
-    backend (b), transactionId (1) {
+    Private (q, b->net()) {
 
-    adu.resize (maxAduLength, 0);
-    if (net == Tcp) {
-      adu[6] = MODBUS_TCP_SLAVE;
-    }
+    backend = b;
   }
 
   // ---------------------------------------------------------------------------
-  Message::Private::Private (Message * q, NetLayer * b, const std::vector<uint8_t> & m) :
-    Private (q, b) {
+  Message::Private::Private (Message * q, NetLayer * b, const uint8_t * m, size_t len) :
+    Private (q, b->net(), m, len) {
 
-    adu = m;
-    aduSize = m.size();
+    backend = b;
   }
 
   // ---------------------------------------------------------------------------
@@ -478,41 +502,26 @@ namespace Modbus {
 
   // ---------------------------------------------------------------------------
   Message::Private::Private (Message * q, Net n) :
-    q_ptr (q), net (n), aduSize (0),  isResponse (false), backend (0),
+    q_ptr (q), net (n), pduBegin (netHeaderLength (n)), aduSize (0),
+    maxAduLength (netMaxAduLength (n)), isResponse (false), backend (0),
     transactionId (1) {
-    NetLayer * b;
-
-    switch (net) {
 
-      case Tcp:
-        b = new TcpLayer ("*", "1502");
-        break;
-
-      case Rtu:
-        b = new RtuLayer ("COM1", "9600E1");
-        break;
-
-      default:
-        throw std::invalid_argument (
-          "Unable to create Modbus Device for this net !");
-        break;
-    }
-
-    pduBegin = modbus_get_header_length (b->context());
-    maxAduLength =  b->maxAduLength();
-    delete b;
-    adu.resize (maxAduLength, 0);
+    adu.fill (0);
     if (net == Tcp) {
       adu[6] = MODBUS_TCP_SLAVE;
     }
   }
 
   // ---------------------------------------------------------------------------
-  Message::Private::Private (Message * q, Net n, const std::vector<uint8_t> & m) :
+  Message::Private::Private (Message * q, Net n, const uint8_t * m, size_t len) :
     Private (q, n) {
 
-    adu = m;
-    aduSize = m.size();
+    if (len > adu.size()) {
+
+      throw std::invalid_argument ("ADU too long !");
+    }
+    std::copy (m, m + len, adu.begin());
+    aduSize = len;
   }
 
   // ---------------------------------------------------------------------------
@@ -524,6 +533,122 @@ namespace Modbus {
 
   // ---------------------------------------------------------------------------
   Message::Private::~Private() = default;
+
+  // ---------------------------------------------------------------------------
+  // static
+  int Message::Private::netHeaderLength (Net n) {
+
+    switch (n) {
+      case Tcp:
+        return 7; // MBAP header
+      case Rtu:
+        return 1; // slave address
+      default:
+        throw std::invalid_argument (
+          "Unable to create Modbus Message for this net !");
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // static
+  uint16_t Message::Private::netMaxAduLength (Net n) {
+
+    switch (n) {
+      case Tcp:
+        return MODBUS_TCP_MAX_ADU_LENGTH;
+      case Rtu:
+        return MODBUS_RTU_MAX_ADU_LENGTH;
+      default:
+        throw std::invalid_argument (
+          "Unable to create Modbus Message for this net !");
+    }
+  }
+
+  namespace {
+
+    /*
+     * Free blocks of the Private objects released by the thread. The state
+     * of the pool is trivially destructible so that it remains valid when
+     * messages are freed during the exit of the thread or the destruction
+     * of the static objects, after the cleaner: the blocks are then freed
+     * normally.
+     */
+    struct Block {
+      Block * next;
+    };
+    const int MaxBlocks = 32;
+
+    enum PoolState {
+      PoolUnused = 0,
+      PoolOpen,
+      PoolClosed
+    };
+
+    thread_local Block * poolHead = nullptr;
+    thread_local int poolCount = 0;
+    thread_local int poolState = PoolUnused;
+
+    // frees the blocks of the pool at the exit of the thread
+    struct PoolCleaner {
+
+      PoolCleaner() {
+
+        poolState = PoolOpen;
+      }
+
+      ~PoolCleaner() {
+
+        poolState = PoolClosed;
+        while (poolHead) {
+          Block * b = poolHead;
+
+          poolHead = poolHead->next;
+          ::operator delete (b);
+        }
+        poolCount = 0;
+      }
+    };
+
+    // returns true if the blocks can be kept in the pool
+    bool poolIsOpen() {
+
+      if (poolState == PoolUnused) {
+        static thread_local PoolCleaner cleaner;
+
+        (void) cleaner;
+      }
+      return poolState == PoolOpen;
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // static
+  void * Message::Private::operator new (std::size_t size) {
+
+    if (size == sizeof (Private) && poolHead) {
+      Block * b = poolHead;
+
+      poolHead = b->next;
+      poolCount--;
+      return b;
+    }
+    return ::operator new (size);
+  }
+
+  // ---------------------------------------------------------------------------
+  // static
+  void Message::Private::operator delete (void * p, std::size_t size) {
+
+    if (p && size == sizeof (Private) && poolCount < MaxBlocks && poolIsOpen()) {
+      Block * b = static_cast<Block *> (p);
+
+      b->next = poolHead;
+      poolHead = b;
+      poolCount++;
+      return;
+    }
+    ::operator delete (p);
+  }
 }
 
 /* ========================================================================== */
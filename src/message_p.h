@@ -16,6 +16,7 @@
  */
 #pragma once
 
+#include <array>
 #include <modbuspp/message.h>
 
 namespace Modbus {
@@ -23,14 +24,21 @@ namespace Modbus {
   class Message::Private {
     public:
       Private (Message * q, NetLayer * b);
-      Private (Message * q, NetLayer * b, const std::vector<uint8_t> & m);
+      Private (Message * q, NetLayer * b, const uint8_t * m, size_t len);
       Private (Message * q, NetLayer * b, Function f);
       Private (Message * q, Net n);
-      Private (Message * q, Net n, const std::vector<uint8_t> & m);
+      Private (Message * q, Net n, const uint8_t * m, size_t len);
       Private (Message * q, Net n, Function f);
       virtual ~Private();
 
-      Message * const q_ptr;
+      // the objects are recycled by a pool of the thread
+      static void * operator new (std::size_t size);
+      static void operator delete (void * p, std::size_t size);
+
+      static int netHeaderLength (Net n);
+      static uint16_t netMaxAduLength (Net n);
+
+      Message * q_ptr; // updated when the object is moved
       Net net;
       int pduBegin;
       size_t aduSize;
@@ -38,7 +46,7 @@ namespace Modbus {
       bool isResponse;
       NetLayer * backend;
       uint16_t transactionId;
-      std::vector<uint8_t> adu;
+      std::array<uint8_t, MaxAduLength> adu;
   };
 }
 
@@ -0,0 +1,264 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cerrno>
+#include <cstring>
+#ifndef _WIN32
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+#endif
+#include "persistentfile_p.h"
+#include "config.h"
+
+namespace Modbus {
+
+  // ---------------------------------------------------------------------------
+  //
+  //                         PersistentFile Class
+  //
+  // ---------------------------------------------------------------------------
+
+  // ---------------------------------------------------------------------------
+  PersistentFile::PersistentFile() :
+    base (nullptr), length (0), fd (-1), dataLength (0), last (-1), generation (0) {}
+
+  // ---------------------------------------------------------------------------
+  PersistentFile::~PersistentFile() {
+
+    close();
+  }
+
+  // ---------------------------------------------------------------------------
+  // static
+  size_t PersistentFile::dataSize (const std::vector<PersistentFormat::Block> & blocks) {
+    size_t n = 0;
+
+    for (const auto & b : blocks) {
+
+      n += b.size * ( (b.table == Coil || b.table == DiscreteInput) ? 1 : 2);
+    }
+    return n;
+  }
+
+  // ---------------------------------------------------------------------------
+  bool PersistentFile::open (const std::string & p,
+                             const std::vector<PersistentFormat::Block> & blocks,
+                             std::vector<uint8_t> & data) {
+    using namespace PersistentFormat;
+
+#ifndef _WIN32
+    size_t blocksLength = blocks.size() * sizeof (Block);
+    size_t slotsOffset = (sizeof (Header) + blocksLength + 7) & ~7;
+    size_t dataLen = dataSize (blocks);
+    size_t slotLength = (sizeof (Slot) + dataLen + 7) & ~7;
+    size_t len = slotsOffset + 2 * slotLength;
+    Header h;
+
+    close();
+    data.clear();
+
+    memset (&h, 0, sizeof (h));
+    memcpy (h.magic, Magic, sizeof (Magic));
+    h.version = Version;
+    h.blocks = blocks.size();
+    h.dataSize = dataLen;
+    h.checksum = crc32 (blocks.data(), blocksLength, crc32 (&h, sizeof (h)));
+
+    fd = ::open (p.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+
+      return false;
+    }
+
+    struct stat st;
+    if (fstat (fd, &st) == 0) {
+      bool same = false;
+
+      if (static_cast<size_t> (st.st_size) == len) {
+        Header e;
+
+        // same blocks ?
+        if (pread (fd, &e, sizeof (e), 0) == sizeof (e)) {
+
+          same = (memcmp (&e, &h, sizeof (h)) == 0);
+        }
+      }
+
+      if (same || (ftruncate (fd, 0) == 0 && ftruncate (fd, len) == 0)) {
+        void * m = mmap (nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+        if (m != MAP_FAILED) {
+
+          base = static_cast<uint8_t *> (m);
+          length = len;
+          dataLength = dataLen;
+          path = p;
+          last = -1;
+          generation = 0;
+
+          if (same) {
+
+            for (int i = 0; i < 2; i++) {
+
+              if (isValid (i) && slot (i)->generation >= generation) {
+
+                last = i;
+                generation = slot (i)->generation;
+              }
+            }
+
+            if (last >= 0) {
+              const uint8_t * src = reinterpret_cast<const uint8_t *> (slot (last) + 1);
+
+              data.assign (src, src + dataLength);
+            }
+          }
+          else {
+
+            // the header is written last, the file is valid once synced
+            memcpy (base + sizeof (Header), blocks.data(), blocksLength);
+            msync (base, length, MS_SYNC);
+            memcpy (base, &h, sizeof (h));
+            msync (base, sizeof (h), MS_SYNC);
+          }
+          return true;
+        }
+      }
+    }
+
+    int saved_errno = errno;
+    ::close (fd);
+    fd = -1;
+    errno = saved_errno;
+#else
+    errno = ENOSYS;
+#endif
+    return false;
+  }
+
+  // ---------------------------------------------------------------------------
+  void PersistentFile::close() {
+
+#ifndef _WIN32
+    if (base) {
+
+      msync (base, length, MS_SYNC);
+      munmap (base, length);
+      base = nullptr;
+      length = 0;
+    }
+    if (fd >= 0) {
+
+      ::close (fd);
+      fd = -1;
+    }
+#endif
+  }
+
+  // ---------------------------------------------------------------------------
+  bool PersistentFile::write (const std::vector<uint8_t> & data) {
+
+#ifndef _WIN32
+    if (isOpen() && data.size() == dataLength) {
+      int i = (last + 1) % 2;
+      PersistentFormat::Slot * s = slot (i);
+
+      // the slot is invalid until its checksum is written
+      s->checksum = ~PersistentFormat::crc32 (&generation, sizeof (generation));
+      s->generation = generation + 1;
+      memcpy (s + 1, data.data(), dataLength);
+      s->checksum = PersistentFormat::crc32 (s + 1, dataLength,
+                                             PersistentFormat::crc32 (&s->generation, sizeof (s->generation)));
+
+      // only the pages of the slot are synced, msync() requires an address
+      // aligned on a page, base is
+      static const size_t page = sysconf (_SC_PAGESIZE);
+      size_t begin = reinterpret_cast<uint8_t *> (s) - base;
+      size_t end = begin + sizeof (PersistentFormat::Slot) + dataLength;
+
+      begin -= begin % page;
+      if (msync (base + begin, end - begin, MS_SYNC) == 0) {
+
+        generation++;
+        last = i;
+        return true;
+      }
+      return false;
+    }
+    errno = EINVAL;
+#else
+    errno = ENOSYS;
+#endif
+    return false;
+  }
+
+  // ---------------------------------------------------------------------------
+  PersistentFormat::Slot * PersistentFile::slot (int i) const {
+    const PersistentFormat::Header * h = reinterpret_cast<const PersistentFormat::Header *> (base);
+    size_t slotsOffset = (sizeof (PersistentFormat::Header) +
+                          h->blocks * sizeof (PersistentFormat::Block) + 7) & ~7;
+    size_t slotLength = (sizeof (PersistentFormat::Slot) + dataLength + 7) & ~7;
+
+    return reinterpret_cast<PersistentFormat::Slot *> (base + slotsOffset + i * slotLength);
+  }
+
+  // ---------------------------------------------------------------------------
+  bool PersistentFile::isValid (int i) const {
+    const PersistentFormat::Slot * s = slot (i);
+
+    return s->generation > 0 &&
+           s->checksum == PersistentFormat::crc32 (s + 1, dataLength,
+               PersistentFormat::crc32 (&s->generation, sizeof (s->generation)));
+  }
+
+  // ---------------------------------------------------------------------------
+  //
+  //                         PersistentFormat Namespace
+  //
+  // ---------------------------------------------------------------------------
+  namespace PersistentFormat {
+
+    // -------------------------------------------------------------------------
+    // CRC-32 (IEEE 802.3), crc is the CRC of the previous bytes
+    uint32_t crc32 (const void * buf, size_t len, uint32_t crc) {
+      static const struct Table {
+        uint32_t t[256];
+        Table() {
+          for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+
+            for (int k = 0; k < 8; k++) {
+              c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+            }
+            t[i] = c;
+          }
+        }
+      } table;
+      const uint8_t * p = static_cast<const uint8_t *> (buf);
+
+      crc = ~crc;
+      while (len--) {
+
+        crc = table.t[ (crc ^ *p++) & 0xFF] ^ (crc >> 8);
+      }
+      return ~crc;
+    }
+  }
+}
+
+/* ========================================================================== */
@@ -0,0 +1,100 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <modbuspp/global.h>
+
+namespace Modbus {
+
+  /*
+   * File layout (host byte order):
+   * | Header | Block [blocks] | Slot 0 | data | Slot 1 | data |
+   *
+   * The data are the values of the blocks, one byte per bit and 16 bits per
+   * register, in the order of the blocks. They are written alternately in
+   * the two slots, the slot with the highest generation and a valid
+   * checksum is the last complete snapshot, the other one can have been
+   * partially written when the system stopped.
+   */
+  namespace PersistentFormat {
+
+    const char Magic[4] = { 'M', 'B', 'P', 'F' };
+    const uint16_t Version = 1;
+
+    struct Header {
+      char magic[4];
+      uint16_t version;
+      uint16_t blocks;
+      uint32_t dataSize;
+      uint32_t checksum; // of the header (this field null) and the blocks
+    };
+
+    struct Block {
+      uint8_t table;
+      uint8_t reserved[3];
+      int32_t start; // PDU address
+      int32_t size;
+    };
+
+    struct Slot {
+      uint64_t generation;
+      uint32_t checksum; // of the generation and the data
+      uint32_t reserved;
+    };
+
+    uint32_t crc32 (const void * buf, size_t len, uint32_t crc = 0);
+  }
+
+  // values of blocks saved in a memory-mapped file
+  class PersistentFile {
+
+    public:
+      PersistentFile();
+      ~PersistentFile();
+
+      // opens or creates the file for the blocks, returns the last valid
+      // snapshot in data if the file had the same blocks
+      bool open (const std::string & path,
+                 const std::vector<PersistentFormat::Block> & blocks,
+                 std::vector<uint8_t> & data);
+      void close();
+      bool isOpen() const {
+        return base != nullptr;
+      }
+      // writes a snapshot of the data in the older slot and syncs the file
+      bool write (const std::vector<uint8_t> & data);
+
+      static size_t dataSize (const std::vector<PersistentFormat::Block> & blocks);
+
+      std::string path;
+
+    private:
+      PersistentFormat::Slot * slot (int i) const;
+      bool isValid (int i) const;
+
+      uint8_t * base;
+      size_t length;
+      int fd;
+      size_t dataLength;
+      int last; // slot of the last snapshot, -1 if none
+      uint64_t generation;
+  };
+}
+
+/* ========================================================================== */
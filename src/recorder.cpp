@@ -0,0 +1,808 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#ifndef _WIN32
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+#endif
+#include "bufferedslave_p.h"
+#include "recorder_p.h"
+#include "config.h"
+
+namespace Modbus {
+
+  // ---------------------------------------------------------------------------
+  //
+  //                         Recorder Class
+  //
+  // ---------------------------------------------------------------------------
+
+  // ---------------------------------------------------------------------------
+  Recorder::Recorder (Recorder::Private &dd) : d_ptr (&dd) {}
+
+  // ---------------------------------------------------------------------------
+  Recorder::Recorder () : d_ptr (new Private (this)) {}
+
+  // ---------------------------------------------------------------------------
+  Recorder::Recorder (const std::string & path, size_t size) : Recorder () {
+
+    if (! open (path, size)) {
+
+      throw std::runtime_error ("Unable to open the recorder file " + path);
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  Recorder::~Recorder() {
+
+    close();
+  }
+
+  // ---------------------------------------------------------------------------
+  bool Recorder::open (const std::string & path, size_t size, int indexSize) {
+    PIMP_D (Recorder);
+
+    if (isOpen()) {
+
+      close();
+    }
+    return d->open (path, size, indexSize);
+  }
+
+  // ---------------------------------------------------------------------------
+  void Recorder::close() {
+
+    if (isOpen()) {
+      PIMP_D (Recorder);
+
+      flush();
+      d->close();
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  bool Recorder::isOpen() const {
+    PIMP_D (const Recorder);
+
+    return d->file.isOpen();
+  }
+
+  // ---------------------------------------------------------------------------
+  const std::string & Recorder::path() const {
+    PIMP_D (const Recorder);
+
+    return d->file.path;
+  }
+
+  // ---------------------------------------------------------------------------
+  int Recorder::keyframeInterval() const {
+    PIMP_D (const Recorder);
+
+    return d->keyframeInterval;
+  }
+
+  // ---------------------------------------------------------------------------
+  void Recorder::setKeyframeInterval (int n) {
+    PIMP_D (Recorder);
+
+    d->keyframeInterval = std::max (n, 1);
+  }
+
+  // ---------------------------------------------------------------------------
+  int Recorder::record (int slave, Table t, int addr, const uint16_t * src, int nb,
+                        uint64_t timestamp) {
+    PIMP_D (Recorder);
+    using namespace RecorderFormat;
+
+    if (!isOpen() || !src || nb <= 0 || nb > 0xFFFF ||
+        (t != InputRegister && t != HoldingRegister)) {
+
+      errno = EINVAL;
+      return -1;
+    }
+
+    int ch = d->channel (slave, t, addr, nb);
+    if (ch < 0) {
+
+      return -1;
+    }
+
+    Private::State & s = d->state[ch];
+    std::vector<uint8_t> & rec = d->buffer;
+    bool keyframe = s.registers.empty() || (s.samples >= d->keyframeInterval);
+
+    if (timestamp == 0) {
+
+      timestamp = now();
+    }
+    if (timestamp < s.timestamp) {
+
+      keyframe = true;
+    }
+
+    rec.resize (RecordHeaderSize + 10 + 2 * nb * (sizeof (uint16_t) + 3));
+    uint8_t * p = rec.data() + RecordHeaderSize;
+
+    if (!keyframe) {
+      int i = 0;
+
+      p += putVarint (p, timestamp - s.timestamp);
+      while (i < nb) {
+        int skip = 0;
+        int count = 0;
+
+        while ( (i + skip) < nb && src[i + skip] == s.registers[i + skip]) {
+          skip++;
+        }
+        if ( (i + skip) == nb) {
+          break;
+        }
+        i += skip;
+        // a run ends after 3 unchanged registers, shorter gaps are cheaper
+        // to store than a new run
+        for (int gap = 0; (i + count) < nb && gap < 3; count++) {
+
+          gap = (src[i + count] == s.registers[i + count]) ? gap + 1 : 0;
+        }
+        while (src[i + count - 1] == s.registers[i + count - 1]) {
+          count--;
+        }
+        p += putVarint (p, skip);
+        p += putVarint (p, count);
+        std::memcpy (p, &src[i], count * sizeof (uint16_t));
+        p += count * sizeof (uint16_t);
+        i += count;
+      }
+
+      if (static_cast<size_t> (p - rec.data()) >=
+          RecordHeaderSize + sizeof (uint64_t) + nb * sizeof (uint16_t)) {
+
+        // delta bigger than a keyframe
+        keyframe = true;
+        p = rec.data() + RecordHeaderSize;
+      }
+    }
+
+    if (keyframe) {
+
+      std::memcpy (p, &timestamp, sizeof (timestamp));
+      p += sizeof (timestamp);
+      std::memcpy (p, src, nb * sizeof (uint16_t));
+      p += nb * sizeof (uint16_t);
+    }
+
+    uint32_t len = p - rec.data();
+    rec.resize (len);
+    std::memcpy (rec.data(), &len, sizeof (len));
+    rec[4] = keyframe ? Keyframe : Delta;
+    rec[5] = ch;
+
+    if (d->append (rec, keyframe ? timestamp : 0) < 0) {
+
+      return -1;
+    }
+
+    s.registers.assign (src, src + nb);
+    s.timestamp = timestamp;
+    s.samples = keyframe ? 1 : s.samples + 1;
+    return len;
+  }
+
+  // ---------------------------------------------------------------------------
+  int Recorder::record (BufferedSlave & slave, Table t, uint64_t timestamp) {
+    PIMP_D (Recorder);
+    BufferedSlave::Private * s = slave.d_func();
+    std::vector<uint16_t> & regs = d->registers;
+    int rc = 0;
+
+    if (t != InputRegister && t != HoldingRegister) {
+
+      errno = EINVAL;
+      return -1;
+    }
+
+    if (timestamp == 0) {
+
+      timestamp = now();
+    }
+
+    // a channel per block, the registers are copied consistently
+    for (const auto & e : s->blocks[t].index) {
+      int nb = e.end - e.start;
+      const uint16_t * src = s->findRegisters (t, e.start, nb);
+      int n;
+
+      regs.resize (nb);
+      s->seqlock.read ([&regs, src, nb] {
+        std::memcpy (regs.data(), src, nb * sizeof (uint16_t));
+      });
+
+      n = record (slave.number(), t, e.start, regs.data(), nb, timestamp);
+      if (n < 0) {
+
+        return -1;
+      }
+      rc += n;
+    }
+    return rc;
+  }
+
+  // ---------------------------------------------------------------------------
+  bool Recorder::flush (bool async) {
+
+#ifndef _WIN32
+    if (isOpen()) {
+      PIMP_D (Recorder);
+
+      return msync (d->file.base, d->file.length, async ? MS_ASYNC : MS_SYNC) == 0;
+    }
+#endif
+    errno = EBADF;
+    return false;
+  }
+
+  // ---------------------------------------------------------------------------
+  uint64_t Recorder::now() {
+
+    return std::chrono::duration_cast<std::chrono::microseconds> (
+             std::chrono::system_clock::now().time_since_epoch()).count();
+  }
+
+  // ---------------------------------------------------------------------------
+  //
+  //                         Recorder::Private Class
+  //
+  // ---------------------------------------------------------------------------
+
+  // ---------------------------------------------------------------------------
+  Recorder::Private::Private (Recorder * q) :
+    q_ptr (q), keyframeInterval (60) {}
+
+  // ---------------------------------------------------------------------------
+  Recorder::Private::~Private() = default;
+
+  // ---------------------------------------------------------------------------
+  bool Recorder::Private::open (const std::string & path, size_t size, int indexSize) {
+    using namespace RecorderFormat;
+
+    if (size < 1024 || indexSize < 1) {
+
+      errno = EINVAL;
+      return false;
+    }
+
+    size_t len = fileSize (size, indexSize);
+    if (! file.open (path, true, len)) {
+
+      return false;
+    }
+
+    Header * h = file.header();
+    if (std::memcmp (h->magic, Magic, sizeof (Magic)) != 0 ||
+        h->version != Version || h->size != size ||
+        h->indexSize != static_cast<uint32_t> (indexSize) ||
+        h->tail > h->head || (h->head - h->tail) > size ||
+        h->channels > MaxChannels) {
+
+      // new or incompatible file
+      std::memset (file.base, 0, len - size);
+      h->version = Version;
+      h->size = size;
+      h->indexSize = indexSize;
+      std::memcpy (h->magic, Magic, sizeof (Magic));
+    }
+
+    // the first sample of each channel will be a keyframe
+    state.assign (h->channels, State ({std::vector<uint16_t>(), 0, 0}));
+    return true;
+  }
+
+  // ---------------------------------------------------------------------------
+  void Recorder::Private::close() {
+
+    file.close();
+    state.clear();
+  }
+
+  // ---------------------------------------------------------------------------
+  int Recorder::Private::channel (int slave, Table t, int addr, int nb) {
+    using namespace RecorderFormat;
+    Header * h = file.header();
+    RecorderFormat::Channel * c = file.channels();
+
+    for (int i = 0; i < h->channels; i++) {
+
+      if (c[i].slave == slave && c[i].table == t &&
+          c[i].address == addr && c[i].size == nb) {
+
+        return i;
+      }
+    }
+
+    if (h->channels < MaxChannels) {
+      int i = h->channels;
+
+      c[i] = RecorderFormat::Channel ({static_cast<uint8_t> (slave), static_cast<uint8_t> (t),
+                       static_cast<uint16_t> (addr), static_cast<uint16_t> (nb), 0
+                      });
+      h->channels++;
+      state.push_back (State ({std::vector<uint16_t>(), 0, 0}));
+      return i;
+    }
+    errno = ENOSPC;
+    return -1;
+  }
+
+  // ---------------------------------------------------------------------------
+  // timestamp is not zero for keyframes, which are indexed
+  int Recorder::Private::append (const std::vector<uint8_t> & rec, uint64_t timestamp) {
+    using namespace RecorderFormat;
+    Header * h = file.header();
+    uint64_t head = h->head;
+    uint64_t tail = h->tail;
+
+    if (rec.size() > h->size) {
+
+      errno = EMSGSIZE;
+      return -1;
+    }
+
+    // drops the oldest records
+    while ( (head + rec.size() - tail) > h->size) {
+      uint32_t len;
+
+      file.read (tail, &len, sizeof (len));
+      if (len < RecordHeaderSize || len > (head - tail)) {
+
+        tail = head; // corrupted, drops everything
+        break;
+      }
+      tail += len;
+    }
+    h->tail = tail;
+    std::atomic_thread_fence (std::memory_order_release);
+
+    file.write (head, rec.data(), rec.size());
+
+    if (timestamp) {
+      IndexEntry & e = file.index() [h->indexCount % h->indexSize];
+
+      e.timestamp = timestamp;
+      e.offset = head;
+      h->indexCount++;
+    }
+
+    std::atomic_thread_fence (std::memory_order_release);
+    h->head = head + rec.size();
+    return rec.size();
+  }
+
+  // ---------------------------------------------------------------------------
+  //
+  //                         RecorderReader Class
+  //
+  // ---------------------------------------------------------------------------
+
+  // ---------------------------------------------------------------------------
+  RecorderReader::RecorderReader (RecorderReader::Private &dd) : d_ptr (&dd) {}
+
+  // ---------------------------------------------------------------------------
+  RecorderReader::RecorderReader () : d_ptr (new Private (this)) {}
+
+  // ---------------------------------------------------------------------------
+  RecorderReader::RecorderReader (const std::string & path) : RecorderReader () {
+
+    if (! open (path)) {
+
+      throw std::runtime_error ("Unable to open the recorder file " + path);
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  RecorderReader::~RecorderReader() = default;
+
+  // ---------------------------------------------------------------------------
+  bool RecorderReader::open (const std::string & path) {
+    PIMP_D (RecorderReader);
+    using namespace RecorderFormat;
+
+    if (d->file.open (path, false)) {
+      const Header * h = d->file.header();
+
+      if (d->file.length >= sizeof (Header) &&
+          std::memcmp (h->magic, Magic, sizeof (Magic)) == 0 &&
+          h->version == Version &&
+          d->file.length == fileSize (h->size, h->indexSize)) {
+
+        return true;
+      }
+      d->file.close();
+      errno = EINVAL;
+    }
+    return false;
+  }
+
+  // ---------------------------------------------------------------------------
+  void RecorderReader::close() {
+    PIMP_D (RecorderReader);
+
+    d->file.close();
+  }
+
+  // ---------------------------------------------------------------------------
+  bool RecorderReader::isOpen() const {
+    PIMP_D (const RecorderReader);
+
+    return d->file.isOpen();
+  }
+
+  // ---------------------------------------------------------------------------
+  std::vector<Recorder::Channel> RecorderReader::channels() const {
+    std::vector<Recorder::Channel> v;
+
+    if (isOpen()) {
+      PIMP_D (const RecorderReader);
+      const RecorderFormat::Channel * c = d->file.channels();
+      int n = d->file.header()->channels;
+
+      for (int i = 0; i < n; i++) {
+
+        v.push_back ({c[i].slave, static_cast<Table> (c[i].table), c[i].address, c[i].size});
+      }
+    }
+    return v;
+  }
+
+  // ---------------------------------------------------------------------------
+  int RecorderReader::channel (int slave, Table t, int addr, int nb) const {
+    std::vector<Recorder::Channel> v = channels();
+
+    for (size_t i = 0; i < v.size(); i++) {
+
+      if (v[i].slave == slave && v[i].table == t &&
+          v[i].address == addr && v[i].size == nb) {
+
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  // ---------------------------------------------------------------------------
+  int RecorderReader::read (int ch, uint64_t from, uint64_t to, Callback cb) const {
+    using namespace RecorderFormat;
+
+    if (!isOpen()) {
+
+      errno = EBADF;
+      return -1;
+    }
+
+    PIMP_D (const RecorderReader);
+    const Header * h = d->file.header();
+    uint16_t nch = h->channels;
+    std::atomic_thread_fence (std::memory_order_acquire);
+    uint64_t head = h->head;
+    uint64_t pos = h->tail;
+
+    if (ch >= nch) {
+
+      errno = EINVAL;
+      return -1;
+    }
+
+    if (ch >= 0) {
+      // starts at the last keyframe of the channel preceding the range
+      const IndexEntry * index = d->file.index();
+      uint32_t count = std::min (h->indexCount, h->indexSize);
+      uint64_t best = 0;
+
+      for (uint32_t i = 0; i < count; i++) {
+        const IndexEntry & e = index[i];
+
+        if (e.offset >= pos && e.offset < head && e.timestamp <= from &&
+            e.offset >= best) {
+          uint8_t c;
+
+          d->file.read (e.offset + 5, &c, 1);
+          if (c == ch) {
+
+            best = e.offset;
+          }
+        }
+      }
+      pos = std::max (pos, best);
+    }
+
+    std::vector<Recorder::Sample> last (nch);
+    std::vector<uint8_t> rec;
+    int n = 0;
+
+    for (int i = 0; i < nch; i++) {
+
+      last[i].channel = -1; // no keyframe read yet
+    }
+
+    while (pos < head) {
+      uint32_t len;
+
+      d->file.read (pos, &len, sizeof (len));
+      if (len < RecordHeaderSize || len > (head - pos)) {
+
+        break;
+      }
+      rec.resize (len);
+      d->file.read (pos, rec.data(), len);
+
+      std::atomic_thread_fence (std::memory_order_acquire);
+      if (h->tail > pos) {
+
+        // overwritten by the recorder while reading
+        break;
+      }
+      pos += len;
+
+      int c = rec[5];
+      if (c >= nch || (ch >= 0 && c != ch)) {
+
+        continue;
+      }
+
+      Recorder::Sample & s = last[c];
+      const uint8_t * p = rec.data() + RecordHeaderSize;
+      const uint8_t * end = rec.data() + len;
+      size_t size = d->file.channels() [c].size;
+
+      if (rec[4] == Keyframe) {
+
+        if (static_cast<size_t> (end - p) != sizeof (uint64_t) + size * sizeof (uint16_t)) {
+
+          break;
+        }
+        s.channel = c;
+        std::memcpy (&s.timestamp, p, sizeof (uint64_t));
+        s.registers.resize (size);
+        std::memcpy (s.registers.data(), p + sizeof (uint64_t), size * sizeof (uint16_t));
+      }
+      else if (rec[4] == Delta) {
+        uint64_t dt, skip, count;
+        size_t i = 0;
+
+        if (s.channel < 0) {
+
+          continue; // the keyframe has been overwritten
+        }
+
+        p += getVarint (p, end, dt);
+        s.timestamp += dt;
+        while (p < end) {
+
+          p += getVarint (p, end, skip);
+          p += getVarint (p, end, count);
+          i += skip;
+          if ( (i + count) > size || (p + count * sizeof (uint16_t)) > end) {
+
+            s.channel = -1;
+            break;
+          }
+          std::memcpy (&s.registers[i], p, count * sizeof (uint16_t));
+          p += count * sizeof (uint16_t);
+          i += count;
+        }
+        if (s.channel < 0) {
+
+          continue;
+        }
+      }
+      else {
+
+        break;
+      }
+
+      if (s.timestamp > to && ch >= 0) {
+
+        break;
+      }
+
+      if (s.timestamp >= from && s.timestamp <= to) {
+
+        n++;
+        if (cb && ! cb (s)) {
+
+          break;
+        }
+      }
+    }
+    return n;
+  }
+
+  // ---------------------------------------------------------------------------
+  std::vector<Recorder::Sample>
+  RecorderReader::read (int ch, uint64_t from, uint64_t to) const {
+    std::vector<Recorder::Sample> v;
+
+    read (ch, from, to, [&v] (const Recorder::Sample & s) {
+      v.push_back (s);
+      return true;
+    });
+    return v;
+  }
+
+  // ---------------------------------------------------------------------------
+  //
+  //                         RecorderReader::Private Class
+  //
+  // ---------------------------------------------------------------------------
+
+  // ---------------------------------------------------------------------------
+  RecorderReader::Private::Private (RecorderReader * q) : q_ptr (q) {}
+
+  // ---------------------------------------------------------------------------
+  RecorderReader::Private::~Private() = default;
+
+  // ---------------------------------------------------------------------------
+  //
+  //                         RecorderFormat Namespace
+  //
+  // ---------------------------------------------------------------------------
+  namespace RecorderFormat {
+
+    // -------------------------------------------------------------------------
+    Map::Map() : base (nullptr), length (0), fd (-1) {}
+
+    // -------------------------------------------------------------------------
+    Map::~Map() {
+
+      close();
+    }
+
+    // -------------------------------------------------------------------------
+    // len is the size of the file if writable
+    bool Map::open (const std::string & p, bool writable, size_t len) {
+
+#ifndef _WIN32
+      close();
+      fd = ::open (p.c_str(), writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+      if (fd < 0) {
+
+        return false;
+      }
+
+      struct stat st;
+      if (fstat (fd, &st) == 0) {
+
+        if (writable) {
+
+          if (static_cast<size_t> (st.st_size) != len &&
+              (ftruncate (fd, 0) != 0 || ftruncate (fd, len) != 0)) {
+
+            len = 0;
+          }
+        }
+        else {
+
+          len = st.st_size;
+        }
+
+        if (len > 0) {
+          void * m = mmap (nullptr, len, writable ? (PROT_READ | PROT_WRITE) : PROT_READ,
+                           MAP_SHARED, fd, 0);
+          if (m != MAP_FAILED) {
+
+            base = static_cast<uint8_t *> (m);
+            length = len;
+            path = p;
+            return true;
+          }
+        }
+        else {
+
+          errno = EINVAL;
+        }
+      }
+
+      int saved_errno = errno;
+      ::close (fd);
+      fd = -1;
+      errno = saved_errno;
+#else
+      errno = ENOSYS;
+#endif
+      return false;
+    }
+
+    // -------------------------------------------------------------------------
+    void Map::close() {
+
+#ifndef _WIN32
+      if (base) {
+
+        munmap (base, length);
+        base = nullptr;
+        length = 0;
+      }
+      if (fd >= 0) {
+
+        ::close (fd);
+        fd = -1;
+      }
+#endif
+    }
+
+    // -------------------------------------------------------------------------
+    void Map::write (uint64_t pos, const void * src, size_t len) {
+      const uint8_t * s = static_cast<const uint8_t *> (src);
+      uint64_t size = header()->size;
+      size_t offset = pos % size;
+      size_t n = std::min (len, static_cast<size_t> (size - offset));
+
+      std::memcpy (data() + offset, s, n);
+      std::memcpy (data(), s + n, len - n);
+    }
+
+    // -------------------------------------------------------------------------
+    void Map::read (uint64_t pos, void * dest, size_t len) const {
+      uint8_t * d = static_cast<uint8_t *> (dest);
+      uint64_t size = header()->size;
+      size_t offset = pos % size;
+      size_t n = std::min (len, static_cast<size_t> (size - offset));
+
+      std::memcpy (d, data() + offset, n);
+      std::memcpy (d + n, data(), len - n);
+    }
+
+    // -------------------------------------------------------------------------
+    size_t putVarint (uint8_t * p, uint64_t v) {
+      size_t n = 0;
+
+      while (v >= 0x80) {
+
+        p[n++] = static_cast<uint8_t> (v) | 0x80;
+        v >>= 7;
+      }
+      p[n++] = static_cast<uint8_t> (v);
+      return n;
+    }
+
+    // -------------------------------------------------------------------------
+    size_t getVarint (const uint8_t * p, const uint8_t * end, uint64_t & v) {
+      size_t n = 0;
+      int shift = 0;
+
+      v = 0;
+      while ( (p + n) < end && shift < 64) {
+        uint8_t b = p[n++];
+
+        v |= static_cast<uint64_t> (b & 0x7F) << shift;
+        if ( (b & 0x80) == 0) {
+
+          break;
+        }
+        shift += 7;
+      }
+      return n;
+    }
+  }
+}
+
+/* ========================================================================== */
@@ -0,0 +1,158 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <modbuspp/recorder.h>
+
+namespace Modbus {
+
+  /*
+   * File layout (host byte order):
+   * | Header | Channel [MaxChannels] | IndexEntry [indexSize] | data [size] |
+   *
+   * The data area is a ring of records addressed by logical offsets that
+   * are never reset, the physical offset is the logical offset modulo size.
+   * Record:
+   * | length (u32) | type (u8) | channel (u8) | payload |
+   * Keyframe payload:
+   * | timestamp (u64) | registers (u16 * channel size) |
+   * Delta payload:
+   * | elapsed time (varint) | { skip (varint) | count (varint) | registers (u16 * count) } * |
+   */
+  namespace RecorderFormat {
+
+    const char Magic[4] = { 'M', 'B', 'R', 'C' };
+    const uint16_t Version = 1;
+    const int MaxChannels = 256;
+
+    enum RecordType {
+      Keyframe = 1,
+      Delta = 2
+    };
+
+    struct Header {
+      char magic[4];
+      uint16_t version;
+      uint16_t channels;
+      uint32_t indexSize;
+      uint32_t indexCount;
+      uint64_t size;
+      uint64_t head;
+      uint64_t tail;
+      uint8_t reserved[24];
+    };
+
+    struct Channel {
+      uint8_t slave;
+      uint8_t table;
+      uint16_t address;
+      uint16_t size;
+      uint16_t reserved;
+    };
+
+    struct IndexEntry {
+      uint64_t timestamp;
+      uint64_t offset;
+    };
+
+    const size_t RecordHeaderSize = 6;
+
+    inline size_t fileSize (size_t size, uint32_t indexSize) {
+      return sizeof (Header) + MaxChannels * sizeof (Channel) +
+             indexSize * sizeof (IndexEntry) + size;
+    }
+
+    // the mapped file
+    class Map {
+      public:
+        Map();
+        ~Map();
+        bool open (const std::string & path, bool writable, size_t len = 0);
+        void close();
+        bool isOpen() const {
+          return base != nullptr;
+        }
+
+        Header * header() const {
+          return reinterpret_cast<Header *> (base);
+        }
+        Channel * channels() const {
+          return reinterpret_cast<Channel *> (base + sizeof (Header));
+        }
+        IndexEntry * index() const {
+          return reinterpret_cast<IndexEntry *> (base + sizeof (Header) +
+                                                 MaxChannels * sizeof (Channel));
+        }
+        uint8_t * data() const {
+          return reinterpret_cast<uint8_t *> (index() + header()->indexSize);
+        }
+
+        // copy between the ring and a linear buffer
+        void write (uint64_t pos, const void * src, size_t len);
+        void read (uint64_t pos, void * dest, size_t len) const;
+
+        std::string path;
+        uint8_t * base;
+        size_t length;
+        int fd;
+    };
+
+    size_t putVarint (uint8_t * p, uint64_t v);
+    size_t getVarint (const uint8_t * p, const uint8_t * end, uint64_t & v);
+  }
+
+  class Recorder::Private {
+
+    public:
+      Private (Recorder * q);
+      virtual ~Private();
+      bool open (const std::string & path, size_t size, int indexSize);
+      void close();
+      int channel (int slave, Table t, int addr, int nb);
+      int append (const std::vector<uint8_t> & rec, uint64_t timestamp);
+
+      // writing state of a channel
+      struct State {
+        std::vector<uint16_t> registers;
+        uint64_t timestamp;
+        int samples;
+      };
+
+      Recorder * const q_ptr;
+      RecorderFormat::Map file;
+      std::vector<State> state;
+      std::vector<uint8_t> buffer;
+      std::vector<uint16_t> registers; // copy of a block of a slave
+      int keyframeInterval;
+
+      PIMP_DECLARE_PUBLIC (Recorder)
+  };
+
+  class RecorderReader::Private {
+
+    public:
+      Private (RecorderReader * q);
+      virtual ~Private();
+
+      RecorderReader * const q_ptr;
+      RecorderFormat::Map file;
+
+      PIMP_DECLARE_PUBLIC (RecorderReader)
+  };
+}
+
+/* ========================================================================== */
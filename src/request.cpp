@@ -14,9 +14,11 @@
  * You should have received a copy of the GNU Lesser General Public License
  * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
  */
+#include <algorithm>
 #include <modbuspp/device.h>
 #include <modbuspp/netlayer.h>
 #include <modbuspp/request.h>
+#include <modbuspp/bitarray.h>
 #include "request_p.h"
 #include "config.h"
 
@@ -37,7 +39,7 @@ namespace Modbus {
 
   // ---------------------------------------------------------------------------
   Request::Request (NetLayer & backend, const std::vector<uint8_t> & adu) :
-    Message (*new Private (this, &backend, adu)) {}
+    Request (backend, adu.data(), adu.size()) {}
 
   // ---------------------------------------------------------------------------
   Request::Request (NetLayer & backend, Function f) :
@@ -53,11 +55,11 @@ namespace Modbus {
 
   // ---------------------------------------------------------------------------
   Request::Request (NetLayer & backend, const uint8_t * adu, size_t len) :
-    Request (backend, std::vector<uint8_t> (adu, adu + len)) {}
+    Message (*new Private (this, &backend, adu, len)) {}
 
   // ---------------------------------------------------------------------------
   Request::Request (Device & dev, const uint8_t * adu, size_t len) :
-    Request (dev, std::vector<uint8_t> (adu, adu + len)) {}
+    Request (dev.backend(), adu, len) {}
 
   // ---------------------------------------------------------------------------
   Request::Request (Device & dev, Function f) :
@@ -69,11 +71,11 @@ namespace Modbus {
 
   // ---------------------------------------------------------------------------
   Request::Request (Net net, const std::vector<uint8_t> & adu) :
-    Message (*new Private (this, net, adu)) {}
+    Request (net, adu.data(), adu.size()) {}
 
   // ---------------------------------------------------------------------------
   Request::Request (Net net, const uint8_t * adu, size_t len) :
-    Request (net, std::vector<uint8_t> (adu, adu + len)) {}
+    Message (*new Private (this, net, adu, len)) {}
 
   // ---------------------------------------------------------------------------
   Request::Request (Net net, Function f) :
@@ -85,7 +87,21 @@ namespace Modbus {
 
   // ---------------------------------------------------------------------------
   Request::Request (Request && other) :
-    Message (other) {}
+    Message (std::move (other)) {}
+
+  // ---------------------------------------------------------------------------
+  Request & Request::operator= (const Request & other) {
+
+    Message::operator= (other);
+    return *this;
+  }
+
+  // ---------------------------------------------------------------------------
+  Request & Request::operator= (Request && other) {
+
+    Message::operator= (std::move (other));
+    return *this;
+  }
 
   // ---------------------------------------------------------------------------
   uint16_t Request::registerValue () const {
@@ -101,11 +117,9 @@ namespace Modbus {
 
   // ---------------------------------------------------------------------------
   void Request::registerValues (uint16_t index, uint16_t quantity, uint16_t * values) const {
+    int offset = 6 + index * 2;
 
-    for (uint16_t i = 0; i < quantity; i++) {
-
-      values[i] = registerValue (index + i);
-    }
+    getValues (offset, values, fitting (offset, quantity), EndianBig);
   }
 
   // ---------------------------------------------------------------------------
@@ -125,10 +139,7 @@ namespace Modbus {
   // ---------------------------------------------------------------------------
   void Request::coilValues (uint16_t index, uint16_t quantity, bool * values) const {
 
-    for (uint16_t i = 0; i < quantity; i++) {
-
-      values[i] = coilValue (i + index);
-    }
+    unpackBits (values, pdu() + 6, index, quantity);
   }
 
   // ---------------------------------------------------------------------------
@@ -157,11 +168,9 @@ namespace Modbus {
 
   // ---------------------------------------------------------------------------
   void Request::setRegisterValues (uint16_t index, uint16_t quantity, const uint16_t * values) {
+    int offset = 6 + index * 2;
 
-    for (uint16_t i = 0; i < quantity; i++) {
-
-      setRegisterValue (index + i, values[i]);
-    }
+    setValues (offset, values, fitting (offset, quantity), EndianBig);
   }
 
   // ---------------------------------------------------------------------------
@@ -184,12 +193,77 @@ namespace Modbus {
   // ---------------------------------------------------------------------------
   void Request::setCoilValues (uint16_t index, uint16_t quantity, const bool * values)  {
 
-    for (uint16_t i = 0; i < quantity; i++) {
+    if (quantity > 0) {
+      size_t len = 6 + (index + quantity + 7) / 8;
 
-      setCoilValue (index + i, values[i]);
+      packBits (pdu() + 6, index, values, quantity);
+      setSize (std::max (size(), len));
     }
   }
 
+  // ---------------------------------------------------------------------------
+  uint16_t Request::writeAddress () const {
+
+    return word (5);
+  }
+
+  // ---------------------------------------------------------------------------
+  uint16_t Request::writeQuantity () const {
+
+    return word (7);
+  }
+
+  // ---------------------------------------------------------------------------
+  void Request::writeRegisterValues (uint16_t index, uint16_t quantity, uint16_t * values) const {
+    int offset = 10 + index * 2;
+
+    getValues (offset, values, fitting (offset, quantity), EndianBig);
+  }
+
+  // ---------------------------------------------------------------------------
+  void Request::setWriteAddress (uint16_t addr) {
+
+    setWord (5, addr);
+  }
+
+  // ---------------------------------------------------------------------------
+  void Request::setWriteQuantity (uint16_t n) {
+
+    setWord (7, n);
+    setByte (9, n * 2);
+  }
+
+  // ---------------------------------------------------------------------------
+  void Request::setWriteRegisterValues (uint16_t index, uint16_t quantity, const uint16_t * values) {
+    int offset = 10 + index * 2;
+
+    setValues (offset, values, fitting (offset, quantity), EndianBig);
+  }
+
+  // ---------------------------------------------------------------------------
+  uint16_t Request::andMask () const {
+
+    return word (3);
+  }
+
+  // ---------------------------------------------------------------------------
+  uint16_t Request::orMask () const {
+
+    return word (5);
+  }
+
+  // ---------------------------------------------------------------------------
+  void Request::setAndMask (uint16_t mask) {
+
+    setWord (3, mask);
+  }
+
+  // ---------------------------------------------------------------------------
+  void Request::setOrMask (uint16_t mask) {
+
+    setWord (5, mask);
+  }
+
   // ---------------------------------------------------------------------------
   //
   //                         Request::Private Class
@@ -201,8 +275,8 @@ namespace Modbus {
     Message::Private (q, b) {}
 
   // ---------------------------------------------------------------------------
-  Request::Private::Private (Request * q, NetLayer * b, const std::vector<uint8_t> & m) :
-    Message::Private (q, b, m) {}
+  Request::Private::Private (Request * q, NetLayer * b, const uint8_t * m, size_t len) :
+    Message::Private (q, b, m, len) {}
 
   // ---------------------------------------------------------------------------
   Request::Private::Private (Request * q, NetLayer * b, Function f) :
@@ -213,8 +287,8 @@ namespace Modbus {
     Message::Private (q, n) {}
 
   // ---------------------------------------------------------------------------
-  Request::Private::Private (Request * q, Net n, const std::vector<uint8_t> & m) :
-    Message::Private (q, n, m) {}
+  Request::Private::Private (Request * q, Net n, const uint8_t * m, size_t len) :
+    Message::Private (q, n, m, len) {}
 
   // ---------------------------------------------------------------------------
   Request::Private::Private (Request * q, Net n, Function f) :
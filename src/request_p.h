@@ -24,10 +24,10 @@ namespace Modbus {
   class Request::Private : public Message::Private {
     public:
       Private (Request * q, NetLayer * b);
-      Private (Request * q, NetLayer * b, const std::vector<uint8_t> & m);
+      Private (Request * q, NetLayer * b, const uint8_t * m, size_t len);
       Private (Request * q, NetLayer * b, Function f);
       Private (Request * q, Net n);
-      Private (Request * q, Net n, const std::vector<uint8_t> & m);
+      Private (Request * q, Net n, const uint8_t * m, size_t len);
       Private (Request * q, Net n, Function f);
       virtual ~Private();
       PIMP_DECLARE_PUBLIC (Request)
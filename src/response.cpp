@@ -14,10 +14,12 @@
  * You should have received a copy of the GNU Lesser General Public License
  * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
  */
+#include <algorithm>
 #include <modbuspp/device.h>
 #include <modbuspp/netlayer.h>
 #include <modbuspp/response.h>
 #include <modbuspp/request.h>
+#include <modbuspp/bitarray.h>
 #include "response_p.h"
 #include "config.h"
 
@@ -38,7 +40,7 @@ namespace Modbus {
 
   // ---------------------------------------------------------------------------
   Response::Response (NetLayer & backend, const std::vector<uint8_t> & adu) :
-    Message (*new Private (this, &backend, adu)) {}
+    Response (backend, adu.data(), adu.size()) {}
 
   // ---------------------------------------------------------------------------
   Response::Response (NetLayer & backend, Function f) :
@@ -54,11 +56,11 @@ namespace Modbus {
 
   // ---------------------------------------------------------------------------
   Response::Response (NetLayer & backend, const uint8_t * adu, size_t len) :
-    Response (backend, std::vector<uint8_t> (adu, adu + len)) {}
+    Message (*new Private (this, &backend, adu, len)) {}
 
   // ---------------------------------------------------------------------------
   Response::Response (Device & dev, const uint8_t * adu, size_t len) :
-    Response (dev, std::vector<uint8_t> (adu, adu + len)) {}
+    Response (dev.backend(), adu, len) {}
 
   // ---------------------------------------------------------------------------
   Response::Response (Device & dev, Function f) :
@@ -66,43 +68,56 @@ namespace Modbus {
 
   // ---------------------------------------------------------------------------
   Response::Response (const Request & req) :
-    Message (req) {
-    PIMP_D(Response);
-    
-    d->isResponse = true;
-  }
-  
+    Response (static_cast<const Message &> (req)) {}
+
   // ---------------------------------------------------------------------------
+  // msg may hold the private data of a request, the ADU is copied in the
+  // private data of a response
   Response::Response (const Message & msg) :
-    Message (msg) {
-    PIMP_D(Response);
-    
+    Message (*new Private (this, msg.net())) {
+    PIMP_D (Response);
+
+    Message::operator= (msg);
     d->isResponse = true;
   }
 
   // ---------------------------------------------------------------------------
   Response::Response (const Response & other) :
-    Message (other) {}
+    Message (*new Private (this, other.net())) {
+
+    Message::operator= (other);
+  }
 
   // ---------------------------------------------------------------------------
   Response::Response (Request && req) :
-    Message (req) {
-    PIMP_D(Response);
-    
-    d->isResponse = true;
-  }
-  
+    Response (static_cast<Message &&> (req)) {}
+
   // ---------------------------------------------------------------------------
+  // the private data of a request can not become those of a response, the ADU
+  // is copied in a block of the pool, as a copy, then msg is left empty and
+  // its private data return to the pool
   Response::Response (Message && msg) :
-    Message (msg) {
-    PIMP_D(Response);
-    
-    d->isResponse = true;
+    Response (static_cast<const Message &> (msg)) {
+    Message released (std::move (msg));
   }
 
   // ---------------------------------------------------------------------------
   Response::Response (Response && other) :
-    Message (other) {}
+    Message (std::move (other)) {}
+
+  // ---------------------------------------------------------------------------
+  Response & Response::operator= (const Response & other) {
+
+    Message::operator= (other);
+    return *this;
+  }
+
+  // ---------------------------------------------------------------------------
+  Response & Response::operator= (Response && other) {
+
+    Message::operator= (std::move (other));
+    return *this;
+  }
 
   // ---------------------------------------------------------------------------
   void Response::setByteCount (uint8_t n) {
@@ -117,12 +132,10 @@ namespace Modbus {
   }
 
   // ---------------------------------------------------------------------------
-  void Response::setRegisterValues (uint16_t index, uint16_t quantity, const uint16_t * value) {
+  void Response::setRegisterValues (uint16_t index, uint16_t quantity, const uint16_t * values) {
+    int offset = 2 + index * 2;
 
-    for (uint16_t i = 0; i < quantity; i++) {
-
-      setRegisterValue (index + i, value[i]);
-    }
+    setValues (offset, values, fitting (offset, quantity), EndianBig);
   }
 
   // ---------------------------------------------------------------------------
@@ -130,18 +143,20 @@ namespace Modbus {
     uint8_t b, bit = index % 8;
 
     index /= 8;
-    b = byte (index);
+    b = byte (index + 2);
     b &= ~ (1 << bit);
     b |= (value ? 1 : 0) << bit;
-    setByte (index, b);
+    setByte (index + 2, b);
   }
 
   // ---------------------------------------------------------------------------
   void Response::setBitValues (uint16_t index, uint16_t quantity, const bool * values)  {
 
-    for (uint16_t i = 0; i < quantity; i++) {
+    if (quantity > 0) {
+      size_t len = 2 + (index + quantity + 7) / 8;
 
-      setBitValue (index + i, values[i]);
+      packBits (pdu() + 2, index, values, quantity);
+      setSize (std::max (size(), len));
     }
   }
 
@@ -166,11 +181,9 @@ namespace Modbus {
 
   // ---------------------------------------------------------------------------
   void Response::registerValues (uint16_t index, uint16_t quantity, uint16_t * values) const {
+    int offset = 2 + index * 2;
 
-    for (uint16_t i = 0; i < quantity; i++) {
-
-      values[i] = registerValue (index + i);
-    }
+    getValues (offset, values, fitting (offset, quantity), EndianBig);
   }
 
   // ---------------------------------------------------------------------------
@@ -178,16 +191,13 @@ namespace Modbus {
     uint8_t bit = index % 8;
 
     index /= 8;
-    return (byte (index) & (1 << bit)) != 0;
+    return (byte (index + 2) & (1 << bit)) != 0;
   }
 
   // ---------------------------------------------------------------------------
   void Response::bitValues (uint16_t index, uint16_t quantity, bool * values) const {
 
-    for (uint16_t i = 0; i < quantity; i++) {
-
-      values[i] = bitValue (index + i);
-    }
+    unpackBits (values, pdu() + 2, index, quantity);
   }
 
 
@@ -202,8 +212,12 @@ namespace Modbus {
     Message::Private (q, b) {}
 
   // ---------------------------------------------------------------------------
-  Response::Private::Private (Response * q, NetLayer * b, const std::vector<uint8_t> & m) :
-    Message::Private (q, b, m) {}
+  Response::Private::Private (Response * q, Net n) :
+    Message::Private (q, n) {}
+
+  // ---------------------------------------------------------------------------
+  Response::Private::Private (Response * q, NetLayer * b, const uint8_t * m, size_t len) :
+    Message::Private (q, b, m, len) {}
 
   // ---------------------------------------------------------------------------
   Response::Private::Private (Response * q, NetLayer * b, Function f) :
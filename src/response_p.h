@@ -24,7 +24,8 @@ namespace Modbus {
   class Response::Private : public Message::Private {
     public:
       Private (Response * q, NetLayer * b);
-      Private (Response * q, NetLayer * b, const std::vector<uint8_t> & m);
+      Private (Response * q, Net n);
+      Private (Response * q, NetLayer * b, const uint8_t * m, size_t len);
       Private (Response * q, NetLayer * b, Function f);
       virtual ~Private();
       PIMP_DECLARE_PUBLIC (Response)
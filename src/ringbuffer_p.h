@@ -0,0 +1,138 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+namespace Modbus {
+
+  /*
+   * Bounded lock-free queue of fixed-size slots, several producers and
+   * consumers (D. Vyukov's algorithm).
+   *
+   * Each slot carries a sequence number telling whether it is free for the
+   * producer of the position pos (seq == pos) or filled for the consumer of
+   * that position (seq == pos + 1). The slots are filled and read in place
+   * by the functions passed to push() and pop(), so that an element is
+   * copied only once. Neither push() nor pop() blocks, they fail when the
+   * queue is full or empty.
+   */
+  template <typename T>
+  class RingBuffer {
+
+    public:
+      // the capacity is rounded up to a power of 2
+      explicit RingBuffer (size_t capacity) : m_mask (0), m_head (0), m_tail (0) {
+        size_t n = 2;
+
+        while (n < capacity) {
+          n <<= 1;
+        }
+        m_slots.reset (new Slot[n]);
+        m_mask = n - 1;
+        for (size_t i = 0; i < n; i++) {
+
+          m_slots[i].seq.store (i, std::memory_order_relaxed);
+        }
+      }
+
+      size_t capacity() const {
+        return m_mask + 1;
+      }
+
+      // calls fill (T &) on a free slot, returns false if the queue is full
+      template <typename F>
+      bool push (F fill) {
+        Slot * s;
+        size_t pos = m_head.load (std::memory_order_relaxed);
+
+        for (;;) {
+          s = &m_slots[pos & m_mask];
+          size_t seq = s->seq.load (std::memory_order_acquire);
+          intptr_t diff = static_cast<intptr_t> (seq) - static_cast<intptr_t> (pos);
+
+          if (diff == 0) {
+            if (m_head.compare_exchange_weak (pos, pos + 1, std::memory_order_relaxed)) {
+              break;
+            }
+          }
+          else if (diff < 0) {
+            return false; // full
+          }
+          else {
+            pos = m_head.load (std::memory_order_relaxed);
+          }
+        }
+        fill (s->value);
+        s->seq.store (pos + 1, std::memory_order_release);
+        return true;
+      }
+
+      // calls read (T &) on the oldest slot, returns false if the queue is empty
+      template <typename F>
+      bool pop (F read) {
+        Slot * s;
+        size_t pos = m_tail.load (std::memory_order_relaxed);
+
+        for (;;) {
+          s = &m_slots[pos & m_mask];
+          size_t seq = s->seq.load (std::memory_order_acquire);
+          intptr_t diff = static_cast<intptr_t> (seq) - static_cast<intptr_t> (pos + 1);
+
+          if (diff == 0) {
+            if (m_tail.compare_exchange_weak (pos, pos + 1, std::memory_order_relaxed)) {
+              break;
+            }
+          }
+          else if (diff < 0) {
+            return false; // empty
+          }
+          else {
+            pos = m_tail.load (std::memory_order_relaxed);
+          }
+        }
+        read (s->value);
+        s->seq.store (pos + m_mask + 1, std::memory_order_release);
+        return true;
+      }
+
+      bool empty() const {
+        return m_head.load (std::memory_order_acquire) ==
+               m_tail.load (std::memory_order_acquire);
+      }
+
+    private:
+      struct Slot {
+        std::atomic<size_t> seq;
+        T value;
+      };
+
+      std::unique_ptr<Slot[]> m_slots;
+      size_t m_mask;
+      // producers and consumers on separate cache lines
+      char m_pad0[64];
+      std::atomic<size_t> m_head;
+      char m_pad1[64 - sizeof (size_t)];
+      std::atomic<size_t> m_tail;
+      char m_pad2[64 - sizeof (size_t)];
+  };
+}
+
+/* ========================================================================== */
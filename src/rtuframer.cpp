@@ -0,0 +1,379 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <algorithm>
+#include <modbuspp/rtulayer.h>
+#include "rtuframer_p.h"
+#include "config.h"
+
+namespace Modbus {
+
+  namespace {
+
+    uint64_t now() {
+
+      return std::chrono::duration_cast<std::chrono::microseconds> (
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  //
+  //                         RtuFramer Class
+  //
+  // ---------------------------------------------------------------------------
+
+  // ---------------------------------------------------------------------------
+  RtuFramer::RtuFramer (RtuFramer::Private &dd) : d_ptr (&dd) {}
+
+  // ---------------------------------------------------------------------------
+  RtuFramer::RtuFramer (int baudrate, Direction d) :
+    d_ptr (new Private (this, baudrate, d)) {}
+
+  // ---------------------------------------------------------------------------
+  RtuFramer::~RtuFramer() = default;
+
+  // ---------------------------------------------------------------------------
+  void RtuFramer::setCallback (Callback cb) {
+    PIMP_D (RtuFramer);
+
+    d->cb = cb;
+  }
+
+  // ---------------------------------------------------------------------------
+  int RtuFramer::baudrate() const {
+    PIMP_D (const RtuFramer);
+
+    return d->baudrate;
+  }
+
+  // ---------------------------------------------------------------------------
+  void RtuFramer::setBaudrate (int baudrate) {
+    PIMP_D (RtuFramer);
+
+    d->setBaudrate (baudrate);
+  }
+
+  // ---------------------------------------------------------------------------
+  RtuFramer::Direction RtuFramer::direction() const {
+    PIMP_D (const RtuFramer);
+
+    return d->direction;
+  }
+
+  // ---------------------------------------------------------------------------
+  void RtuFramer::setDirection (Direction dir) {
+    PIMP_D (RtuFramer);
+
+    d->direction = dir;
+  }
+
+  // ---------------------------------------------------------------------------
+  unsigned long RtuFramer::silenceTime() const {
+    PIMP_D (const RtuFramer);
+
+    return d->t35;
+  }
+
+  // ---------------------------------------------------------------------------
+  int RtuFramer::push (const uint8_t * data, size_t len, uint64_t timestamp) {
+    PIMP_D (RtuFramer);
+    int n = 0;
+
+    if (len == 0) {
+
+      return poll (timestamp);
+    }
+
+    if (timestamp == 0) {
+
+      timestamp = now();
+    }
+
+    if (d->len > 0 || d->skipping) {
+      // reception time of the first byte
+      uint64_t first = timestamp - std::min<uint64_t> (timestamp, (len - 1) * d->charTime);
+
+      if (first > d->last && (first - d->last) >= d->t35) {
+
+        n += d->end();
+      }
+    }
+
+    for (size_t i = 0; i < len; i++) {
+
+      n += d->append (data[i]);
+    }
+    d->last = timestamp;
+    return n;
+  }
+
+  // ---------------------------------------------------------------------------
+  int RtuFramer::poll (uint64_t timestamp) {
+    PIMP_D (RtuFramer);
+
+    if (d->len > 0 || d->skipping) {
+
+      if (timestamp == 0) {
+
+        timestamp = now();
+      }
+      if (timestamp > d->last && (timestamp - d->last) >= d->t35) {
+
+        return d->end();
+      }
+    }
+    return 0;
+  }
+
+  // ---------------------------------------------------------------------------
+  void RtuFramer::reset() {
+    PIMP_D (RtuFramer);
+
+    d->discard();
+    d->skipping = false;
+  }
+
+  // ---------------------------------------------------------------------------
+  size_t RtuFramer::pending() const {
+    PIMP_D (const RtuFramer);
+
+    return d->len;
+  }
+
+  // ---------------------------------------------------------------------------
+  unsigned long RtuFramer::frames() const {
+    PIMP_D (const RtuFramer);
+
+    return d->frames;
+  }
+
+  // ---------------------------------------------------------------------------
+  unsigned long RtuFramer::errors() const {
+    PIMP_D (const RtuFramer);
+
+    return d->errors;
+  }
+
+  // ---------------------------------------------------------------------------
+  // static
+  int RtuFramer::frameLength (const uint8_t * adu, size_t len, bool response) {
+
+    if (len < 2) {
+
+      return 0;
+    }
+
+    if (response) {
+
+      if (adu[1] & ExceptionFlag) {
+
+        return 5;
+      }
+
+      switch (adu[1]) {
+        case 1: // Read Coils
+        case 2: // Read Discrete Inputs
+        case 3: // Read Holding Registers
+        case 4: // Read Input Registers
+        case 12: // Get Comm Event Log
+        case 17: // Report Server ID
+        case 20: // Read File Record
+        case 21: // Write File Record
+        case 23: // Read/Write Multiple registers
+          // slave, function, byte count, data, crc
+          return len < 3 ? 0 : 5 + adu[2];
+        case 5: // Write Single Coil
+        case 6: // Write Single Register
+        case 8: // Diagnostics
+        case 11: // Get Comm Event Counter
+        case 15: // Write Multiple Coils
+        case 16: // Write Multiple registers
+          return 8;
+        case 7: // Read Exception Status
+          return 5;
+        case 22: // Mask Write Register
+          return 10;
+        case 24: // Read FIFO Queue, 16-bit byte count
+          return len < 4 ? 0 : 6 + ( (adu[2] << 8) | adu[3]);
+        default:
+          return -1;
+      }
+    }
+
+    switch (adu[1]) {
+      case 1: // Read Coils
+      case 2: // Read Discrete Inputs
+      case 3: // Read Holding Registers
+      case 4: // Read Input Registers
+      case 5: // Write Single Coil
+      case 6: // Write Single Register
+      case 8: // Diagnostics
+        return 8;
+      case 7: // Read Exception Status
+      case 11: // Get Comm Event Counter
+      case 12: // Get Comm Event Log
+      case 17: // Report Server ID
+        return 4;
+      case 15: // Write Multiple Coils
+      case 16: // Write Multiple registers
+        // slave, function, address, quantity, byte count, data, crc
+        return len < 7 ? 0 : 9 + adu[6];
+      case 20: // Read File Record
+      case 21: // Write File Record
+        return len < 3 ? 0 : 5 + adu[2];
+      case 22: // Mask Write Register
+        return 10;
+      case 23: // Read/Write Multiple registers
+        return len < 11 ? 0 : 13 + adu[10];
+      case 24: // Read FIFO Queue
+        return 6;
+      default:
+        return -1;
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  //
+  //                         RtuFramer::Private Class
+  //
+  // ---------------------------------------------------------------------------
+
+  // ---------------------------------------------------------------------------
+  RtuFramer::Private::Private (RtuFramer * q, int b, Direction d) :
+    q_ptr (q), direction (d), len (0), crcLen (0), crc (0xFFFF),
+    skipping (false), last (0), frames (0), errors (0) {
+
+    setBaudrate (b);
+  }
+
+  // ---------------------------------------------------------------------------
+  RtuFramer::Private::~Private() = default;
+
+  // ---------------------------------------------------------------------------
+  void RtuFramer::Private::setBaudrate (int b) {
+
+    baudrate = std::max (b, 1);
+    // a character is 11 bits long (start, 8 data bits, parity or stop, stop)
+    charTime = (11000000UL + baudrate - 1) / baudrate;
+    // fixed value of 1.75 ms above 19200 bauds
+    t35 = (baudrate > 19200) ? 1750 : (38500000UL + baudrate - 1) / baudrate;
+  }
+
+  // ---------------------------------------------------------------------------
+  // returns the number of frames emitted
+  int RtuFramer::Private::append (uint8_t b) {
+    int maxLength = 0;
+    bool undetermined = false;
+
+    if (skipping) {
+
+      return 0;
+    }
+
+    if (len == buf.size()) {
+
+      // too long, wait for the end of this frame
+      errors++;
+      discard();
+      skipping = true;
+      return 0;
+    }
+    buf[len++] = b;
+
+    for (int dir = Requests; dir <= Responses; dir <<= 1) {
+
+      if (direction & dir) {
+        int l = frameLength (buf.data(), len, dir == Responses);
+
+        if (l > 0) {
+
+          if (static_cast<size_t> (l) == len) {
+
+            crc = RtuLayer::crc16 (&buf[crcLen], len - crcLen, crc);
+            crcLen = len;
+            if (crc == 0) {
+
+              emit (dir == Responses);
+              return 1;
+            }
+          }
+          maxLength = std::max (maxLength, l);
+        }
+        else {
+
+          undetermined = true;
+        }
+      }
+    }
+
+    if (!undetermined && len >= static_cast<size_t> (maxLength)) {
+
+      // no expected length matches a valid CRC
+      errors++;
+      discard();
+      skipping = true;
+    }
+    return 0;
+  }
+
+  // ---------------------------------------------------------------------------
+  // end of frame detected by a silence
+  int RtuFramer::Private::end() {
+
+    if (skipping) {
+
+      skipping = false;
+    }
+    else if (len > 0) {
+
+      crc = RtuLayer::crc16 (&buf[crcLen], len - crcLen, crc);
+      crcLen = len;
+      if (len >= 4 && crc == 0) {
+
+        emit (direction == Responses);
+        return 1;
+      }
+      errors++;
+    }
+    discard();
+    return 0;
+  }
+
+  // ---------------------------------------------------------------------------
+  void RtuFramer::Private::emit (bool response) {
+    Message msg (Rtu, buf.data(), len);
+
+    msg.setResponseFlag (response);
+    frames++;
+    discard();
+    if (cb) {
+
+      cb (msg);
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  void RtuFramer::Private::discard() {
+
+    len = 0;
+    crcLen = 0;
+    crc = 0xFFFF;
+  }
+}
+
+/* ========================================================================== */
@@ -0,0 +1,54 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <array>
+#include <modbuspp/rtuframer.h>
+
+namespace Modbus {
+
+  class RtuFramer::Private {
+
+    public:
+      Private (RtuFramer * q, int baudrate, Direction d);
+      virtual ~Private();
+      void setBaudrate (int baudrate);
+      int append (uint8_t b);
+      int end();
+      void emit (bool response);
+      void discard();
+
+      RtuFramer * const q_ptr;
+      Callback cb;
+      Direction direction;
+      int baudrate;
+      unsigned long charTime; // µs
+      unsigned long t35;      // µs
+      std::array<uint8_t, MODBUS_RTU_MAX_ADU_LENGTH> buf;
+      size_t len;
+      size_t crcLen;  // number of bytes of buf included in crc
+      uint16_t crc;
+      bool skipping;  // bytes are ignored until the next silence
+      uint64_t last;  // reception time of the last byte
+      unsigned long frames;
+      unsigned long errors;
+
+      PIMP_DECLARE_PUBLIC (RtuFramer)
+  };
+}
+
+/* ========================================================================== */
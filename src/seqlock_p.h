@@ -0,0 +1,134 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <cstdint>
+
+namespace Modbus {
+
+  /*
+   * Sequence lock: the counter is odd while the data are written, the
+   * writers take it with a CAS, the readers copy the data and start again
+   * if the counter has changed during the copy. The counter can be placed
+   * in a shared memory segment to synchronize several processes.
+   * The writes of a thread can be nested.
+   */
+  class SeqLock {
+
+    public:
+      SeqLock() : counter (&local), local (0), depth (0) {}
+
+      // counter shared with other processes, the local one if c is null
+      void setCounter (std::atomic<uint32_t> * c) {
+        counter = c ? c : &local;
+      }
+
+      // starts a write, waits for the writes of the other threads
+      void lock() {
+        std::thread::id self = std::this_thread::get_id();
+
+        if (writer.load (std::memory_order_relaxed) == self) {
+
+          depth++;
+          return;
+        }
+
+        uint32_t s = counter->load (std::memory_order_relaxed);
+        for (;;) {
+
+          if (! (s & 1) && counter->compare_exchange_weak (s, s + 1,
+              std::memory_order_acquire, std::memory_order_relaxed)) {
+            break;
+          }
+          std::this_thread::yield();
+          s = counter->load (std::memory_order_relaxed);
+        }
+        // the data must not be written before the counter is odd
+        std::atomic_thread_fence (std::memory_order_release);
+        writer.store (self, std::memory_order_relaxed);
+        depth = 1;
+      }
+
+      // ends a write, the data become visible to the readers when the outer
+      // write ends
+      void unlock() {
+
+        if (writer.load (std::memory_order_relaxed) == std::this_thread::get_id() &&
+            --depth == 0) {
+
+          writer.store (std::thread::id(), std::memory_order_relaxed);
+          counter->fetch_add (1, std::memory_order_release);
+        }
+      }
+
+      // value of the counter, changed by each write
+      uint32_t sequence() const {
+        return counter->load (std::memory_order_acquire);
+      }
+
+      // starts a read, waits for the write in progress of another thread and
+      // returns the value of the counter to pass to validate()
+      uint32_t readBegin() const {
+
+        for (;;) {
+          uint32_t s = counter->load (std::memory_order_acquire);
+
+          // read in a write of this thread if odd
+          if (! (s & 1) ||
+              writer.load (std::memory_order_relaxed) == std::this_thread::get_id()) {
+
+            return s;
+          }
+          std::this_thread::yield();
+        }
+      }
+
+      // ends a read started by readBegin() which returned s, false if the
+      // data have been written in the meantime and must be read again.
+      // Allows to read data protected by several locks at the same time.
+      bool validate (uint32_t s) const {
+
+        std::atomic_thread_fence (std::memory_order_acquire);
+        return counter->load (std::memory_order_relaxed) == s;
+      }
+
+      // calls f until the data it reads have not been written during the call
+      template <typename F>
+      void read (F f) const {
+
+        for (;;) {
+          uint32_t s = readBegin();
+
+          f();
+          if (validate (s)) {
+
+            return;
+          }
+        }
+      }
+
+    private:
+      std::atomic<uint32_t> * counter;
+      std::atomic<uint32_t> local;
+      std::atomic<std::thread::id> writer;
+      int depth; // nested writes of the writer thread
+  };
+}
+
+/* ========================================================================== */
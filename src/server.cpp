@@ -17,6 +17,7 @@
 #include <fstream>
 #include <iostream> // for debug
 #include <sstream>
+#include <cstring>
 #ifdef _WIN32
 # include <winsock2.h>
 # if defined(SD_BOTH) && ! defined(SHUT_RDWR)
@@ -24,10 +25,15 @@
 # endif
 #else
 # include <sys/socket.h>
+# include <sys/un.h>
 # include <fcntl.h>
 # include <unistd.h>
 #endif
+#include <modbuspp/capture.h>
 #include "server_p.h"
+#include "bufferedslave_p.h"
+#include "snapshot_p.h"
+#include "filerecord_p.h"
 #include "config.h"
 
 using json = nlohmann::json;
@@ -67,6 +73,7 @@ namespace Modbus {
   Server::~Server() {
 
     // std::cout << "-- ~Server --" << std::endl;
+    stopReplication();
     terminate();
   }
 
@@ -211,6 +218,87 @@ namespace Modbus {
     return d->slave;
   }
 
+  // ---------------------------------------------------------------------------
+  std::vector<uint8_t> Server::snapshot() const {
+    PIMP_D (const Server);
+
+    return d->snapshot();
+  }
+
+  // ---------------------------------------------------------------------------
+  std::vector<uint8_t> Server::snapshot (const std::vector<uint8_t> & previous) const {
+    std::vector<uint8_t> current = snapshot();
+    SnapshotFormat::Header ph, ch;
+    std::vector<SnapshotFormat::Record> pr, cr;
+
+    if (SnapshotFormat::parse (previous, ph, pr) && ! (ph.flags & SnapshotFormat::Delta) &&
+        SnapshotFormat::parse (current, ch, cr)) {
+
+      // compared out of the lock of the slaves
+      return SnapshotFormat::delta (ph, pr, ch, cr);
+    }
+    return current;
+  }
+
+  // ---------------------------------------------------------------------------
+  int Server::restore (const std::vector<uint8_t> & snapshot) {
+    PIMP_D (Server);
+    SnapshotFormat::Header h;
+    std::vector<SnapshotFormat::Record> records;
+    int rc = 0;
+
+    if (!SnapshotFormat::parse (snapshot, h, records)) {
+
+      return -1;
+    }
+
+    for (const auto & s : d->slave) {
+
+      s.second->beginUpdate();
+    }
+
+    for (const auto & r : records) {
+      auto s = d->slave.find (r.slave);
+
+      if (s != d->slave.end()) {
+        BufferedSlave::Private * sd = s->second->d_func();
+        int n = r.count;
+
+        // the values must be in a single block
+        if (SnapshotFormat::isBit (r.table)) {
+          uint8_t * p = sd->findBits (r.table, r.start, n);
+
+          if (p && n == r.count) {
+
+            for (int i = 0; i < n; i++) {
+
+              p[i] = r.bit (i);
+            }
+            rc += n;
+          }
+        }
+        else {
+          uint16_t * p = sd->findRegisters (r.table, r.start, n);
+
+          if (p && n == r.count) {
+
+            for (int i = 0; i < n; i++) {
+
+              p[i] = r.reg (i);
+            }
+            rc += n;
+          }
+        }
+      }
+    }
+
+    for (auto s = d->slave.rbegin(); s != d->slave.rend(); ++s) {
+
+      s->second->endUpdate();
+    }
+    return rc;
+  }
+
   // ---------------------------------------------------------------------------
   Message::Callback Server::messageCallback() const {
     PIMP_D (const Server);
@@ -225,18 +313,426 @@ namespace Modbus {
     d->messageCB = cb;
   }
 
+  // ---------------------------------------------------------------------------
+  void Server::setFunctionHandler (int function, BufferedSlave::FunctionHandler handler) {
+    PIMP_D (Server);
+
+    if (isOpen()) {
+
+      throw std::logic_error ("Unable to set a function handler when open !");
+    }
+    if (d->handlers.empty()) {
+
+      d->handlers.resize (256);
+    }
+    d->handlers[function & 0xFF] = handler;
+  }
+
+  // ---------------------------------------------------------------------------
+  BufferedSlave::FunctionHandler Server::functionHandler (int function) const {
+    PIMP_D (const Server);
+    const BufferedSlave::FunctionHandler * h = d->handler (function);
+
+    return h ? *h : BufferedSlave::FunctionHandler();
+  }
+
+  // ---------------------------------------------------------------------------
+  bool Server::startReplication (const std::string & path, int period) {
+    PIMP_D (Server);
+
+    stopReplication();
+#ifndef _WIN32
+    struct sockaddr_un addr;
+
+    if (path.size() >= sizeof (addr.sun_path)) {
+
+      errno = ENAMETOOLONG;
+      return false;
+    }
+    memset (&addr, 0, sizeof (addr));
+    addr.sun_family = AF_UNIX;
+    strcpy (addr.sun_path, path.c_str());
+
+    d->replicationSock = ::socket (AF_UNIX, SOCK_STREAM, 0);
+    if (d->replicationSock >= 0) {
+
+      ::unlink (path.c_str());
+      if (::bind (d->replicationSock, reinterpret_cast<struct sockaddr *> (&addr), sizeof (addr)) == 0 &&
+          ::listen (d->replicationSock, 8) == 0 &&
+          ::fcntl (d->replicationSock, F_SETFL, O_NONBLOCK) == 0) {
+
+        d->replicationSequence = 0;
+        d->stopReplicator = false;
+        d->replicating = true;
+        d->replicator = std::thread (Private::primary, d, std::max (period, 1));
+        return true;
+      }
+      int saved_errno = errno;
+      ::close (d->replicationSock);
+      d->replicationSock = -1;
+      errno = saved_errno;
+    }
+#else
+    errno = ENOSYS;
+#endif
+    return false;
+  }
+
+  // ---------------------------------------------------------------------------
+  bool Server::replicateFrom (const std::string & path) {
+    PIMP_D (Server);
+
+    stopReplication();
+#ifndef _WIN32
+    struct sockaddr_un addr;
+
+    if (path.size() >= sizeof (addr.sun_path)) {
+
+      errno = ENAMETOOLONG;
+      return false;
+    }
+    memset (&addr, 0, sizeof (addr));
+    addr.sun_family = AF_UNIX;
+    strcpy (addr.sun_path, path.c_str());
+
+    d->replicationSock = ::socket (AF_UNIX, SOCK_STREAM, 0);
+    if (d->replicationSock >= 0) {
+
+      if (::connect (d->replicationSock, reinterpret_cast<struct sockaddr *> (&addr), sizeof (addr)) == 0) {
+
+        d->replicationSequence = 0;
+        d->stopReplicator = false;
+        d->replicating = true;
+        d->replicator = std::thread (Private::standby, d);
+        return true;
+      }
+      int saved_errno = errno;
+      ::close (d->replicationSock);
+      d->replicationSock = -1;
+      errno = saved_errno;
+    }
+#else
+    errno = ENOSYS;
+#endif
+    return false;
+  }
+
+  // ---------------------------------------------------------------------------
+  void Server::stopReplication() {
+    PIMP_D (Server);
+
+    if (d->replicator.joinable()) {
+
+      d->stopReplicator = true;
+      // wakes up the standby waiting for the primary
+      ::shutdown (d->replicationSock, SHUT_RDWR);
+      d->replicator.join();
+    }
+    if (d->replicationSock >= 0) {
+
+#ifndef _WIN32
+      ::close (d->replicationSock);
+#endif
+      d->replicationSock = -1;
+    }
+    d->replicating = false;
+  }
+
+  // ---------------------------------------------------------------------------
+  bool Server::isReplicating() const {
+    PIMP_D (const Server);
+
+    return d->replicating;
+  }
+
+  // ---------------------------------------------------------------------------
+  uint64_t Server::replicationSequence() const {
+    PIMP_D (const Server);
+
+    return d->replicationSequence;
+  }
+
   // ---------------------------------------------------------------------------
   //
   //                         Server::Private Class
   //
   // ---------------------------------------------------------------------------
 
+  // full snapshot of the slaves, all the slaves at the same point in time:
+  // the copy starts again if a slave has been written during it
+  std::vector<uint8_t> Server::Private::snapshot() const {
+    std::vector<uint32_t> seq (slave.size());
+
+    for (;;) {
+      SnapshotFormat::Writer w;
+      size_t i = 0;
+
+      for (const auto & s : slave) {
+
+        seq[i++] = s.second->d_func()->seqlock.readBegin();
+      }
+
+      for (const auto & s : slave) {
+        BufferedSlave::Private * sd = s.second->d_func();
+
+        for (Table t : { DiscreteInput, Coil, InputRegister, HoldingRegister }) {
+
+          for (const auto & e : sd->blocks[t].index) {
+            int n = e.end - e.start;
+
+            if (SnapshotFormat::isBit (t)) {
+
+              w.addBits (s.first, t, e.start, sd->findBits (t, e.start, n), n);
+            }
+            else {
+
+              w.addRegisters (s.first, t, e.start, sd->findRegisters (t, e.start, n), n);
+            }
+          }
+        }
+      }
+
+      i = 0;
+      for (const auto & s : slave) {
+
+        if (!s.second->d_func()->seqlock.validate (seq[i])) {
+          break;
+        }
+        i++;
+      }
+      if (i == slave.size()) {
+
+        return w.finish();
+      }
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // changes when a slave is written
+  uint32_t Server::Private::version() const {
+    uint32_t v = 0;
+
+    for (const auto & s : slave) {
+
+      v += s.second->d_func()->seqlock.sequence();
+    }
+    return v;
+  }
+
+#ifndef _WIN32
+  namespace {
+
+    // frame of the replication stream:
+    // | length (u32) | sequence (u64) | snapshot |, little endian
+    const size_t FrameHeaderSize = 12;
+
+    // size of the frames not yet read by a standby beyond which it is
+    // dropped, at least twice a full snapshot, the standbys are never
+    // waited for
+    const size_t MaxBacklog = 4 << 20;
+
+    // standby connected to the primary
+    struct Standby {
+      int fd;
+      std::vector<uint8_t> backlog; // frames not yet sent
+    };
+
+    void queueFrame (Standby & sb, uint64_t seq, const std::vector<uint8_t> & s) {
+      uint32_t len = s.size();
+
+      for (int i = 0; i < 4; i++) {
+        sb.backlog.push_back (len >> (8 * i));
+      }
+      for (int i = 0; i < 8; i++) {
+        sb.backlog.push_back (seq >> (8 * i));
+      }
+      sb.backlog.insert (sb.backlog.end(), s.begin(), s.end());
+    }
+
+    // sends the backlog of the standby without blocking, false if the
+    // standby is disconnected or too late
+    bool flushFrames (Standby & sb, size_t maxBacklog) {
+      size_t n = 0;
+
+      while (n < sb.backlog.size()) {
+#ifdef MSG_NOSIGNAL
+        ssize_t rc = ::send (sb.fd, &sb.backlog[n], sb.backlog.size() - n, MSG_NOSIGNAL);
+#else
+        ssize_t rc = ::send (sb.fd, &sb.backlog[n], sb.backlog.size() - n, 0);
+#endif
+        if (rc <= 0) {
+
+          if (rc < 0 && errno == EINTR) {
+            continue;
+          }
+          if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+          }
+          return false;
+        }
+        n += rc;
+      }
+      sb.backlog.erase (sb.backlog.begin(), sb.backlog.begin() + n);
+      return sb.backlog.size() <= maxBacklog;
+    }
+
+    bool receiveAll (int fd, uint8_t * p, size_t n) {
+
+      while (n > 0) {
+        ssize_t rc = ::recv (fd, p, n, 0);
+
+        if (rc <= 0) {
+
+          if (rc < 0 && errno == EINTR) {
+            continue;
+          }
+          return false;
+        }
+        p += rc;
+        n -= rc;
+      }
+      return true;
+    }
+  }
+#endif
+
+  // ---------------------------------------------------------------------------
+  // static
+  // thread of the primary: sends the changes of the slaves to the standbys
+  void Server::Private::primary (Private * d, int period) {
+#ifndef _WIN32
+    std::vector<Standby> standbys;
+    std::vector<uint8_t> base; // last snapshot sent
+    uint32_t version = 0;
+    uint64_t seq = 0;
+
+    while (!d->stopReplicator) {
+      int fd;
+
+      if (!standbys.empty()) {
+        // read before the copy, a write during the copy is sent next time
+        uint32_t v = d->version();
+
+        if (v != version) {
+          std::vector<uint8_t> current = d->snapshot();
+          SnapshotFormat::Header bh, ch;
+          std::vector<SnapshotFormat::Record> br, cr;
+
+          SnapshotFormat::parse (base, bh, br);
+          SnapshotFormat::parse (current, ch, cr);
+          std::vector<uint8_t> delta = SnapshotFormat::delta (bh, br, ch, cr);
+
+          // the version changes also when data are written with the same values
+          if (delta.size() > (SnapshotFormat::HeaderSize + SnapshotFormat::CrcSize)) {
+
+            seq++;
+            for (auto & sb : standbys) {
+
+              queueFrame (sb, seq, delta);
+            }
+          }
+          base.swap (current);
+          version = v;
+        }
+      }
+
+      // the standbys start from the last snapshot sent
+      while ( (fd = ::accept (d->replicationSock, nullptr, nullptr)) >= 0) {
+
+        if (::fcntl (fd, F_SETFL, O_NONBLOCK) != 0) {
+
+          ::close (fd);
+          continue;
+        }
+        if (standbys.empty()) {
+
+          version = d->version();
+          base = d->snapshot();
+        }
+        standbys.push_back (Standby { fd, std::vector<uint8_t>() });
+        queueFrame (standbys.back(), seq, base);
+      }
+
+      // a standby which does not read fast enough is closed and must
+      // connect again, the others are not delayed
+      size_t maxBacklog = std::max (MaxBacklog, 2 * base.size());
+      for (auto it = standbys.begin(); it != standbys.end();) {
+
+        if (flushFrames (*it, maxBacklog)) {
+          ++it;
+        }
+        else {
+
+          ::close (it->fd);
+          it = standbys.erase (it);
+        }
+      }
+
+      d->replicationSequence = seq;
+      std::this_thread::sleep_for (std::chrono::microseconds (period));
+    }
+
+    for (const auto & sb : standbys) {
+
+      ::close (sb.fd);
+    }
+#endif
+  }
+
+  // ---------------------------------------------------------------------------
+  // static
+  // thread of the standby: applies the snapshots of the primary
+  void Server::Private::standby (Private * d) {
+#ifndef _WIN32
+    Server * q = d->q_func();
+    std::vector<uint8_t> s;
+    bool first = true;
+
+    while (!d->stopReplicator) {
+      uint8_t h[FrameHeaderSize];
+      uint32_t len = 0;
+      uint64_t seq = 0;
+
+      if (!receiveAll (d->replicationSock, h, sizeof (h))) {
+        break;
+      }
+      for (int i = 0; i < 4; i++) {
+        len |= static_cast<uint32_t> (h[i]) << (8 * i);
+      }
+      for (int i = 0; i < 8; i++) {
+        seq |= static_cast<uint64_t> (h[4 + i]) << (8 * i);
+      }
+
+      s.resize (len);
+      if (!receiveAll (d->replicationSock, s.data(), len)) {
+        break;
+      }
+
+      // a lost delta would leave the slaves different from the primary
+      if ( (!first && seq != (d->replicationSequence + 1)) || q->restore (s) < 0) {
+        break;
+      }
+      d->replicationSequence = seq;
+      first = false;
+    }
+#endif
+    d->replicating = false;
+  }
+
   // ---------------------------------------------------------------------------
   Server::Private::Private (Server * q) :
-    Device::Private (q), sock (-1), req (0) {}
+    Device::Private (q), sock (-1), req (0), replicationSock (-1),
+    replicating (false), stopReplicator (false), replicationSequence (0) {}
 
   // ---------------------------------------------------------------------------
-  Server::Private::~Private() = default;
+  Server::Private::~Private() {
+
+    // the slaves can outlive the server
+    for (auto & s : slave) {
+
+      s.second->d_func()->server = nullptr;
+    }
+  }
 
   // ---------------------------------------------------------------------------
   // virtual
@@ -279,6 +775,7 @@ namespace Modbus {
     else {
 
       s = std::make_shared<BufferedSlave> (slaveAddr, master);
+      s->d_func()->server = q_func();
       slave[slaveAddr] = s;
     }
     return s.get();
@@ -306,6 +803,7 @@ namespace Modbus {
       PIMP_Q (Server);
 
       req = std::make_shared<Request> (*q);
+      rsp = std::make_shared<Response> (*q, UnknownFunction);
     }
 
     return isOk;
@@ -355,11 +853,20 @@ namespace Modbus {
       if (slave.count (id) > 0) {
 
         if (modbus_set_slave (ctx(), id) == 0) {
-          int ret;
+          int ret = 0;
           BufferedSlave * slv = slave[id].get();
+          // handler of the function code, in constant time
+          const BufferedSlave::FunctionHandler * h = slv->d_func()->handler (req->function());
 
-          // route the message to a possible device to copy its registers to the map.
-          ret = slv->readFromDevice (req.get());
+          if (!h) {
+
+            h = handler (req->function());
+          }
+
+          if (!h) {
+            // route the message to a possible device to copy its registers to the map.
+            ret = slv->readFromDevice (req.get());
+          }
           if (ret >= 0) {
 
             if (slv->beforeReplyCallback()) {
@@ -367,9 +874,36 @@ namespace Modbus {
               if (ret != 0) { // -1 error, 1 exit, 0 continue
                 return ret;
               }
+              if (!req->isValid()) {
+                // the callback has moved the request to its own response
+                return 0;
+              }
             }
 
-            rc = modbus_reply (ctx(), req->adu(), rc, slv->map());
+            if (h) {
+
+              rc = reply (slv, h);
+            }
+            else {
+
+              switch (req->function()) {
+                case ReadFileRecord:
+                case WriteFileRecord:
+                  // not handled by libmodbus
+                case WriteSingleCoil:
+                case WriteSingleRegister:
+                case WriteMultipleCoils:
+                case WriteMultipleRegisters:
+                case MaskWriteRegister:
+                case ReadWriteMultipleRegisters:
+                  // written under the lock of the slave, sent once released
+                  rc = reply (slv, nullptr);
+                  break;
+                default:
+                  rc = slv->reply (ctx(), *req, rc);
+                  break;
+              }
+            }
             if (rc >= 0) {
 
               if (slv->afterReplyCallback()) {
@@ -377,12 +911,17 @@ namespace Modbus {
                 if (ret != 0) { // -1 error, 1 exit, 0 continue
                   return ret;
                 }
+                if (!req->isValid()) {
+                  return 0;
+                }
               }
 
-              // route the message to a possible device to write its registers from map.
-              ret = slv->writeToDevice (req.get());
-              if (ret < 0) {
-                rc = ret;
+              if (!h) {
+                // route the message to a possible device to write its registers from map.
+                ret = slv->writeToDevice (req.get());
+                if (ret < 0) {
+                  rc = ret;
+                }
               }
             }
           }
@@ -400,6 +939,44 @@ namespace Modbus {
     return rc;
   }
 
+  // ---------------------------------------------------------------------------
+  // replies to the request with the handler h, or with slv if h is null, in
+  // the pre-allocated response
+  int Server::Private::reply (BufferedSlave * slv, const BufferedSlave::FunctionHandler * h) {
+    PIMP_Q (Server);
+    int ret = 0;
+
+    static_cast<Message &> (*rsp) = *req;
+    rsp->setResponseFlag();
+    rsp->setSize (1);
+
+    if (h) {
+
+      ret = (*h) (*req, *rsp);
+      if (ret > 0) {
+
+        return 0; // no response
+      }
+      if (ret < 0) {
+
+        rsp->setFunction (req->function());
+        rsp->setExceptionCode (SlaveOrServerFailure);
+        rsp->setSize (2);
+      }
+    }
+    else {
+
+      slv->reply (*req, *rsp);
+    }
+
+    // no response to a broadcast on a serial line, as modbus_reply()
+    if (req->slave() == MODBUS_BROADCAST_ADDRESS && q->net() == Rtu) {
+
+      return 0;
+    }
+    return q->sendRawMessage (*rsp, true);
+  }
+
   // ---------------------------------------------------------------------------
   // static
   int Server::Private::receive (Private * d) {
@@ -412,11 +989,36 @@ namespace Modbus {
         return -1;
       }
     }
+    if (!d->req->isValid()) {
+      // moved to a response by a callback
+      *d->req = Request (*d->q_func());
+    }
     d->req->clear();
     rc = modbus_receive (d->ctx(), d->req->adu());
+    if (rc > 0 && d->backend->net() == Tcp) {
+      uint8_t * adu = d->req->adu();
+      int len = 6 + ( (adu[4] << 8) | adu[5]);
+
+      // libmodbus receives the requests it does not know (e.g. file records)
+      // until their function code, the MBAP header gives the remaining bytes
+      if (len > rc && len <= MaxAduLength) {
+
+        if (FileRecordFormat::readAll (modbus_get_socket (d->ctx()), adu + rc, len - rc,
+                                       d->q_func()->responseTimeout())) {
+          rc = len;
+        }
+        else {
+          rc = -1;
+        }
+      }
+    }
     if (rc > 0) {
 
       d->req->setAduSize (rc);
+      if (d->capture) {
+
+        d->capture->record (d->req->adu(), rc, Capture::Received, false);
+      }
     }
     return rc;
   }
@@ -17,6 +17,8 @@
 #pragma once
 
 #include <map>
+#include <atomic>
+#include <vector>
 #include <future>
 #include <thread>
 #include <modbuspp/server.h>
@@ -36,19 +38,39 @@ namespace Modbus {
       virtual bool open();
       virtual void close();
       int task (int rc);
+      int reply (BufferedSlave * slv, const BufferedSlave::FunctionHandler * h);
+      const BufferedSlave::FunctionHandler * handler (int function) const {
+        return (!handlers.empty() && handlers[function & 0xFF]) ?
+               &handlers[function & 0xFF] : nullptr;
+      }
 
       BufferedSlave * addSlave (int slaveAddr, Device * master);
+      std::vector<uint8_t> snapshot() const;
+      uint32_t version() const;
+
+      static void primary (Private * d, int period);
+      static void standby (Private * d);
 
       static void loop (std::future<void> run, Private * d);
       static int receive (Private * d);
 
       int sock;
       std::shared_ptr<Request> req;
+      std::shared_ptr<Response> rsp; // of the replies not made by libmodbus
       std::map <int, std::shared_ptr<BufferedSlave>> slave;
       std::future<int> receiveTask;
       std::thread daemon;
       std::promise<void> stopDaemon;
       Message::Callback messageCB;
+      // handlers indexed by function code, empty if none
+      std::vector<BufferedSlave::FunctionHandler> handlers;
+      // replication of the slaves, socket listening for the standbys or
+      // connected to the primary
+      int replicationSock;
+      std::thread replicator;
+      std::atomic<bool> replicating;
+      std::atomic<bool> stopReplicator;
+      std::atomic<uint64_t> replicationSequence;
 
       PIMP_DECLARE_PUBLIC (Server)
   };
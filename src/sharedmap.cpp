@@ -0,0 +1,436 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#ifndef _WIN32
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+#endif
+#include "sharedmap_p.h"
+#include "config.h"
+
+namespace Modbus {
+
+  // ---------------------------------------------------------------------------
+  //
+  //                         SharedMap Class
+  //
+  // ---------------------------------------------------------------------------
+
+  // ---------------------------------------------------------------------------
+  SharedMap::SharedMap (SharedMap::Private &dd) : d_ptr (&dd) {}
+
+  // ---------------------------------------------------------------------------
+  SharedMap::SharedMap () : d_ptr (new Private (this)) {}
+
+  // ---------------------------------------------------------------------------
+  SharedMap::SharedMap (const std::string & name, bool writable) : SharedMap () {
+
+    if (! open (name, writable)) {
+
+      throw std::runtime_error ("Unable to open the shared memory " + name);
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  SharedMap::~SharedMap() = default;
+
+  // ---------------------------------------------------------------------------
+  bool SharedMap::open (const std::string & name, bool writable) {
+    PIMP_D (SharedMap);
+
+    close();
+    if (d->segment.open (name, writable)) {
+
+      d->writable = writable;
+      d->seqlock.setCounter (&d->segment.header()->sequence);
+      return true;
+    }
+    return false;
+  }
+
+  // ---------------------------------------------------------------------------
+  void SharedMap::close() {
+    PIMP_D (SharedMap);
+
+    d->seqlock.setCounter (nullptr);
+    d->segment.close();
+  }
+
+  // ---------------------------------------------------------------------------
+  bool SharedMap::isOpen() const {
+    PIMP_D (const SharedMap);
+
+    return d->segment.isOpen();
+  }
+
+  // ---------------------------------------------------------------------------
+  bool SharedMap::isWritable() const {
+    PIMP_D (const SharedMap);
+
+    return isOpen() && d->writable;
+  }
+
+  // ---------------------------------------------------------------------------
+  std::string SharedMap::name() const {
+    PIMP_D (const SharedMap);
+
+    return d->segment.name;
+  }
+
+  // ---------------------------------------------------------------------------
+  int SharedMap::startingAddress (Table t) const {
+    PIMP_D (const SharedMap);
+
+    if (isOpen() && t >= DiscreteInput && t <= HoldingRegister) {
+
+      return d->segment.header()->areas[t].start;
+    }
+    return 0;
+  }
+
+  // ---------------------------------------------------------------------------
+  int SharedMap::size (Table t) const {
+    PIMP_D (const SharedMap);
+
+    if (isOpen() && t >= DiscreteInput && t <= HoldingRegister) {
+
+      return d->segment.header()->areas[t].size;
+    }
+    return 0;
+  }
+
+  // ---------------------------------------------------------------------------
+  int SharedMap::readBits (Table t, int addr, bool * dest, int nb) const {
+    PIMP_D (const SharedMap);
+    const uint8_t * src = d->find (t, addr, nb, 1);
+
+    if (src) {
+
+      d->seqlock.read ([ = ] {
+        memcpy (dest, src, nb);
+      });
+      return nb;
+    }
+    return -1;
+  }
+
+  // ---------------------------------------------------------------------------
+  int SharedMap::readRegisters (Table t, int addr, uint16_t * dest, int nb) const {
+    PIMP_D (const SharedMap);
+    const uint8_t * src = d->find (t, addr, nb, sizeof (uint16_t));
+
+    if (src) {
+
+      d->seqlock.read ([ = ] {
+        memcpy (dest, src, nb * sizeof (uint16_t));
+      });
+      return nb;
+    }
+    return -1;
+  }
+
+  // ---------------------------------------------------------------------------
+  int SharedMap::writeBits (Table t, int addr, const bool * src, int nb) {
+    PIMP_D (SharedMap);
+    uint8_t * dest = d->find (t, addr, nb, 1);
+
+    if (dest) {
+
+      if (!d->writable) {
+
+        errno = EBADF;
+        return -1;
+      }
+      d->seqlock.lock();
+      memcpy (dest, src, nb);
+      d->seqlock.unlock();
+      return nb;
+    }
+    return -1;
+  }
+
+  // ---------------------------------------------------------------------------
+  int SharedMap::writeRegisters (Table t, int addr, const uint16_t * src, int nb) {
+    PIMP_D (SharedMap);
+    uint8_t * dest = d->find (t, addr, nb, sizeof (uint16_t));
+
+    if (dest) {
+
+      if (!d->writable) {
+
+        errno = EBADF;
+        return -1;
+      }
+      d->seqlock.lock();
+      memcpy (dest, src, nb * sizeof (uint16_t));
+      d->seqlock.unlock();
+      return nb;
+    }
+    return -1;
+  }
+
+  // ---------------------------------------------------------------------------
+  void SharedMap::beginUpdate() {
+    PIMP_D (SharedMap);
+
+    if (isWritable()) {
+
+      d->seqlock.lock();
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  void SharedMap::endUpdate() {
+    PIMP_D (SharedMap);
+
+    if (isWritable()) {
+
+      d->seqlock.unlock();
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  // static
+  bool SharedMap::remove (const std::string & name) {
+
+#ifndef _WIN32
+    return shm_unlink (SharedMapFormat::Segment::shmName (name).c_str()) == 0;
+#else
+    errno = ENOSYS;
+    return false;
+#endif
+  }
+
+  // ---------------------------------------------------------------------------
+  //
+  //                         SharedMap::Private Class
+  //
+  // ---------------------------------------------------------------------------
+
+  // ---------------------------------------------------------------------------
+  SharedMap::Private::Private (SharedMap * q) : q_ptr (q), writable (false) {}
+
+  // ---------------------------------------------------------------------------
+  SharedMap::Private::~Private() = default;
+
+  // ---------------------------------------------------------------------------
+  // size is the size of an element, 1 for the bits
+  uint8_t * SharedMap::Private::find (Table t, int addr, int & nb, size_t size) const {
+
+    if (segment.isOpen() && t >= DiscreteInput && t <= HoldingRegister &&
+        SharedMapFormat::elementSize (t) == size) {
+      const SharedMapFormat::Area & a = segment.header()->areas[t];
+
+      if (nb > 0 && addr >= a.start && addr < (a.start + a.size)) {
+
+        nb = std::min (nb, a.start + a.size - addr);
+        return segment.data (t) + (addr - a.start) * size;
+      }
+    }
+    errno = EINVAL;
+    return nullptr;
+  }
+
+  // ---------------------------------------------------------------------------
+  //
+  //                         SharedMapFormat Namespace
+  //
+  // ---------------------------------------------------------------------------
+  namespace SharedMapFormat {
+
+    // -------------------------------------------------------------------------
+    size_t layout (Header & h) {
+      size_t offset = (sizeof (Header) + 7) & ~7;
+
+      for (int t = 0; t < Tables; t++) {
+        Area & a = h.areas[t];
+
+        if (a.size < 0) {
+          a.size = 0;
+        }
+        a.offset = offset;
+        offset += (a.size * elementSize (t) + 7) & ~7;
+      }
+      h.length = offset;
+      return offset;
+    }
+
+    // -------------------------------------------------------------------------
+    Segment::Segment() : base (nullptr), length (0), fd (-1), reused (false) {}
+
+    // -------------------------------------------------------------------------
+    Segment::~Segment() {
+
+      close();
+    }
+
+    // -------------------------------------------------------------------------
+    // static
+    std::string Segment::shmName (const std::string & name) {
+
+      return (!name.empty() && name[0] == '/') ? name : "/" + name;
+    }
+
+    // -------------------------------------------------------------------------
+    bool Segment::create (const std::string & n, Header & h) {
+
+#ifndef _WIN32
+      std::string shm = shmName (n);
+      size_t len = layout (h);
+
+      close();
+      if (open (n, true)) {
+        const Header * e = header();
+        bool same = (length == len);
+
+        for (int t = 0; same && t < Tables; t++) {
+
+          same = (e->areas[t].start == h.areas[t].start &&
+                  e->areas[t].size == h.areas[t].size);
+        }
+        if (same) {
+
+          reused = true;
+          return true;
+        }
+        // the processes which have mapped the old segment keep it
+        close();
+        shm_unlink (shm.c_str());
+      }
+      else if (errno == EPROTO) {
+
+        shm_unlink (shm.c_str());
+      }
+
+      fd = shm_open (shm.c_str(), O_RDWR | O_CREAT | O_EXCL, 0660);
+      if (fd >= 0) {
+
+        if (ftruncate (fd, len) == 0) {
+          void * m = mmap (nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+          if (m != MAP_FAILED) {
+            Header * p = static_cast<Header *> (m);
+
+            base = static_cast<uint8_t *> (m);
+            length = len;
+            name = shm;
+            reused = false;
+
+            // the data are zero-filled by ftruncate()
+            p->version = Version;
+            p->flags = 0;
+            p->length = len;
+            new (&p->sequence) std::atomic<uint32_t> (0);
+            memcpy (p->areas, h.areas, sizeof (h.areas));
+            std::atomic_thread_fence (std::memory_order_release);
+            memcpy (p->magic, Magic, sizeof (Magic));
+            return true;
+          }
+        }
+        int saved_errno = errno;
+        ::close (fd);
+        fd = -1;
+        shm_unlink (shm.c_str());
+        errno = saved_errno;
+      }
+#else
+      errno = ENOSYS;
+#endif
+      return false;
+    }
+
+    // -------------------------------------------------------------------------
+    bool Segment::open (const std::string & n, bool writable) {
+
+#ifndef _WIN32
+      std::string shm = shmName (n);
+
+      close();
+      fd = shm_open (shm.c_str(), writable ? O_RDWR : O_RDONLY, 0);
+      if (fd < 0) {
+
+        return false;
+      }
+
+      struct stat st;
+      if (fstat (fd, &st) == 0) {
+        size_t len = st.st_size;
+
+        if (len >= sizeof (Header)) {
+          void * m = mmap (nullptr, len, writable ? (PROT_READ | PROT_WRITE) : PROT_READ,
+                           MAP_SHARED, fd, 0);
+          if (m != MAP_FAILED) {
+            const Header * p = static_cast<const Header *> (m);
+
+            if (memcmp (p->magic, Magic, sizeof (Magic)) == 0 &&
+                p->version == Version && p->length <= len) {
+
+              std::atomic_thread_fence (std::memory_order_acquire);
+              base = static_cast<uint8_t *> (m);
+              length = len;
+              name = shm;
+              reused = true;
+              return true;
+            }
+            munmap (m, len);
+            errno = EPROTO;
+          }
+        }
+        else {
+
+          errno = EPROTO;
+        }
+      }
+
+      int saved_errno = errno;
+      ::close (fd);
+      fd = -1;
+      errno = saved_errno;
+#else
+      errno = ENOSYS;
+#endif
+      return false;
+    }
+
+    // -------------------------------------------------------------------------
+    void Segment::close() {
+
+#ifndef _WIN32
+      if (base) {
+
+        munmap (base, length);
+        base = nullptr;
+        length = 0;
+      }
+      if (fd >= 0) {
+
+        ::close (fd);
+        fd = -1;
+      }
+#endif
+      name.clear();
+    }
+  }
+}
+
+/* ========================================================================== */
@@ -0,0 +1,112 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <atomic>
+#include <modbuspp/sharedmap.h>
+#include "seqlock_p.h"
+
+namespace Modbus {
+
+  /*
+   * Segment layout (host byte order):
+   * | Header | table data [5] |
+   *
+   * The data of each table start on an 8-byte boundary, the bits are stored
+   * one per byte and the registers on 16 bits, as in modbus_mapping_t.
+   * The sequence is the counter of the seqlock shared by the processes.
+   * The magic number is written last, once the segment is initialized.
+   */
+  namespace SharedMapFormat {
+
+    const char Magic[4] = { 'M', 'B', 'S', 'M' };
+    const uint16_t Version = 1;
+    const int Tables = HoldingRegister + 1;
+
+    struct Area {
+      int32_t start; // PDU address
+      int32_t size;
+      uint32_t offset;
+      uint32_t reserved;
+    };
+
+    struct Header {
+      char magic[4];
+      uint16_t version;
+      uint16_t flags;
+      uint32_t length;
+      std::atomic<uint32_t> sequence;
+      uint8_t reserved[16];
+      Area areas[Tables];
+    };
+
+    inline size_t elementSize (int t) {
+      return (t == Coil || t == DiscreteInput) ? 1 : 2;
+    }
+
+    // computes the offsets of the areas of h, returns the length of the segment
+    size_t layout (Header & h);
+
+    // the mapped segment
+    class Segment {
+      public:
+        Segment();
+        ~Segment();
+        // creates the segment with the areas of h, or maps the existing one
+        // if its areas are the same (reused is set)
+        bool create (const std::string & name, Header & h);
+        bool open (const std::string & name, bool writable);
+        void close();
+        bool isOpen() const {
+          return base != nullptr;
+        }
+
+        Header * header() const {
+          return reinterpret_cast<Header *> (base);
+        }
+        uint8_t * data (int t) const {
+          return base + header()->areas[t].offset;
+        }
+
+        static std::string shmName (const std::string & name);
+
+        std::string name;
+        uint8_t * base;
+        size_t length;
+        int fd;
+        bool reused;
+    };
+  }
+
+  class SharedMap::Private {
+
+    public:
+      Private (SharedMap * q);
+      virtual ~Private();
+      // returns the area of t containing addr, nb is limited to its end
+      uint8_t * find (Table t, int addr, int & nb, size_t size) const;
+
+      SharedMap * const q_ptr;
+      SharedMapFormat::Segment segment;
+      SeqLock seqlock;
+      bool writable;
+
+      PIMP_DECLARE_PUBLIC (SharedMap)
+  };
+}
+
+/* ========================================================================== */
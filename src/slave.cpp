@@ -14,7 +14,12 @@
  * You should have received a copy of the GNU Lesser General Public License
  * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
  */
+#include <deque>
+#include <modbuspp/bitarray.h>
+#include <modbuspp/request.h>
 #include "slave_p.h"
+#include "device_p.h"
+#include "filerecord_p.h"
 #include "config.h"
 
 namespace Modbus {
@@ -83,6 +88,7 @@ namespace Modbus {
 
     if (isValid()) {
       PIMP_D (Slave);
+      std::lock_guard<std::recursive_mutex> lock (d->transaction());
 
       if (modbus_set_slave (d->ctx(), d->id) == 0) {
 
@@ -99,6 +105,7 @@ namespace Modbus {
 
     if (isValid()) {
       PIMP_D (Slave);
+      std::lock_guard<std::recursive_mutex> lock (d->transaction());
 
       if (modbus_set_slave (d->ctx(), d->id) == 0) {
 
@@ -116,6 +123,7 @@ namespace Modbus {
     if (isValid()) {
 
       PIMP_D (Slave);
+      std::lock_guard<std::recursive_mutex> lock (d->transaction());
 
       if (modbus_set_slave (d->ctx(), d->id) == 0) {
 
@@ -132,6 +140,7 @@ namespace Modbus {
 
     if (isValid()) {
       PIMP_D (Slave);
+      std::lock_guard<std::recursive_mutex> lock (d->transaction());
 
       if (modbus_set_slave (d->ctx(), d->id) == 0) {
 
@@ -148,6 +157,7 @@ namespace Modbus {
 
     if (isValid()) {
       PIMP_D (Slave);
+      std::lock_guard<std::recursive_mutex> lock (d->transaction());
 
       if (modbus_set_slave (d->ctx(), d->id) == 0) {
 
@@ -164,6 +174,7 @@ namespace Modbus {
 
     if (isValid()) {
       PIMP_D (Slave);
+      std::lock_guard<std::recursive_mutex> lock (d->transaction());
 
       if (modbus_set_slave (d->ctx(), d->id) == 0) {
 
@@ -180,6 +191,7 @@ namespace Modbus {
 
     if (isValid()) {
       PIMP_D (Slave);
+      std::lock_guard<std::recursive_mutex> lock (d->transaction());
 
       if (modbus_set_slave (d->ctx(), d->id) == 0) {
 
@@ -195,6 +207,7 @@ namespace Modbus {
 
     if (isValid()) {
       PIMP_D (Slave);
+      std::lock_guard<std::recursive_mutex> lock (d->transaction());
 
       if (modbus_set_slave (d->ctx(), d->id) == 0) {
 
@@ -212,6 +225,7 @@ namespace Modbus {
                                  int raddr, uint16_t * dest, int rnb) {
     if (isValid()) {
       PIMP_D (Slave);
+      std::lock_guard<std::recursive_mutex> lock (d->transaction());
 
       if (modbus_set_slave (d->ctx(), d->id) == 0) {
 
@@ -224,12 +238,53 @@ namespace Modbus {
     throw std::runtime_error ("Slave id or backend not set !");
   }
 
+  // ---------------------------------------------------------------------------
+  int Slave::maskWriteRegister (int addr, uint16_t andMask, uint16_t orMask) {
+
+    if (isValid()) {
+      PIMP_D (Slave);
+      std::lock_guard<std::recursive_mutex> lock (d->transaction());
+
+      if (modbus_set_slave (d->ctx(), d->id) == 0) {
+
+        return modbus_mask_write_register (d->ctx(),
+                                           pduAddress (addr), andMask, orMask);
+      }
+      return -1; // errno set by modbus_set_slave
+    }
+    throw std::runtime_error ("Slave id or backend not set !");
+  }
+
+  // ---------------------------------------------------------------------------
+  int Slave::readFileRecord (int file, int record, uint16_t * dest, int nb) {
+
+    if (isValid()) {
+      PIMP_D (Slave);
+
+      return d->fileRecords (ReadFileRecord, file, record, dest, nb);
+    }
+    throw std::runtime_error ("Slave id or backend not set !");
+  }
+
+  // ---------------------------------------------------------------------------
+  int Slave::writeFileRecord (int file, int record, const uint16_t * src, int nb) {
+
+    if (isValid()) {
+      PIMP_D (Slave);
+
+      return d->fileRecords (WriteFileRecord, file, record,
+                             const_cast<uint16_t *> (src), nb);
+    }
+    throw std::runtime_error ("Slave id or backend not set !");
+  }
+
   // ---------------------------------------------------------------------------
   int Slave::reportSlaveId (uint16_t max_dest, uint8_t *dest) {
 
     if (isValid()) {
 
       PIMP_D (Slave);
+      std::lock_guard<std::recursive_mutex> lock (d->transaction());
 
       if (modbus_set_slave (d->ctx(), d->id) == 0) {
 
@@ -272,7 +327,7 @@ namespace Modbus {
   // static
   void Slave::setBoolArray (bool * dest, const uint8_t * src, size_t n) {
 
-    modbus_set_bits_from_bytes ( (uint8_t *) dest, 0, n, src);
+    unpackBits (dest, src, 0, n);
   }
 
   // ---------------------------------------------------------------------------
@@ -296,6 +351,161 @@ namespace Modbus {
   // ---------------------------------------------------------------------------
   Slave::Private::~Private() = default;
 
+  // ---------------------------------------------------------------------------
+  std::recursive_mutex & Slave::Private::transaction() {
+
+    return dev->d_func()->transaction;
+  }
+
+  // ---------------------------------------------------------------------------
+  // transfers the records [record, record + nb[ of file with requests of the
+  // maximum size, the requests are pipelined on TCP, the responses being
+  // matched by their transaction identifier
+  int Slave::Private::fileRecords (Function func, int file, int record,
+                                   uint16_t * values, int nb) {
+    using namespace FileRecordFormat;
+
+    struct Pending {
+      uint16_t tid;
+      int offset;
+      int count;
+    };
+
+    if (file < 1 || file > 0xFFFF || record < 0 || nb < 0 || (record + nb) > MaxRecords) {
+
+      errno = EINVAL;
+      return -1;
+    }
+
+    // the responses are received by this function
+    std::lock_guard<std::recursive_mutex> lock (transaction());
+    Net net = dev->net();
+    int fd = modbus_get_socket (ctx());
+    int max = (func == ReadFileRecord) ? MaxReadRegisters : MaxWriteRegisters;
+    size_t window = (net == Tcp) ? Pipeline : 1;
+    double timeout = dev->responseTimeout();
+    std::deque<Pending> pending;
+    Request req (*dev, func);
+    uint8_t rsp[MaxAduLength];
+    int sent = 0;
+    int done = 0;
+
+    while (done < nb) {
+
+      // sends the next requests
+      while (sent < nb && pending.size() < window) {
+        Pending p = { 0, sent, std::min (max, nb - sent) };
+
+        req.setSlaveId (id);
+        req.setByte (2, RefType);
+        req.setWord (3, file);
+        req.setWord (5, record + p.offset);
+        req.setWord (7, p.count);
+        if (func == WriteFileRecord) {
+
+          req.setByte (1, 7 + p.count * 2);
+          for (int i = 0; i < p.count; i++) {
+
+            req.setWord (9 + i * 2, values[p.offset + i]);
+          }
+          req.setSize (9 + p.count * 2);
+        }
+        else {
+
+          req.setByte (1, 7);
+          req.setSize (9);
+        }
+
+        if (dev->sendRawMessage (req, true) < 0) {
+
+          break;
+        }
+        if (net == Tcp) {
+
+          p.tid = req.transactionIdentifier();
+        }
+        pending.push_back (p);
+        sent += p.count;
+      }
+      if (pending.empty()) {
+
+        return -1; // errno set by sendRawMessage
+      }
+
+      int len = receive (fd, net, rsp, timeout);
+      if (len < 0) {
+
+        break;
+      }
+
+      // the responses to the previous calls are ignored
+      int h = (net == Tcp) ? 7 : 1;
+      auto it = pending.begin();
+      if (net == Tcp) {
+        uint16_t tid = (rsp[0] << 8) | rsp[1];
+
+        while (it != pending.end() && it->tid != tid) {
+          ++it;
+        }
+        if (it == pending.end()) {
+          continue;
+        }
+      }
+
+      if (net != Tcp && rsp[0] != id) {
+
+        errno = EMBBADSLAVE;
+        break;
+      }
+      if (rsp[h] == (func | ExceptionFlag)) {
+
+        errno = MODBUS_ENOBASE + rsp[h + 1];
+        break;
+      }
+
+      const uint8_t * pdu = rsp + h;
+      int count = it->count;
+      if (pdu[0] != func) {
+
+        errno = EMBBADDATA;
+        break;
+      }
+
+      if (func == ReadFileRecord) {
+
+        if (len < (h + 4 + count * 2) || pdu[1] != (2 + count * 2) ||
+            pdu[2] != (1 + count * 2) || pdu[3] != RefType) {
+
+          errno = EMBBADDATA;
+          break;
+        }
+        for (int i = 0; i < count; i++) {
+
+          values[it->offset + i] = (pdu[4 + i * 2] << 8) | pdu[5 + i * 2];
+        }
+      }
+      else if (len < (h + 9) || pdu[1] != (7 + count * 2) ||
+               ( (pdu[7] << 8) | pdu[8]) != count) {
+
+        errno = EMBBADDATA;
+        break;
+      }
+
+      done += count;
+      pending.erase (it);
+    }
+
+    if (done < nb) {
+      int saved_errno = errno;
+
+      // the responses of the pending requests are discarded
+      modbus_flush (ctx());
+      errno = saved_errno;
+      return -1;
+    }
+    return nb;
+  }
+
   // ---------------------------------------------------------------------------
   //
   //                         Modbus::Json Namespace
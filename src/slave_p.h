@@ -16,6 +16,7 @@
  */
 #pragma once
 
+#include <mutex>
 #include <modbuspp/slave.h>
 #include <modbuspp/device.h>
 #include <modbuspp/netlayer.h>
@@ -30,6 +31,10 @@ namespace Modbus {
       Private (Slave * q, int s, Device * d);
       virtual ~Private();
 
+      int fileRecords (Function func, int file, int record, uint16_t * values, int nb);
+      // lock of the exchanges on the backend of the device
+      std::recursive_mutex & transaction();
+
       inline modbus_t * ctx() {
         return dev->backend().context();
       }
@@ -0,0 +1,251 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <map>
+#include <tuple>
+#include <cerrno>
+#include <cstring>
+#include "snapshot_p.h"
+#include "recorder_p.h"
+#include "persistentfile_p.h"
+#include "config.h"
+
+namespace Modbus {
+
+  // ---------------------------------------------------------------------------
+  //
+  //                         SnapshotFormat Namespace
+  //
+  // ---------------------------------------------------------------------------
+  namespace SnapshotFormat {
+
+    namespace {
+
+      void put16 (uint8_t * p, uint16_t v) {
+        p[0] = v & 0xFF;
+        p[1] = v >> 8;
+      }
+
+      void put32 (uint8_t * p, uint32_t v) {
+        put16 (p, v & 0xFFFF);
+        put16 (p + 2, v >> 16);
+      }
+
+      uint16_t get16 (const uint8_t * p) {
+        return p[0] | (p[1] << 8);
+      }
+
+      uint32_t get32 (const uint8_t * p) {
+        return get16 (p) | (static_cast<uint32_t> (get16 (p + 2)) << 16);
+      }
+
+      size_t valuesLength (int t, int count) {
+        return isBit (t) ? (count + 7) / 8 : count * 2;
+      }
+    }
+
+    // -------------------------------------------------------------------------
+    Writer::Writer (uint16_t flags, uint32_t base) : buf (HeaderSize) {
+
+      memcpy (buf.data(), Magic, sizeof (Magic));
+      put16 (&buf[4], Version);
+      put16 (&buf[6], flags);
+      put32 (&buf[12], base);
+    }
+
+    // -------------------------------------------------------------------------
+    // appends the header of a record, returns its values of len bytes
+    uint8_t * Writer::record (int slave, Table t, int start, int count, size_t len) {
+      uint8_t h[2 + 2 * 10];
+      size_t n = 0;
+
+      h[n++] = slave;
+      h[n++] = t;
+      n += RecorderFormat::putVarint (&h[n], start);
+      n += RecorderFormat::putVarint (&h[n], count);
+      buf.insert (buf.end(), h, h + n);
+      buf.resize (buf.size() + len, 0);
+      return &buf[buf.size() - len];
+    }
+
+    // -------------------------------------------------------------------------
+    void Writer::addBits (int slave, Table t, int start, const uint8_t * bits, int count) {
+      uint8_t * p = record (slave, t, start, count, valuesLength (t, count));
+
+      for (int i = 0; i < count; i++) {
+
+        if (bits[i]) {
+          p[i / 8] |= 1 << (i % 8);
+        }
+      }
+    }
+
+    // -------------------------------------------------------------------------
+    void Writer::addRegisters (int slave, Table t, int start, const uint16_t * regs, int count) {
+      uint8_t * p = record (slave, t, start, count, valuesLength (t, count));
+
+      for (int i = 0; i < count; i++) {
+
+        put16 (p + 2 * i, regs[i]);
+      }
+    }
+
+    // -------------------------------------------------------------------------
+    void Writer::add (const Record & r, int first, int count) {
+      uint8_t * p = record (r.slave, r.table, r.start + first, count,
+                            valuesLength (r.table, count));
+
+      if (isBit (r.table)) {
+
+        for (int i = 0; i < count; i++) {
+
+          if (r.bit (first + i)) {
+            p[i / 8] |= 1 << (i % 8);
+          }
+        }
+      }
+      else {
+
+        memcpy (p, r.values + 2 * first, 2 * count);
+      }
+    }
+
+    // -------------------------------------------------------------------------
+    std::vector<uint8_t> Writer::finish() {
+      std::vector<uint8_t> s;
+      uint8_t crc[CrcSize];
+
+      put32 (&buf[8], buf.size() + CrcSize);
+      put32 (crc, PersistentFormat::crc32 (buf.data(), buf.size()));
+      buf.insert (buf.end(), crc, crc + CrcSize);
+      s.swap (buf);
+      return s;
+    }
+
+    // -------------------------------------------------------------------------
+    bool parse (const std::vector<uint8_t> & s, Header & h, std::vector<Record> & records) {
+      const uint8_t * p = s.data();
+      const uint8_t * end = p + s.size() - CrcSize;
+
+      records.clear();
+      if (s.size() < (HeaderSize + CrcSize) ||
+          memcmp (p, Magic, sizeof (Magic)) != 0) {
+
+        errno = EPROTO;
+        return false;
+      }
+
+      h.version = get16 (p + 4);
+      h.flags = get16 (p + 6);
+      h.length = get32 (p + 8);
+      h.base = get32 (p + 12);
+      h.crc = get32 (end);
+      if (h.version != Version || h.length != s.size() ||
+          h.crc != PersistentFormat::crc32 (p, s.size() - CrcSize)) {
+
+        errno = EPROTO;
+        return false;
+      }
+
+      p += HeaderSize;
+      while (p < end) {
+        Record r;
+        uint64_t start, count;
+
+        if ( (end - p) < 4) {
+          break;
+        }
+        r.slave = *p++;
+        r.table = static_cast<Table> (*p++);
+        p += RecorderFormat::getVarint (p, end, start);
+        p += RecorderFormat::getVarint (p, end, count);
+
+        if (! (isBit (r.table) || r.table == InputRegister || r.table == HoldingRegister) ||
+            (start + count) > 0x10000 || p > end ||
+            valuesLength (r.table, count) > static_cast<size_t> (end - p)) {
+
+          break;
+        }
+        r.start = start;
+        r.count = count;
+        r.values = p;
+        p += valuesLength (r.table, count);
+        records.push_back (r);
+      }
+
+      if (p != end) {
+
+        records.clear();
+        errno = EPROTO;
+        return false;
+      }
+      return true;
+    }
+
+    // -------------------------------------------------------------------------
+    std::vector<uint8_t> delta (const Header & ph, const std::vector<Record> & previous,
+                                const Header & ch, const std::vector<Record> & current) {
+      std::map<std::tuple<int, int, int>, const Record *> blocks;
+      Writer w (ch.flags | Delta, ph.crc);
+
+      for (const auto & r : previous) {
+
+        blocks[std::make_tuple (r.slave, r.table, r.start)] = &r;
+      }
+
+      for (const auto & r : current) {
+        auto it = blocks.find (std::make_tuple (r.slave, r.table, r.start));
+
+        if (it == blocks.end() || it->second->count != r.count) {
+
+          // new block
+          w.add (r, 0, r.count);
+          continue;
+        }
+
+        // ranges of changed values, the unchanged values between two ranges
+        // are sent if they are shorter than the header of a record
+        const Record & p = *it->second;
+        int gap = isBit (r.table) ? 64 : 4;
+        int first = -1, last = -1;
+
+        for (int i = 0; i < r.count; i++) {
+          bool changed = isBit (r.table) ? (r.bit (i) != p.bit (i)) : (r.reg (i) != p.reg (i));
+
+          if (changed) {
+
+            if (first >= 0 && (i - last) > gap) {
+
+              w.add (r, first, last - first + 1);
+              first = -1;
+            }
+            if (first < 0) {
+              first = i;
+            }
+            last = i;
+          }
+        }
+        if (first >= 0) {
+
+          w.add (r, first, last - first + 1);
+        }
+      }
+      return w.finish();
+    }
+  }
+}
+
+/* ========================================================================== */
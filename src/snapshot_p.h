@@ -0,0 +1,103 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <vector>
+#include <modbuspp/global.h>
+
+namespace Modbus {
+
+  /*
+   * Snapshot layout (little endian, independent of the host):
+   * | magic (4) | version (u16) | flags (u16) | length (u32) | base (u32) |
+   * | Record * | crc (u32) |
+   * Record:
+   * | slave (u8) | table (u8) | start (varint) | count (varint) | values |
+   *
+   * The length is the length of the snapshot, crc included, the crc is the
+   * CRC-32 of the previous bytes. A full snapshot has a record per block,
+   * a delta has a record per range of values changed since its base, whose
+   * crc is base. The start is a PDU address, the bits are packed 8 per byte
+   * from the LSB, the registers are on 16 bits.
+   */
+  namespace SnapshotFormat {
+
+    const char Magic[4] = { 'M', 'B', 'S', 'N' };
+    const uint16_t Version = 1;
+    const size_t HeaderSize = 16;
+    const size_t CrcSize = 4;
+
+    enum Flags {
+      Delta = 0x0001
+    };
+
+    struct Header {
+      uint16_t version;
+      uint16_t flags;
+      uint32_t length;
+      uint32_t base;
+      uint32_t crc;
+    };
+
+    // record of a parsed snapshot, values points into the snapshot
+    struct Record {
+      int slave;
+      Table table;
+      int start;
+      int count;
+      const uint8_t * values;
+
+      bool bit (int i) const {
+        return (values[i / 8] >> (i % 8)) & 1;
+      }
+      uint16_t reg (int i) const {
+        return values[2 * i] | (values[2 * i + 1] << 8);
+      }
+    };
+
+    inline bool isBit (int t) {
+      return t == Coil || t == DiscreteInput;
+    }
+
+    class Writer {
+      public:
+        Writer (uint16_t flags = 0, uint32_t base = 0);
+        // bits are one per byte
+        void addBits (int slave, Table t, int start, const uint8_t * bits, int count);
+        void addRegisters (int slave, Table t, int start, const uint16_t * regs, int count);
+        // adds the values [first, first + count[ of a parsed record
+        void add (const Record & r, int first, int count);
+        // ends the snapshot and returns it, the writer is empty
+        std::vector<uint8_t> finish();
+
+      private:
+        uint8_t * record (int slave, Table t, int start, int count, size_t len);
+        std::vector<uint8_t> buf;
+    };
+
+    // checks the snapshot and returns its records, false and errno set to
+    // EPROTO if it is not valid
+    bool parse (const std::vector<uint8_t> & snapshot, Header & h,
+                std::vector<Record> & records);
+
+    // returns the delta of the full snapshot current from previous
+    std::vector<uint8_t> delta (const Header & ph, const std::vector<Record> & previous,
+                                const Header & ch, const std::vector<Record> & current);
+  }
+}
+
+/* ========================================================================== */
@@ -0,0 +1,313 @@
+/* Copyright © 2018-2026 Pascal JEAN, All rights reserved.
+ * This file is part of the libmodbuspp Library.
+ *
+ * The libmodbuspp Library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The libmodbuspp Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with the libmodbuspp Library; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <modbuspp/global.h>
+#include <modbuspp/swap.h>
+#include "config.h"
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+# if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#   include <immintrin.h>
+#   define MODBUSPP_SWAP_AVX2 1
+# endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+#endif
+
+namespace Modbus {
+
+  namespace {
+
+    /*
+     * The value of registers read from a Modbus network is in the host byte
+     * order. Converting them to the memory representation of values needs
+     * at most two operations that are involutions and commute:
+     * - swapping the bytes of each register (B),
+     * - reversing the order of the registers of each value (W).
+     *
+     *                      little endian host    big endian host
+     * EndianBigBig               W                    -
+     * EndianBigLittle            -                    W
+     * EndianLittleBig            B + W                B
+     * EndianLittleLittle         B                    B + W
+     */
+    enum {
+      SwapBytes = 0x01,
+      SwapWords = 0x02
+    };
+
+    inline int operations (std::size_t size, Endian e) {
+      int op;
+
+      switch (e) {
+        case EndianBigLittle:
+          op = 0;
+          break;
+        case EndianLittleBig:
+          op = SwapBytes | SwapWords;
+          break;
+        case EndianLittleLittle:
+          op = SwapBytes;
+          break;
+        default: // EndianBigBig
+          op = SwapWords;
+          break;
+      }
+#if __BYTE_ORDER != __LITTLE_ENDIAN
+      op ^= SwapWords;
+#endif
+      if (size <= 2) {
+
+        op &= ~SwapWords;
+      }
+      return op;
+    }
+
+    // -------------------------------------------------------------------------
+    // portable version, n is the number of registers, w of registers by value
+    void swapScalar (uint16_t * p, std::size_t n, std::size_t w, int op) {
+
+      if (op & SwapBytes) {
+
+        for (std::size_t i = 0; i < n; i++) {
+
+          p[i] = static_cast<uint16_t> ( (p[i] << 8) | (p[i] >> 8));
+        }
+      }
+
+      if (op & SwapWords) {
+
+        for (std::size_t i = 0; i < n; i += w) {
+
+          for (std::size_t j = 0; j < w / 2; j++) {
+
+            std::swap (p[i + j], p[i + w - 1 - j]);
+          }
+        }
+      }
+    }
+
+#if defined(__SSE2__)
+    // -------------------------------------------------------------------------
+    // 8 registers by iteration, w is 2, 4 or 8
+    std::size_t swapSse2 (uint16_t * p, std::size_t n, std::size_t w, int op) {
+      std::size_t i = 0;
+
+      for (; (i + 8) <= n; i += 8) {
+        __m128i x = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (p + i));
+
+        if (op & SwapBytes) {
+
+          x = _mm_or_si128 (_mm_slli_epi16 (x, 8), _mm_srli_epi16 (x, 8));
+        }
+        if (op & SwapWords) {
+
+          if (w == 2) {
+
+            x = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (x, 0xB1), 0xB1);
+          }
+          else {
+
+            x = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (x, 0x1B), 0x1B);
+            if (w == 8) {
+
+              x = _mm_shuffle_epi32 (x, 0x4E);
+            }
+          }
+        }
+        _mm_storeu_si128 (reinterpret_cast<__m128i *> (p + i), x);
+      }
+      return i;
+    }
+
+# if defined(MODBUSPP_SWAP_AVX2)
+    // -------------------------------------------------------------------------
+    // 16 registers by iteration, w is 2, 4 or 8
+    __attribute__ ( (target ("avx2")))
+    std::size_t swapAvx2 (uint16_t * p, std::size_t n, std::size_t w, int op) {
+      std::size_t i = 0;
+
+      for (; (i + 16) <= n; i += 16) {
+        __m256i x = _mm256_loadu_si256 (reinterpret_cast<const __m256i *> (p + i));
+
+        if (op & SwapBytes) {
+
+          x = _mm256_or_si256 (_mm256_slli_epi16 (x, 8), _mm256_srli_epi16 (x, 8));
+        }
+        if (op & SwapWords) {
+
+          if (w == 2) {
+
+            x = _mm256_shufflehi_epi16 (_mm256_shufflelo_epi16 (x, 0xB1), 0xB1);
+          }
+          else {
+
+            x = _mm256_shufflehi_epi16 (_mm256_shufflelo_epi16 (x, 0x1B), 0x1B);
+            if (w == 8) {
+
+              x = _mm256_shuffle_epi32 (x, 0x4E);
+            }
+          }
+        }
+        _mm256_storeu_si256 (reinterpret_cast<__m256i *> (p + i), x);
+      }
+      return i;
+    }
+
+    // -------------------------------------------------------------------------
+    inline bool hasAvx2() {
+      static const bool avx2 = __builtin_cpu_supports ("avx2");
+
+      return avx2;
+    }
+# endif
+
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    // -------------------------------------------------------------------------
+    // 8 registers by iteration, w is 2, 4 or 8
+    std::size_t swapNeon (uint16_t * p, std::size_t n, std::size_t w, int op) {
+      std::size_t i = 0;
+
+      for (; (i + 8) <= n; i += 8) {
+        uint16x8_t x = vld1q_u16 (p + i);
+
+        if (op & SwapBytes) {
+
+          x = vreinterpretq_u16_u8 (vrev16q_u8 (vreinterpretq_u8_u16 (x)));
+        }
+        if (op & SwapWords) {
+
+          if (w == 2) {
+
+            x = vrev32q_u16 (x);
+          }
+          else {
+
+            x = vrev64q_u16 (x);
+            if (w == 8) {
+
+              x = vcombine_u16 (vget_high_u16 (x), vget_low_u16 (x));
+            }
+          }
+        }
+        vst1q_u16 (p + i, x);
+      }
+      return i;
+    }
+#endif
+
+    // -------------------------------------------------------------------------
+    // n is the number of registers, w of registers by value
+    void swapArray (uint16_t * regs, std::size_t n, std::size_t w, int op) {
+      std::size_t i = 0;
+
+      if (w <= 8 && (8 % w) == 0) {
+
+#if defined(__SSE2__)
+# if defined(MODBUSPP_SWAP_AVX2)
+        if (hasAvx2()) {
+
+          i = swapAvx2 (regs, n, w, op);
+        }
+# endif
+        i += swapSse2 (regs + i, n - i, w, op);
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        i = swapNeon (regs, n, w, op);
+#endif
+      }
+      swapScalar (regs + i, n - i, w, op);
+    }
+
+    // -------------------------------------------------------------------------
+    // same as swapArray() for an array which may not be aligned on a
+    // register, e.g. in the PDU of a message, the registers are converted
+    // by chunks of whole values in an aligned buffer
+    void swapBuffer (void * dest, std::size_t n, std::size_t w, int op) {
+
+      if ( (reinterpret_cast<std::uintptr_t> (dest) % alignof (uint16_t)) == 0) {
+
+        swapArray (static_cast<uint16_t *> (dest), n, w, op);
+        return;
+      }
+
+      uint16_t buf[128];
+      uint8_t * p = static_cast<uint8_t *> (dest);
+      const std::size_t chunk = (128 / w) * w;
+
+      while (n > 0) {
+        std::size_t k = std::min (n, chunk);
+
+        std::memcpy (buf, p, k * sizeof (uint16_t));
+        swapArray (buf, k, w, op);
+        std::memcpy (p, buf, k * sizeof (uint16_t));
+        p += k * sizeof (uint16_t);
+        n -= k;
+      }
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  void swapRegisters (uint16_t * regs, std::size_t nmemb, std::size_t size, Endian e) {
+    int op = operations (size, e);
+
+    if (op && regs && nmemb > 0) {
+
+      swapArray (regs, nmemb * size / 2, size / 2, op);
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  void swapRegisters (void * dest, const void * src, std::size_t nmemb,
+                      std::size_t size, Endian e) {
+
+    if (dest != src) {
+
+      std::memmove (dest, src, nmemb * size);
+    }
+    int op = operations (size, e);
+
+    if (op && dest && nmemb > 0) {
+
+      swapBuffer (dest, nmemb * size / 2, size / 2, op);
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  void swapNetworkRegisters (void * dest, const void * src, std::size_t nmemb,
+                             std::size_t size, Endian e) {
+    // registers in the network order need a swap of bytes on little endian
+    // hosts, combined with the conversion of the values
+    int op = operations (size, e);
+
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+    op ^= SwapBytes;
+#endif
+    if (dest != src) {
+
+      std::memmove (dest, src, nmemb * size);
+    }
+    if (op && dest && nmemb > 0) {
+
+      swapBuffer (dest, nmemb * size / 2, size / 2, op);
+    }
+  }
+}
+
+/* ========================================================================== */
@@ -0,0 +1,138 @@
+// libmodbuspp Unit Test of the traffic capture
+// Use UnitTest++ framework -> https://github.com/unittest-cpp/unittest-cpp/wiki
+// This test code is in the public domain.
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <modbuspp.h>
+#include <UnitTest++/UnitTest++.h>
+
+using namespace std;
+using namespace Modbus;
+
+const string PcapFile = "/tmp/unit-test-capture.pcap";
+const string PcapNgFile = "/tmp/unit-test-capture.pcapng";
+
+vector<uint8_t> load (const string & path) {
+  ifstream f (path, ios::binary);
+
+  return vector<uint8_t> ( (istreambuf_iterator<char> (f)), istreambuf_iterator<char>());
+}
+
+uint32_t get32 (const vector<uint8_t> & buf, size_t i) {
+  uint32_t v;
+
+  memcpy (&v, &buf[i], sizeof (v));
+  return v;
+}
+
+TEST (CapturePcapTcp) {
+  // Read Holding Registers, unit 1, 10 registers from 0
+  const uint8_t req[] = { 0x00, 0x05, 0x00, 0x00, 0x00, 0x06, 0x01, 0x03, 0x00, 0x00, 0x00, 0x0A };
+  const uint8_t exc[] = { 0x00, 0x05, 0x00, 0x00, 0x00, 0x03, 0x01, 0x83, 0x02 };
+  Capture cap (PcapFile, Tcp);
+
+  CHECK (cap.isOpen());
+  CHECK (cap.record (req, sizeof (req), Capture::Received, false, 1500000000123456789ULL));
+  CHECK (cap.record (exc, sizeof (exc), Capture::Sent, true, 1500000000223456789ULL));
+  cap.close();
+  CHECK (!cap.isOpen());
+  CHECK_EQUAL (2u, cap.captured());
+  CHECK_EQUAL (0u, cap.dropped());
+
+  vector<uint8_t> f = load (PcapFile);
+  CHECK_EQUAL (24 + 2 * 16 + 2 * 40 + sizeof (req) + sizeof (exc), f.size());
+  CHECK_EQUAL (0xA1B23C4Du, get32 (f, 0));
+  CHECK_EQUAL (101u, get32 (f, 20)); // LINKTYPE_RAW
+
+  // first record
+  CHECK_EQUAL (1500000000u, get32 (f, 24));
+  CHECK_EQUAL (123456789u, get32 (f, 28));
+  CHECK_EQUAL (40 + sizeof (req), get32 (f, 32));
+  const uint8_t * ip = &f[40];
+  CHECK_EQUAL (0x45, ip[0]);
+  CHECK_EQUAL (6, ip[9]); // tcp
+  CHECK_EQUAL (502, (ip[22] << 8) | ip[23]); // to the server
+  CHECK (memcmp (ip + 40, req, sizeof (req)) == 0);
+
+  // IPv4 header checksum
+  uint32_t sum = 0;
+  for (int i = 0; i < 20; i += 2) {
+    sum += (ip[i] << 8) | ip[i + 1];
+  }
+  while (sum >> 16) {
+    sum = (sum & 0xFFFF) + (sum >> 16);
+  }
+  CHECK_EQUAL (0xFFFFu, sum);
+
+  // second record, from the server
+  ip = &f[24 + 16 + 40 + sizeof (req) + 16];
+  CHECK_EQUAL (502, (ip[20] << 8) | ip[21]);
+  CHECK (memcmp (ip + 40, exc, sizeof (exc)) == 0);
+  remove (PcapFile.c_str());
+}
+
+TEST (CapturePcapNgRtu) {
+  const uint8_t pdu[] = { 0x01, 0x03, 0x00, 0x00, 0x00, 0x0A };
+  const uint8_t adu[] = { 0x01, 0x03, 0x00, 0x00, 0x00, 0x0A, 0xC5, 0xCD };
+  Capture cap (PcapNgFile, Rtu, Capture::PcapNg);
+
+  CHECK (cap.recordPdu (pdu, sizeof (pdu), Capture::Sent, false));
+  CHECK (cap.record (adu, sizeof (adu), Capture::Received, false));
+  cap.close();
+
+  vector<uint8_t> f = load (PcapNgFile);
+  CHECK_EQUAL (28 + 32 + 2 * (44 + 8), f.size());
+  CHECK_EQUAL (0x0A0D0D0Au, get32 (f, 0));
+  CHECK_EQUAL (147u, get32 (f, 36) & 0xFFFF); // DLT_USER0
+
+  size_t epb = 60;
+  for (int i = 0; i < 2; i++) {
+    CHECK_EQUAL (6u, get32 (f, epb));
+    CHECK_EQUAL (52u, get32 (f, epb + 4));
+    CHECK_EQUAL (8u, get32 (f, epb + 20));
+    // the CRC is added to the PDU
+    CHECK (memcmp (&f[epb + 28], adu, sizeof (adu)) == 0);
+    // epb_flags: outbound then inbound
+    CHECK_EQUAL (i == 0 ? 2u : 1u, get32 (f, epb + 40));
+    CHECK_EQUAL (52u, get32 (f, epb + 48));
+    epb += 52;
+  }
+  remove (PcapNgFile.c_str());
+}
+
+TEST (CaptureFilters) {
+  uint8_t adu[] = { 0x01, 0x03, 0x00, 0x00, 0x00, 0x0A, 0x00, 0x00 };
+  Capture cap (PcapFile, Rtu);
+
+  cap.setSlaveFilter (2);
+  CHECK (!cap.record (adu, sizeof (adu), Capture::Received, false));
+  adu[0] = 2;
+  CHECK (cap.record (adu, sizeof (adu), Capture::Received, false));
+
+  cap.setFunctionFilter (false);
+  cap.setFunctionFilter (WriteSingleRegister, true);
+  CHECK (!cap.record (adu, sizeof (adu), Capture::Received, false));
+  adu[1] = 0x86; // exception of Write Single Register
+  CHECK (cap.record (adu, sizeof (adu), Capture::Received, false));
+
+  cap.setFunctionFilter (true);
+  cap.setSampling (4);
+  int n = 0;
+  for (int i = 0; i < 16; i++) {
+    n += cap.record (adu, sizeof (adu), Capture::Received, false);
+  }
+  CHECK_EQUAL (4, n);
+  CHECK_EQUAL (6u, cap.captured());
+  cap.close();
+  remove (PcapFile.c_str());
+}
+
+// run all tests
+int main (int argc, char **argv) {
+  return UnitTest::RunAllTests();
+}
+
+/* ========================================================================== */
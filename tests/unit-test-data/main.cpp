@@ -0,0 +1,708 @@
+// libmodbuspp Unit Test of data conversions
+// Use UnitTest++ framework -> https://github.com/unittest-cpp/unittest-cpp/wiki
+// This test code is in the public domain.
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#ifdef __linux__
+#include <cerrno>
+#include <poll.h>
+#endif
+#include <modbuspp.h>
+#include <UnitTest++/UnitTest++.h>
+
+using namespace std;
+using namespace Modbus;
+
+const Endian endians[] = {
+  EndianBigBig, EndianBigLittle, EndianLittleBig, EndianLittleLittle
+};
+
+// returns a value with distinct bytes
+template <typename T> T pattern (int i) {
+  T v;
+  uint8_t * p = reinterpret_cast<uint8_t *> (&v);
+
+  for (size_t j = 0; j < sizeof (T); j++) {
+
+    p[j] = static_cast<uint8_t> (0x11 * (j + 1) + i);
+  }
+  return v;
+}
+
+// compares the bulk conversion with the conversion of Data, value by value
+template <typename T> void checkBulk() {
+
+  for (Endian e : endians) {
+
+    for (int nb = 1; nb <= 37; nb++) {
+      const size_t w = sizeof (T) / 2;
+      vector<T> values (nb);
+      vector<uint16_t> expected (nb * w);
+      vector<uint16_t> regs (nb * w);
+
+      for (int i = 0; i < nb; i++) {
+        Data<T> d;
+
+        values[i] = pattern<T> (i);
+        d.setEndianness (e);
+        d = values[i];
+        memcpy (&expected[i * w], d.registers().data(), sizeof (T));
+      }
+
+      // values -> registers
+      swapRegisters (regs.data(), values.data(), nb, sizeof (T), e);
+      CHECK (regs == expected);
+
+      // registers -> values
+      swapRegisters (regs.data(), nb, sizeof (T), e);
+      CHECK (memcmp (regs.data(), values.data(), nb * sizeof (T)) == 0);
+    }
+  }
+}
+
+TEST (SwapRegisters) {
+
+  checkBulk<int16_t>();
+  checkBulk<uint16_t>();
+  checkBulk<int32_t>();
+  checkBulk<float>();
+  checkBulk<double>();
+  checkBulk<int64_t>();
+}
+
+TEST (DataArrays) {
+  const int nb = 19;
+  BufferedSlave slv (1);
+  Data<float, EndianBigLittle> src[nb];
+  Data<float, EndianBigLittle> dest[nb];
+  float values[nb];
+  uint16_t regs[nb * 2];
+
+  slv.setBlock (InputRegister, nb * 2);
+  for (int i = 0; i < nb; i++) {
+
+    src[i] = i * 1.5f;
+  }
+  src[3].setEndianness (EndianLittleLittle); // mixed orders
+
+  CHECK_EQUAL (nb * 2, slv.writeInputRegisters (1, src, nb));
+  CHECK_EQUAL (nb * 2, slv.readInputRegisters (1, regs, nb * 2));
+  for (int i = 0; i < nb; i++) {
+
+    CHECK (memcmp (&regs[i * 2], src[i].registers().data(), 4) == 0);
+    dest[i].setEndianness (src[i].endianness());
+  }
+
+  CHECK_EQUAL (nb * 2, slv.readInputRegisters (1, dest, nb));
+  for (int i = 0; i < nb; i++) {
+
+    CHECK_EQUAL (src[i].value(), dest[i].value());
+  }
+
+  // raw arrays of values
+  src[3].setEndianness (EndianBigLittle);
+  CHECK_EQUAL (nb * 2, slv.writeInputRegisters (1, src, nb));
+  CHECK_EQUAL (nb * 2, slv.readInputRegisters (1, values, nb, EndianBigLittle));
+  for (int i = 0; i < nb; i++) {
+
+    CHECK_EQUAL (src[i].value(), values[i]);
+  }
+  CHECK_EQUAL (nb * 2, slv.writeInputRegisters (1, values, nb, EndianLittleBig));
+  for (int i = 0; i < nb; i++) {
+
+    dest[i].setEndianness (EndianLittleBig);
+  }
+  CHECK_EQUAL (nb * 2, slv.readInputRegisters (1, dest, nb));
+  for (int i = 0; i < nb; i++) {
+
+    CHECK_EQUAL (values[i], dest[i].value());
+  }
+}
+
+// compares StaticData with Data
+template <typename T, Endian e> void checkStatic() {
+
+  for (int i = 0; i < 8; i++) {
+    Data<T, e> d (pattern<T> (i));
+    StaticData<T, e> s (pattern<T> (i));
+    uint16_t regs[sizeof (T) / 2];
+
+    CHECK (s.registers() == d.registers());
+    StaticData<T, e>::toRegisters (regs, d.value());
+    CHECK (memcmp (regs, d.registers().data(), sizeof (T)) == 0);
+    CHECK (memcmp (&s.value(), &d.value(), sizeof (T)) == 0);
+    s = 0;
+    s.setRegisters (regs);
+    CHECK (memcmp (&s.value(), &d.value(), sizeof (T)) == 0);
+  }
+}
+
+template <typename T> void checkStatic() {
+
+  checkStatic<T, EndianBigBig>();
+  checkStatic<T, EndianBigLittle>();
+  checkStatic<T, EndianLittleBig>();
+  checkStatic<T, EndianLittleLittle>();
+}
+
+TEST (StaticData) {
+
+  CHECK_EQUAL (sizeof (float), sizeof (StaticData<float>));
+  CHECK_EQUAL (sizeof (double) * 4, sizeof (StaticData<double, EndianLittle>[4]));
+
+  checkStatic<int16_t>();
+  checkStatic<uint16_t>();
+  checkStatic<int32_t>();
+  checkStatic<float>();
+  checkStatic<double>();
+  checkStatic<uint64_t>();
+}
+
+TEST (StaticDataArrays) {
+  const int nb = 21;
+  BufferedSlave slv (1);
+  StaticData<double, EndianLittleBig> src[nb];
+  StaticData<double, EndianLittleBig> dest[nb];
+  Data<double, EndianLittleBig> data[nb];
+
+  slv.setBlock (HoldingRegister, nb * 4);
+  for (int i = 0; i < nb; i++) {
+
+    src[i] = i / 3.0;
+  }
+
+  CHECK_EQUAL (nb * 4, slv.writeRegisters (1, src, nb));
+  CHECK_EQUAL (nb * 4, slv.readRegisters (1, data, nb));
+  CHECK_EQUAL (nb * 4, slv.readRegisters (1, dest, nb));
+  for (int i = 0; i < nb; i++) {
+
+    CHECK_EQUAL (src[i].value(), data[i].value());
+    CHECK_EQUAL (src[i].value(), dest[i].value());
+  }
+}
+
+TEST (RegisterView) {
+  const int nb = 13;
+  BufferedSlave slv (1);
+  Data<int32_t, EndianLittleBig> data[nb];
+  int32_t values[nb];
+
+  slv.setBlock (InputRegister, nb * 2 + 1);
+  RegisterView<int32_t, EndianLittleBig> v = slv.view<int32_t, EndianLittleBig> (InputRegister, 2, nb);
+  CHECK_EQUAL (nb, (int) v.size());
+  for (int i = 0; i < nb; i++) {
+
+    v[i] = -1000 * i;
+  }
+  CHECK_EQUAL (nb * 2, slv.readInputRegisters (2, data, nb));
+  for (int i = 0; i < nb; i++) {
+
+    CHECK_EQUAL (-1000 * i, data[i].value());
+    CHECK_EQUAL (-1000 * i, (int32_t) v.at (i));
+  }
+
+  v.read (values, 0, nb);
+  values[5] = 42;
+  v.write (0, values, nb);
+  CHECK_EQUAL (42, (int32_t) v[5]);
+  v.subview (10, 3).fill (7);
+  CHECK_EQUAL (7, (int32_t) v[12]);
+
+  CHECK_THROW (v.at (nb), std::out_of_range);
+  CHECK_THROW (v.subview (10, 4), std::out_of_range);
+  CHECK_THROW ( (slv.view<int32_t, EndianLittleBig> (InputRegister, 2, nb + 1)), std::out_of_range);
+  CHECK_THROW (slv.view<float> (Coil, 1, 1), std::out_of_range);
+}
+
+TEST (SparseBlocks) {
+  // exposes the map used to reply to a request
+  class SparseSlave : public BufferedSlave {
+    public:
+      SparseSlave () : BufferedSlave (1, 0) {}
+      using BufferedSlave::map;
+      using BufferedSlave::registers;
+  } slv;
+  uint16_t regs[200];
+  uint16_t check[200];
+
+  for (int i = 0; i < 200; i++) {
+
+    regs[i] = i * 3;
+  }
+  slv.setPduAddressing (true);
+  CHECK_EQUAL (100, slv.setBlock (HoldingRegister, 100, 0));
+  CHECK_EQUAL (100, slv.addBlock (HoldingRegister, 100, 10000));
+  CHECK_EQUAL (200, slv.addBlock (HoldingRegister, 200, 40000));
+  CHECK_EQUAL (3, slv.blockCount (HoldingRegister));
+  CHECK_EQUAL (0, slv.blockCount (Coil));
+
+  // overlaps
+  CHECK_EQUAL (-1, slv.addBlock (HoldingRegister, 10, 10095));
+  CHECK_EQUAL (-1, slv.addBlock (HoldingRegister, 10, 95));
+  CHECK_EQUAL (-1, slv.setBlock (HoldingRegister, 10001, 0));
+  CHECK_EQUAL (-1, slv.addBlock (HoldingRegister, 10, 0xFFFA));
+
+  CHECK_EQUAL (200, slv.writeRegisters (40000, regs, 200));
+  CHECK_EQUAL (100, slv.writeRegisters (10000, regs, 100));
+  CHECK_EQUAL (50, slv.readRegisters (40150, check, 100)); // end of the block
+  CHECK (memcmp (check, &regs[150], 50 * sizeof (uint16_t)) == 0);
+  CHECK_EQUAL (1, slv.readRegisters (10099, check, 1));
+  CHECK_EQUAL (regs[99], check[0]);
+
+  // holes
+  CHECK_EQUAL (-1, slv.readRegisters (100, check, 1));
+  CHECK_EQUAL (-1, slv.readRegisters (39999, check, 1));
+  CHECK_EQUAL (-1, slv.writeRegister (40200, 1));
+  CHECK_EQUAL (-1, slv.readInputRegisters (10000, check, 1));
+
+  // requests in a block are replied from this block, the others from the map
+  Request req (Tcp, ReadHoldingRegisters);
+  req.setStartingAdress (40010);
+  req.setQuantity (20);
+  modbus_mapping_t * mb = slv.map (req);
+  CHECK (mb != slv.map());
+  CHECK_EQUAL (40000, mb->start_registers);
+  CHECK_EQUAL (200, mb->nb_registers);
+  CHECK_EQUAL (regs[10], mb->tab_registers[10]);
+  req.setStartingAdress (40190);
+  CHECK (slv.map (req) == slv.map()); // spans the end of the block
+  req.setStartingAdress (10);
+  CHECK (slv.map (req) == slv.map());
+
+  // the views and the subscriptions use the blocks
+  auto v = slv.view<uint32_t> (HoldingRegister, 10000, 50);
+  v[0] = 0x12345678;
+  CHECK_EQUAL (0x1234, slv.registers (HoldingRegister, 10000, 2)[0]);
+
+  CHECK (slv.removeBlock (HoldingRegister, 10000));
+  CHECK (!slv.removeBlock (HoldingRegister, 10000));
+  CHECK_EQUAL (2, slv.blockCount (HoldingRegister));
+  CHECK_EQUAL (-1, slv.readRegisters (10000, check, 1));
+  CHECK_EQUAL (10, slv.readRegisters (40000, check, 10));
+  CHECK (memcmp (check, regs, 10 * sizeof (uint16_t)) == 0);
+}
+
+TEST (ConcurrentUpdate) {
+  const int nb = 100;
+  BufferedSlave slv (1);
+  std::atomic<bool> started (false);
+  std::atomic<bool> done (false);
+  int torn = 0;
+  int reads = 0;
+
+  slv.setBlock (InputRegister, nb);
+
+  // each group of writes sets all the registers to the same value
+  thread writer ([&] {
+    uint16_t regs[nb];
+
+    while (!started) {
+      this_thread::yield();
+    }
+    for (uint16_t v = 1; v <= 20000; v++) {
+
+      fill (regs, regs + nb, v);
+      slv.beginUpdate();
+      slv.writeInputRegisters (1, regs, nb / 2);
+      slv.beginUpdate(); // nested
+      slv.writeInputRegisters (1 + nb / 2, &regs[nb / 2], nb / 2);
+      slv.endUpdate();
+      slv.endUpdate();
+    }
+    done = true;
+  });
+
+  started = true;
+  while (!done) {
+    uint16_t regs[nb];
+
+    CHECK_EQUAL (nb, slv.readInputRegisters (1, regs, nb));
+    if (count (regs, regs + nb, regs[0]) != nb) {
+      torn++;
+    }
+    reads++;
+  }
+  writer.join();
+
+  CHECK (reads > 0);
+  CHECK_EQUAL (0, torn);
+}
+
+TEST (Changes) {
+  // simulates the writes of the clients as done by the server
+  class ChangedSlave : public BufferedSlave {
+    public:
+      ChangedSlave () : BufferedSlave (1, 0) {}
+      using BufferedSlave::writeToDevice;
+  } slv;
+  Request req (Tcp, WriteMultipleRegisters);
+
+  slv.setPduAddressing (true);
+  slv.setBlock (HoldingRegister, 100, 0);
+  slv.addBlock (HoldingRegister, 100, 40000);
+  slv.setBlock (Coil, 16, 0);
+  CHECK (!slv.hasChanges (HoldingRegister));
+  CHECK (!slv.waitForChanges (0));
+
+  req.setStartingAdress (10);
+  req.setQuantity (5);
+  slv.writeToDevice (req);
+  req.setStartingAdress (15);
+  req.setQuantity (2);
+  slv.writeToDevice (req);
+  req.setStartingAdress (40063);
+  req.setQuantity (3);
+  slv.writeToDevice (req);
+  req.setStartingAdress (95); // out of the block, exception
+  req.setQuantity (10);
+  slv.writeToDevice (req);
+  slv.writeRegister (50, 1); // not a client write
+
+  Request coil (Tcp, WriteSingleCoil);
+  coil.setStartingAdress (3);
+  slv.writeToDevice (coil);
+
+#ifdef __linux__
+  int fd = slv.changesDescriptor();
+  CHECK (fd >= 0);
+  pollfd pfd = { fd, POLLIN, 0 };
+  CHECK_EQUAL (1, poll (&pfd, 1, 0));
+#endif
+
+  CHECK (slv.hasChanges (HoldingRegister));
+  CHECK (slv.waitForChanges (0));
+  vector<BufferedSlave::Range> r = slv.changes (HoldingRegister);
+  CHECK_EQUAL (2u, r.size());
+  CHECK_EQUAL (10, r[0].address);
+  CHECK_EQUAL (7, r[0].size);
+  CHECK_EQUAL (40063, r[1].address);
+  CHECK_EQUAL (3, r[1].size);
+  CHECK (slv.changes (HoldingRegister).empty());
+
+  r = slv.changes (Coil);
+  CHECK_EQUAL (1u, r.size());
+  CHECK_EQUAL (3, r[0].address);
+  CHECK (!slv.waitForChanges (0));
+#ifdef __linux__
+  CHECK_EQUAL (0, poll (&pfd, 1, 0));
+#endif
+
+  // wakes up a waiting thread
+  thread client ([&] {
+    this_thread::sleep_for (chrono::milliseconds (10));
+    req.setStartingAdress (1);
+    slv.writeToDevice (req);
+  });
+  CHECK (slv.waitForChanges (5000));
+  client.join();
+  CHECK_EQUAL (1u, slv.changes (HoldingRegister).size());
+}
+
+TEST (PackBits) {
+  uint8_t bytes[40];
+  uint8_t bits[300];
+  uint8_t dest[300];
+
+  for (int i = 0; i < 300; i++) {
+
+    bits[i] = (i * 7 + i / 5) % 3 == 0 ? (i % 4) + 1 : 0;
+  }
+
+  for (size_t offset = 0; offset < 17; offset++) {
+
+    for (size_t n = 0; n <= 300 - offset; n += 13) {
+
+      memset (bytes, 0xA5, sizeof (bytes));
+      packBits (bytes, offset, bits, n);
+      for (size_t i = 0; i < 300; i++) {
+        bool bit = (bytes[i / 8] >> (i % 8)) & 1;
+
+        if (i >= offset && i < offset + n) {
+
+          CHECK_EQUAL (bits[i - offset] != 0, bit);
+        }
+        else {
+
+          CHECK_EQUAL ( ( (0xA5 >> (i % 8)) & 1) != 0, bit); // untouched
+        }
+      }
+
+      unpackBits (dest, bytes, offset, n);
+      for (size_t i = 0; i < n; i++) {
+
+        CHECK_EQUAL (bits[i] != 0, dest[i] == 1);
+      }
+    }
+  }
+}
+
+TEST (BitArray) {
+  const size_t n = 1000;
+  BitArray a (n);
+  bool values[n];
+  bool dest[n];
+  uint8_t bytes[n / 8 + 1];
+
+  for (size_t i = 0; i < n; i++) {
+
+    values[i] = (i % 3) == 0;
+  }
+  a.assign (0, values, n);
+  CHECK_EQUAL (334u, a.count());
+  CHECK (a[999] && !a[998]);
+
+  a.unpack (dest, 5, 700);
+  CHECK (memcmp (dest, values + 5, 700) == 0);
+
+  a.set (70, 200, true);
+  CHECK_EQUAL (200u, a.count (70, 200));
+  a.set (71, false);
+  CHECK (!a.test (71) && a.test (72));
+
+  a.toBytes (bytes, 3, 100);
+  BitArray b (n, true);
+  b.fromBytes (500, bytes, 100);
+  CHECK_EQUAL (a.count (3, 100), b.count (500, 100));
+  for (size_t i = 0; i < 100; i++) {
+
+    CHECK_EQUAL (a[3 + i], b[500 + i]);
+  }
+  CHECK (b[499] && b[600]);
+
+  b.resize (10);
+  b.resize (100, false);
+  CHECK_EQUAL (10u, b.count());
+  b.fill (false);
+  CHECK_EQUAL (0u, b.count());
+}
+
+TEST (MessageRegisters) {
+  const int nb = 31;
+  Request req (Rtu, ReadHoldingRegisters);
+  Response rsp (req);
+  uint16_t regs[nb * 4];
+  uint16_t check[nb * 4];
+  double values[nb];
+  Data<double, EndianBigLittle> data[nb];
+
+  for (int i = 0; i < nb * 4; i++) {
+
+    regs[i] = 0x1234 + i * 0x0101;
+  }
+  rsp.setByteCount (nb * 8);
+  rsp.setRegisterValues (0, nb * 4, regs);
+  CHECK_EQUAL (2u + nb * 8, rsp.size());
+  for (int i = 0; i < nb * 4; i++) {
+
+    CHECK_EQUAL (regs[i], rsp.registerValue (i));
+  }
+  rsp.registerValues (0, nb * 4, check);
+  CHECK (memcmp (regs, check, sizeof (regs)) == 0);
+
+  // typed values
+  for (int i = 0; i < nb; i++) {
+
+    values[i] = i * 1.25;
+  }
+  rsp.setRegisterValues (0, values, nb, EndianBigLittle);
+  rsp.registerValues (0, data, nb);
+  for (int i = 0; i < nb; i++) {
+
+    CHECK_EQUAL (values[i], data[i].value());
+    data[i] = -values[i];
+  }
+  rsp.setRegisterValues (0, data, nb);
+  rsp.registerValues (0, values, nb, EndianBigLittle);
+  CHECK_EQUAL (-1.25, values[1]);
+
+  CHECK_THROW (rsp.setRegisterValues (0, values, 32, EndianBig), std::out_of_range);
+
+  // conversion in an array not aligned on a register, as the PDU
+  uint8_t buf[sizeof (values) + 1];
+  swapNetworkRegisters (buf + 1, values, nb, sizeof (double), EndianBigLittle);
+  CHECK (memcmp (buf + 1, rsp.pdu() + 2, sizeof (values)) == 0);
+
+  // the plain registers out of the PDU are ignored
+  rsp.setRegisterValues (120, 10, regs);
+  CHECK_EQUAL (MaxPduLength - 1u, rsp.size());
+  CHECK_EQUAL (regs[4], rsp.registerValue (124));
+  memset (check, 0, sizeof (check));
+  rsp.registerValues (120, 10, check);
+  CHECK (memcmp (regs, check, 5 * sizeof (uint16_t)) == 0);
+  CHECK_EQUAL (0, check[5]);
+}
+
+TEST (MessageMove) {
+  Request req (Tcp, ReadInputRegisters);
+  const uint8_t * adu = req.adu();
+
+  req.setTransactionIdentifier (0x1234);
+  req.setStartingAdress (10);
+  req.setQuantity (2);
+
+  Request copy (req);
+  CHECK (copy.adu() != adu);
+  CHECK_EQUAL (10, copy.startingAddress());
+
+  Response rsp (std::move (req));
+  CHECK (!req.isValid());
+  CHECK (rsp.isValid());
+  CHECK (rsp.isResponse());
+  CHECK (rsp.adu() != adu); // in the private data of a response
+  CHECK_EQUAL (10, rsp.word (1));
+  CHECK_EQUAL (0x1234, rsp.transactionIdentifier());
+  CHECK_EQUAL (ReadInputRegisters, rsp.function());
+
+  req = copy;
+  CHECK (req.isValid());
+  CHECK_EQUAL (2, req.quantity());
+  copy = std::move (req);
+  CHECK (!req.isValid());
+  CHECK_EQUAL (2, copy.quantity());
+}
+
+TEST (ReadWriteRequest) {
+  const int nb = 4;
+  Request req (Tcp, ReadWriteMultipleRegisters);
+  uint16_t regs[nb] = { 0x0102, 0x0304, 0x0506, 0x0708 };
+  uint16_t check[nb];
+
+  req.setStartingAdress (100);
+  req.setQuantity (2);
+  req.setWriteAddress (200);
+  req.setWriteQuantity (nb);
+  req.setWriteRegisterValues (0, nb, regs);
+
+  CHECK_EQUAL (100, req.startingAddress());
+  CHECK_EQUAL (2, req.quantity());
+  CHECK_EQUAL (200, req.writeAddress());
+  CHECK_EQUAL (nb, req.writeQuantity());
+  CHECK_EQUAL (nb * 2, req.byte (9));
+  CHECK_EQUAL (10u + nb * 2, req.size());
+
+  req.writeRegisterValues (0, nb, check);
+  CHECK (memcmp (regs, check, sizeof (regs)) == 0);
+  CHECK_EQUAL (0x05, req.byte (14));
+}
+
+TEST (MaskWrite) {
+  BufferedSlave slv (1);
+  Request req (Tcp, MaskWriteRegister);
+  uint16_t value;
+
+  slv.setBlock (HoldingRegister, 10);
+  slv.setPduAddressing (true);
+  CHECK_EQUAL (1, slv.writeRegister (4, 0x0012));
+  // example of the Modbus specification
+  CHECK_EQUAL (1, slv.maskWriteRegister (4, 0x00F2, 0x0025));
+  CHECK_EQUAL (1, slv.readRegisters (4, &value));
+  CHECK_EQUAL (0x0017, value);
+  CHECK_EQUAL (-1, slv.maskWriteRegister (10, 0, 1));
+
+  req.setStartingAdress (4);
+  req.setAndMask (0x00F2);
+  req.setOrMask (0x0025);
+  CHECK_EQUAL (4, req.startingAddress());
+  CHECK_EQUAL (0x00F2, req.andMask());
+  CHECK_EQUAL (0x0025, req.orMask());
+  CHECK_EQUAL (7u, req.size());
+}
+
+TEST (Subscriptions) {
+  BufferedSlave slv (1);
+  vector<DataChange<float>> changes;
+  int calls = 0;
+  Data<float> v[2];
+
+  slv.setBlock (HoldingRegister, 10);
+  auto s = slv.subscribe<float> (HoldingRegister, 1, 2,
+  [&] (const vector<DataChange<float>> & c) {
+    changes = c;
+    calls++;
+  }, Deadband (Deadband::Absolute, 1.0));
+  REQUIRE CHECK (s);
+  CHECK_EQUAL (4, s->size());
+
+  // both values cross the deadband
+  v[0] = 10;
+  v[1] = 20;
+  CHECK_EQUAL (4, slv.writeRegisters (1, v, 2));
+  CHECK_EQUAL (1, calls);
+  REQUIRE CHECK_EQUAL (2u, changes.size());
+  CHECK_EQUAL (1, changes[0].address);
+  CHECK_EQUAL (0.0f, changes[0].previous);
+  CHECK_EQUAL (10.0f, changes[0].current);
+  CHECK_EQUAL (3, changes[1].address);
+  CHECK_EQUAL (20.0f, changes[1].current);
+
+  // changes in the deadband are suppressed
+  v[0] = 10.5f;
+  CHECK_EQUAL (4, slv.writeRegisters (1, v, 2));
+  CHECK_EQUAL (1, calls);
+  CHECK_EQUAL (0, slv.checkSubscriptions (HoldingRegister));
+
+  // compared with the last reported value, not with the last written one
+  v[0] = 11.25f;
+  v[1] = 20.5f;
+  CHECK_EQUAL (4, slv.writeRegisters (1, v, 2));
+  CHECK_EQUAL (2, calls);
+  REQUIRE CHECK_EQUAL (1u, changes.size());
+  CHECK_EQUAL (1, changes[0].address);
+  CHECK_EQUAL (10.0f, changes[0].previous);
+  CHECK_EQUAL (11.25f, changes[0].current);
+
+  // out of the range
+  uint16_t r = 1;
+  CHECK_EQUAL (1, slv.writeRegister (5, r));
+  CHECK_EQUAL (2, calls);
+
+  CHECK (slv.unsubscribe (s));
+  CHECK (!slv.unsubscribe (s));
+  v[0] = 100;
+  CHECK_EQUAL (4, slv.writeRegisters (1, v, 2));
+  CHECK_EQUAL (2, calls);
+
+  // percent of the last reported value
+  int pcalls = 0;
+  auto p = slv.subscribe<int16_t> (HoldingRegister, 6, 1,
+  [&] (const vector<DataChange<int16_t>> & c) {
+    pcalls++;
+  }, Deadband (Deadband::Percent, 10));
+  REQUIRE CHECK (p);
+  CHECK_EQUAL (1, slv.writeRegister (6, 100));
+  CHECK_EQUAL (1, pcalls);
+  CHECK_EQUAL (1, slv.writeRegister (6, 109));
+  CHECK_EQUAL (1, pcalls);
+  CHECK_EQUAL (1, slv.writeRegister (6, 111));
+  CHECK_EQUAL (2, pcalls);
+
+  // a bit is a register containing 0 or 1
+  vector<DataChange<uint16_t>> bchanges;
+  slv.setBlock (Coil, 8);
+  auto b = slv.subscribe<uint16_t> (Coil, 2, 3,
+  [&] (const vector<DataChange<uint16_t>> & c) {
+    bchanges = c;
+  });
+  REQUIRE CHECK (b);
+  CHECK_EQUAL (1, slv.writeCoil (3, true));
+  REQUIRE CHECK_EQUAL (1u, bchanges.size());
+  CHECK_EQUAL (3, bchanges[0].address);
+  CHECK_EQUAL (0, bchanges[0].previous);
+  CHECK_EQUAL (1, bchanges[0].current);
+
+  // no block of the table, out of the block
+  CHECK (!slv.subscribe<uint16_t> (DiscreteInput, 1, 1, nullptr));
+  CHECK (!slv.subscribe<float> (HoldingRegister, 9, 2, nullptr));
+  CHECK_EQUAL (EINVAL, errno);
+}
+
+// run all tests
+int main (int argc, char **argv) {
+  return UnitTest::RunAllTests();
+}
+
+/* ========================================================================== */
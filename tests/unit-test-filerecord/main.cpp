@@ -0,0 +1,114 @@
+// libmodbuspp Unit Test of the file record transfers
+// Use UnitTest++ framework -> https://github.com/unittest-cpp/unittest-cpp/wiki
+// This test code is in the public domain.
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <modbuspp.h>
+#include <UnitTest++/UnitTest++.h>
+
+using namespace std;
+using namespace Modbus;
+
+TEST (FileRecords) {
+  // exposes the reply to the requests not handled by libmodbus
+  class FileSlave : public BufferedSlave {
+    public:
+      FileSlave () : BufferedSlave (1, 0) {}
+      using BufferedSlave::reply;
+  } slv;
+  const char * path = "/tmp/unit-test-filerecord";
+  uint16_t regs[200];
+  uint16_t check[200];
+
+  for (int i = 0; i < 200; i++) {
+
+    regs[i] = 0x1000 + i;
+  }
+  unlink (path);
+  CHECK_EQUAL (1000, slv.addFile (1, 1000));
+  CHECK_EQUAL (-1, slv.addFile (1, 10));
+  CHECK_EQUAL (EEXIST, errno);
+  CHECK_EQUAL (-1, slv.addFile (0, 10));
+  CHECK_EQUAL (-1, slv.addFile (2, 10001));
+  CHECK_EQUAL (100, slv.addFile (2, 100, path));
+  CHECK_EQUAL (1000, slv.fileSize (1));
+  CHECK_EQUAL (-1, slv.fileSize (3));
+
+  CHECK_EQUAL (200, slv.writeFileRecord (1, 800, regs, 200));
+  CHECK_EQUAL (-1, slv.writeFileRecord (1, 801, regs, 200));
+  CHECK_EQUAL (200, slv.readFileRecord (1, 800, check, 200));
+  CHECK (memcmp (regs, check, sizeof (regs)) == 0);
+  CHECK_EQUAL (10, slv.writeFileRecord (2, 90, regs, 10));
+
+  // write of 2 sub-requests
+  Request wr (Tcp, WriteFileRecord);
+  wr.setByte (1, 2 * 7 + 6);
+  wr.setByte (2, 6);
+  wr.setWord (3, 1);
+  wr.setWord (5, 4);
+  wr.setWord (7, 2);
+  wr.setWord (9, 0x0A0B);
+  wr.setWord (11, 0x0C0D);
+  wr.setByte (13, 6);
+  wr.setWord (14, 2);
+  wr.setWord (16, 0);
+  wr.setWord (18, 1);
+  wr.setWord (20, 0x0E0F);
+  Response wrsp (wr);
+  CHECK_EQUAL (0, slv.reply (wr, wrsp));
+  CHECK_EQUAL (22u, wrsp.size());
+  CHECK (memcmp (wr.pdu(), wrsp.pdu(), 22) == 0);
+  CHECK_EQUAL (1, slv.readFileRecord (2, 0, check, 1));
+  CHECK_EQUAL (0x0E0F, check[0]);
+
+  // read of 2 sub-requests
+  Request rd (Tcp, ReadFileRecord);
+  rd.setByte (1, 14);
+  rd.setByte (2, 6);
+  rd.setWord (3, 1);
+  rd.setWord (5, 4);
+  rd.setWord (7, 2);
+  rd.setByte (9, 6);
+  rd.setWord (10, 2);
+  rd.setWord (12, 90);
+  rd.setWord (14, 1);
+  Response rrsp (rd);
+  CHECK_EQUAL (0, slv.reply (rd, rrsp));
+  CHECK_EQUAL (12u, rrsp.size());
+  CHECK_EQUAL (10, rrsp.byte (1));
+  CHECK_EQUAL (5, rrsp.byte (2));
+  CHECK_EQUAL (6, rrsp.byte (3));
+  CHECK_EQUAL (0x0A0B, rrsp.word (4));
+  CHECK_EQUAL (0x0C0D, rrsp.word (6));
+  CHECK_EQUAL (3, rrsp.byte (8));
+  CHECK_EQUAL (regs[0], rrsp.word (10));
+
+  // out of the file, bad reference type
+  rd.setWord (14, 11);
+  Response ersp (rd);
+  CHECK_EQUAL (IllegalDataAddress, slv.reply (rd, ersp));
+  CHECK_EQUAL (ReadFileRecord | ExceptionFlag, ersp.function());
+  CHECK_EQUAL (2u, ersp.size());
+  rd.setWord (14, 1);
+  rd.setByte (9, 5);
+  CHECK_EQUAL (IllegalDataAddress, slv.reply (rd, ersp));
+
+  // the mapped records are kept
+  CHECK (slv.removeFile (2));
+  CHECK (!slv.removeFile (2));
+  CHECK_EQUAL (100, slv.addFile (2, 100, path));
+  CHECK_EQUAL (10, slv.readFileRecord (2, 90, check, 10));
+  CHECK (memcmp (regs, check, 10 * sizeof (uint16_t)) == 0);
+  CHECK_EQUAL (1, slv.readFileRecord (2, 0, check, 1));
+  CHECK_EQUAL (0x0E0F, check[0]);
+  CHECK (slv.removeFile (2));
+  unlink (path);
+}
+
+// run all tests
+int main (int argc, char **argv) {
+  return UnitTest::RunAllTests();
+}
+
+/* ========================================================================== */
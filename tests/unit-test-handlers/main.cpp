@@ -0,0 +1,140 @@
+// libmodbuspp Unit Test of the function code handlers
+// Use UnitTest++ framework -> https://github.com/unittest-cpp/unittest-cpp/wiki
+// This test code is in the public domain.
+#include <cerrno>
+#include <stdexcept>
+#include <modbuspp.h>
+#include <UnitTest++/UnitTest++.h>
+
+using namespace std;
+using namespace Modbus;
+
+const Function Vendor = static_cast<Function> (0x41); // vendor specific
+
+// replies the byte of the request plus inc
+BufferedSlave::FunctionHandler increment (int inc) {
+
+  return [inc] (const Request & q, Response & r) {
+    r.setByte (1, q.byte (1) + inc);
+    r.setSize (2);
+    return 0;
+  };
+}
+
+// counts the requests received by the device of the slaves
+int requests = 0;
+int countRequest (Message * msg, Device * sender) {
+  requests++;
+  return 0;
+}
+
+TEST (FunctionHandlers) {
+  BufferedSlave slv (1);
+  Request req (Tcp, Vendor);
+  Response rsp (req);
+
+  CHECK (!slv.functionHandler (Vendor));
+  slv.setFunctionHandler (Vendor, increment (1));
+  CHECK (slv.functionHandler (Vendor));
+  CHECK (!slv.functionHandler (ReadHoldingRegisters));
+
+  req.setByte (1, 0x10);
+  rsp.setSize (1);
+  CHECK_EQUAL (0, slv.functionHandler (Vendor) (req, rsp));
+  CHECK_EQUAL (Vendor, rsp.function());
+  CHECK_EQUAL (0x11, rsp.byte (1));
+  CHECK_EQUAL (2u, rsp.size());
+
+  slv.setFunctionHandler (Vendor, nullptr);
+  CHECK (!slv.functionHandler (Vendor));
+}
+
+TEST (ServerDispatch) {
+  // the device of the slaves, counts the requests forwarded to it
+  Server dev (Tcp, "127.0.0.1", "1503");
+  dev.addSlave (1).setBlock (HoldingRegister, 10);
+  dev.addSlave (2).setBlock (HoldingRegister, 10);
+  dev.slave (1).setBeforeReplyCallback (countRequest);
+  dev.slave (2).setBeforeReplyCallback (countRequest);
+  REQUIRE CHECK (dev.open());
+  CHECK (dev.run());
+
+  Master gw (Tcp, "127.0.0.1", "1503");
+  REQUIRE CHECK (gw.open());
+
+  Server srv (Tcp, "127.0.0.1", "1502");
+  BufferedSlave & plc1 = srv.addSlave (1, &gw);
+  BufferedSlave & plc2 = srv.addSlave (2, &gw);
+
+  plc1.setBlock (HoldingRegister, 10);
+  plc2.setBlock (HoldingRegister, 10);
+  srv.setFunctionHandler (Vendor, increment (2));
+  srv.setFunctionHandler (0x42, [] (const Request & q, Response & r) {
+    return -1;
+  });
+  srv.setFunctionHandler (0x43, [] (const Request & q, Response & r) {
+    return 1;
+  });
+  plc1.setFunctionHandler (Vendor, increment (1));
+  plc1.setFunctionHandler (ReadHoldingRegisters, [] (const Request & q, Response & r) {
+    r.setByte (1, 2);
+    r.setWord (2, 0x5555);
+    r.setSize (4);
+    return 0;
+  });
+  REQUIRE CHECK (srv.open());
+  CHECK (srv.run());
+  CHECK_THROW (plc1.setFunctionHandler (Vendor, nullptr), logic_error);
+  CHECK_THROW (srv.setFunctionHandler (Vendor, nullptr), logic_error);
+
+  Master mb (Tcp, "127.0.0.1", "1502");
+  Request req (Tcp, Vendor);
+  Response rsp (mb);
+  uint16_t value;
+
+  REQUIRE CHECK (mb.open());
+
+  // the handler of the slave takes precedence over the one of the server
+  req.setSlaveId (1);
+  req.setByte (1, 0x10);
+  req.setSize (2);
+  CHECK (mb.sendRawRequest (req) > 0);
+  CHECK (mb.receiveResponse (rsp) > 0);
+  CHECK_EQUAL (Vendor, rsp.function());
+  CHECK_EQUAL (0x11, rsp.byte (1));
+  req.setSlaveId (2);
+  CHECK (mb.sendRawRequest (req) > 0);
+  CHECK (mb.receiveResponse (rsp) > 0);
+  CHECK_EQUAL (0x12, rsp.byte (1));
+
+  // the request replied by a handler is not forwarded to the device
+  CHECK_EQUAL (1, mb.addSlave (1).readRegisters (1, &value));
+  CHECK_EQUAL (0x5555, value);
+  CHECK_EQUAL (0, requests);
+  CHECK_EQUAL (1, mb.addSlave (2).readRegisters (1, &value));
+  CHECK (requests > 0);
+
+  // -1 replies a slave or server failure exception
+  req.setFunction (static_cast<Function> (0x42));
+  CHECK (mb.sendRawRequest (req) > 0);
+  CHECK (mb.receiveResponse (rsp) > 0);
+  CHECK_EQUAL (0x42 | ExceptionFlag, rsp.function());
+  CHECK_EQUAL (SlaveOrServerFailure, rsp.exceptionCode());
+
+  // 1 sends no response, the master times out
+  req.setFunction (static_cast<Function> (0x43));
+  CHECK (mb.sendRawRequest (req) > 0);
+  CHECK_EQUAL (-1, mb.receiveResponse (rsp));
+
+  mb.close();
+  srv.close();
+  gw.close();
+  dev.close();
+}
+
+// run all tests
+int main (int argc, char **argv) {
+  return UnitTest::RunAllTests();
+}
+
+/* ========================================================================== */
@@ -0,0 +1,126 @@
+// libmodbuspp Unit Test of the logger
+// Use UnitTest++ framework -> https://github.com/unittest-cpp/unittest-cpp/wiki
+// This test code is in the public domain.
+#include <sstream>
+#include <vector>
+#include <thread>
+#include <modbuspp.h>
+#include <UnitTest++/UnitTest++.h>
+
+using namespace std;
+using namespace Modbus;
+
+// keeps the records, called by the logger thread only
+class VectorSink : public Logger::Sink {
+  public:
+    virtual void write (const Logger::Record & r) {
+      records.push_back (r);
+    }
+    vector<Logger::Record> records;
+};
+
+TEST (HexEncode) {
+  const uint8_t bytes[] = { 0x00, 0x1F, 0xA5, 0xFF };
+  char buf[16];
+
+  CHECK_EQUAL (8u, hexEncode (buf, bytes, 4));
+  CHECK (string (buf, 8) == "001FA5FF");
+  CHECK (hexEncode (bytes, 2, '[', ']') == "[00][1F]");
+  CHECK (hexEncode (bytes, 0) == "");
+
+  // Message::print() uses the same encoding
+  const uint8_t adu[] = { 0x01, 0x03, 0x00, 0x6B, 0x00, 0x03 };
+  Message msg (Rtu, adu, sizeof (adu));
+  ostringstream oss;
+
+  oss << msg;
+  CHECK (oss.str() == "<01><03><00><6B><00><03>");
+}
+
+TEST (LoggerLevels) {
+  Logger log (Logger::Info);
+  auto sink = make_shared<VectorSink>();
+
+  log.setSink (sink);
+  CHECK (!log.isEnabled (Logger::Debug));
+  CHECK (log.isEnabled (Logger::Error));
+  CHECK (!log.log (Logger::Debug, "hidden"));
+  CHECK (log.log (Logger::Info, "info"));
+  CHECK (log.log (Logger::Error, string ("error")));
+  log.setLevel (Logger::Off);
+  CHECK (!log.log (Logger::Error, "off"));
+  log.flush();
+
+  CHECK_EQUAL (2u, sink->records.size());
+  CHECK (sink->records[0].text == "info");
+  CHECK_EQUAL (Logger::Info, sink->records[0].level);
+  CHECK_EQUAL (Logger::Error, sink->records[1].level);
+  CHECK (sink->records[0].timestamp <= sink->records[1].timestamp);
+}
+
+TEST (LoggerLazy) {
+  Logger log (Logger::Debug);
+  auto sink = make_shared<VectorSink>();
+  int calls = 0;
+  thread::id caller = this_thread::get_id();
+  thread::id formatter;
+
+  log.setSink (sink);
+  log.log (Logger::Trace, [&] { calls++; return string ("trace"); });
+  log.log (Logger::Debug, [&] {
+    calls++;
+    formatter = this_thread::get_id();
+    return string ("debug");
+  });
+
+  const uint8_t adu[] = { 0x00, 0x01, 0x00, 0x00, 0x00, 0x06, 0xFF, 0x03, 0x00, 0x6B, 0x00, 0x03 };
+  Message req (Tcp, adu, sizeof (adu));
+  log.log (Logger::Debug, req);
+  log.hex (Logger::Debug, adu + 6, 2);
+
+  // long text, not stored in the ring buffer
+  string text (1000, 'x');
+  log.log (Logger::Debug, text);
+  log.flush();
+
+  CHECK_EQUAL (1, calls);
+  CHECK (formatter != caller);
+  CHECK_EQUAL (4u, sink->records.size());
+  CHECK (sink->records[0].text == "debug");
+  CHECK (sink->records[1].text == "<00><01><00><00><00><06><FF><03><00><6B><00><03>");
+  CHECK (sink->records[2].text == "[FF][03]");
+  CHECK (sink->records[3].text == text);
+}
+
+TEST (LoggerStreamSink) {
+  ostringstream out, err;
+  Logger log (Logger::Debug);
+
+  log.setSink (make_shared<Logger::StreamSink> (out, err));
+  log.log (Logger::Debug, "frame");
+  log.log (Logger::Error, "Connection refused");
+  log.flush();
+  CHECK (out.str() == "frame\n");
+  CHECK (err.str() == "ERROR Connection refused\n");
+}
+
+TEST (LoggerOverflow) {
+  Logger log (Logger::Debug, 4);
+  auto sink = make_shared<VectorSink>();
+  int n = 0;
+
+  log.setSink (sink);
+  for (int i = 0; i < 1000; i++) {
+    n += log.log (Logger::Debug, "message");
+  }
+  log.flush();
+  CHECK_EQUAL (1000ul, n + log.dropped());
+  CHECK_EQUAL ( (size_t) n, sink->records.size());
+}
+
+// run all tests
+int main (int argc, char **argv) {
+  return UnitTest::RunAllTests();
+}
+
+/* ========================================================================== */
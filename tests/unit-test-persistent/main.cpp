@@ -0,0 +1,148 @@
+// libmodbuspp Unit Test of the persistent files
+// Use UnitTest++ framework -> https://github.com/unittest-cpp/unittest-cpp/wiki
+// This test code is in the public domain.
+#include <string>
+#include <cerrno>
+#include <cstdio>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+#include <modbuspp.h>
+#include <UnitTest++/UnitTest++.h>
+
+using namespace std;
+using namespace Modbus;
+
+const string path = "/tmp/modbuspp-unit-test-" + to_string (getpid()) + ".dat";
+
+// 8 coils and 8 registers, 24 bytes of data: the last byte of the file is
+// the last byte of the second snapshot
+void setBlocks (BufferedSlave & slv) {
+
+  slv.setPduAddressing (true);
+  slv.setBlock (Coil, 8, 0);
+  slv.setBlock (HoldingRegister, 4, 0);
+  slv.addBlock (HoldingRegister, 4, 1000);
+  slv.setBlock (InputRegister, 4, 0); // not saved
+}
+
+TEST (PersistentRestore) {
+  uint16_t regs[4] = { 1, 2, 3, 4 };
+  bool bit;
+
+  unlink (path.c_str());
+  {
+    BufferedSlave slv (1);
+
+    setBlocks (slv);
+    slv.writeRegisters (0, regs, 4);
+    CHECK_EQUAL (-1, slv.setPersistentFile (path + ".none/file"));
+    CHECK (!slv.isPersistent());
+
+    // created with the current values
+    CHECK_EQUAL (0, slv.setPersistentFile (path, 0, false));
+    CHECK (slv.isPersistent());
+    CHECK_EQUAL (-1, slv.setBlock (HoldingRegister, 8, 0));
+    CHECK_EQUAL (EBUSY, errno);
+    CHECK_EQUAL (-1, slv.addBlock (Coil, 8, 100));
+    CHECK_EQUAL (EBUSY, errno);
+    CHECK (!slv.removeBlock (HoldingRegister, 1000));
+
+    regs[0] = 100;
+    slv.writeRegisters (0, regs, 4);
+    slv.writeRegister (1003, 0xABCD);
+    slv.writeCoil (5, true);
+    slv.writeInputRegister (0, 7);
+    CHECK (slv.syncPersistentFile());
+    slv.closePersistentFile();
+    CHECK (!slv.isPersistent());
+    CHECK (!slv.syncPersistentFile());
+  }
+
+  {
+    // restored at once
+    BufferedSlave slv (1);
+
+    setBlocks (slv);
+    CHECK_EQUAL (1, slv.setPersistentFile (path));
+    CHECK_EQUAL (4, slv.readRegisters (0, regs, 4));
+    CHECK_EQUAL (100, regs[0]);
+    CHECK_EQUAL (4, regs[3]);
+    CHECK_EQUAL (1, slv.readRegisters (1003, regs));
+    CHECK_EQUAL (0xABCD, regs[0]);
+    CHECK_EQUAL (1, slv.readCoils (5, &bit));
+    CHECK (bit);
+    CHECK_EQUAL (1, slv.readInputRegisters (0, regs));
+    CHECK_EQUAL (0, regs[0]);
+  }
+
+  // the last snapshot is corrupted, the previous one is restored
+  FILE * f = fopen (path.c_str(), "r+b");
+  REQUIRE CHECK (f != nullptr);
+  fseek (f, -1, SEEK_END);
+  int c = fgetc (f);
+  fseek (f, -1, SEEK_END);
+  fputc (c ^ 0x55, f);
+  fclose (f);
+  {
+    BufferedSlave slv (1);
+
+    setBlocks (slv);
+    CHECK_EQUAL (1, slv.setPersistentFile (path));
+    CHECK_EQUAL (1, slv.readRegisters (0, regs));
+    CHECK_EQUAL (1, regs[0]);
+    CHECK_EQUAL (1, slv.readCoils (5, &bit));
+    CHECK (!bit);
+  }
+
+  {
+    // other blocks, the file is created again
+    BufferedSlave slv (1);
+
+    slv.setPduAddressing (true);
+    slv.setBlock (HoldingRegister, 5, 0);
+    CHECK_EQUAL (0, slv.setPersistentFile (path));
+    CHECK_EQUAL (1, slv.readRegisters (0, regs));
+    CHECK_EQUAL (0, regs[0]);
+  }
+  unlink (path.c_str());
+}
+
+TEST (PersistentFlushOnWrite) {
+  // simulates the writes of the clients as done by the server
+  class ChangedSlave : public BufferedSlave {
+    public:
+      ChangedSlave () : BufferedSlave (1, 0) {}
+      using BufferedSlave::writeToDevice;
+  } slv;
+  Request req (Tcp, WriteSingleRegister);
+  uint16_t value = 0;
+
+  unlink (path.c_str());
+  setBlocks (slv);
+  CHECK_EQUAL (0, slv.setPersistentFile (path, 0));
+
+  slv.writeRegister (2, 42);
+  req.setStartingAdress (2);
+  slv.writeToDevice (req);
+
+  // flushed by the background thread without closing the file
+  for (int i = 0; i < 100 && value != 42; i++) {
+    BufferedSlave other (1);
+
+    this_thread::sleep_for (chrono::milliseconds (10));
+    setBlocks (other);
+    CHECK_EQUAL (1, other.setPersistentFile (path, 0, false));
+    other.readRegisters (2, &value);
+    other.closePersistentFile();
+  }
+  CHECK_EQUAL (42, value);
+  slv.closePersistentFile();
+  unlink (path.c_str());
+}
+
+int main (int argc, char **argv) {
+
+  return UnitTest::RunAllTests();
+}
+/* ========================================================================== */
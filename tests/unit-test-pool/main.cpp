@@ -0,0 +1,67 @@
+// libmodbuspp Unit Test of the message pool
+// Use UnitTest++ framework -> https://github.com/unittest-cpp/unittest-cpp/wiki
+// This test code is in the public domain.
+#include <memory>
+#include <thread>
+#include <modbuspp.h>
+#include <UnitTest++/UnitTest++.h>
+
+using namespace std;
+using namespace Modbus;
+
+TEST (MessagePool) {
+  int quantity = 0;
+
+  // a message freed during the exit of the thread, after its pool
+  thread t ([&quantity] {
+    static thread_local unique_ptr<Request> late;
+    Request * req;
+
+    late.reset(); // constructed before the pool
+    delete new Request (Tcp, ReadCoils);
+    req = new Request (Tcp, ReadCoils);
+    req->setQuantity (8);
+    quantity = req->quantity();
+    late.reset (req);
+  });
+  t.join();
+  CHECK_EQUAL (8, quantity);
+
+  // the block of a deleted message is reused by the next one of the thread,
+  // the ADU is stored inline in the block
+  Request * a = new Request (Rtu, ReadCoils);
+  const uint8_t * block = a->adu();
+  delete a;
+  Request * b = new Request (Rtu, ReadCoils);
+  CHECK (b->isValid());
+  CHECK (b->adu() == block);
+  delete b;
+
+  // whatever the class of the message
+  Request c (Tcp, ReadHoldingRegisters);
+  CHECK (c.adu() == block);
+  b = new Request (Tcp, ReadHoldingRegisters);
+  block = b->adu();
+  delete b;
+  Response r (c);
+  CHECK (r.adu() == block);
+
+  // but not by another thread
+  const uint8_t * other = nullptr;
+  b = new Request (Tcp, ReadHoldingRegisters);
+  block = b->adu();
+  delete b;
+  thread u ([&other] {
+    Request d (Tcp, ReadHoldingRegisters);
+    other = d.adu();
+  });
+  u.join();
+  CHECK (other != block);
+}
+
+// run all tests
+int main (int argc, char **argv) {
+  return UnitTest::RunAllTests();
+}
+
+/* ========================================================================== */
@@ -0,0 +1,208 @@
+// libmodbuspp Unit Test of the recorder
+// Use UnitTest++ framework -> https://github.com/unittest-cpp/unittest-cpp/wiki
+// This test code is in the public domain.
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <cstdio>
+#include <unistd.h>
+#include <modbuspp.h>
+#include <UnitTest++/UnitTest++.h>
+
+using namespace std;
+using namespace Modbus;
+
+const string path = "/tmp/modbuspp-unit-test-" + to_string (getpid()) + ".mbr";
+const int nb = 8;
+// | length | type | channel | timestamp | registers |
+const int keyframeSize = 6 + 8 + nb * 2;
+
+// registers of the sample i
+void sample (uint16_t * regs, int i) {
+
+  for (int j = 0; j < nb; j++) {
+
+    regs[j] = (j == 3) ? i * 2 : 100 + j;
+  }
+  regs[7] = i / 4;
+}
+
+TEST (KeyframeDelta) {
+  Recorder rec (path, 64 * 1024);
+  uint16_t regs[nb];
+
+  rec.setKeyframeInterval (3);
+  for (int i = 0; i < 7; i++) {
+    int len;
+
+    sample (regs, i);
+    len = rec.record (1, InputRegister, 10, regs, nb, 1000 + i * 10);
+    if (i % 3 == 0) {
+
+      CHECK_EQUAL (keyframeSize, len);
+    }
+    else {
+
+      CHECK (len > 0 && len < keyframeSize);
+    }
+  }
+  CHECK_EQUAL (-1, rec.record (1, Coil, 10, regs, nb));
+  CHECK_EQUAL (EINVAL, errno);
+
+  RecorderReader rd (path);
+  REQUIRE CHECK_EQUAL (1u, rd.channels().size());
+  CHECK_EQUAL (0, rd.channel (1, InputRegister, 10, nb));
+  CHECK_EQUAL (-1, rd.channel (1, InputRegister, 10, nb + 1));
+
+  vector<Recorder::Sample> v = rd.read (0, 0, UINT64_MAX);
+  REQUIRE CHECK_EQUAL (7u, v.size());
+  for (int i = 0; i < 7; i++) {
+
+    sample (regs, i);
+    CHECK_EQUAL (0, v[i].channel);
+    CHECK_EQUAL (1000u + i * 10, v[i].timestamp);
+    CHECK (v[i].registers == vector<uint16_t> (regs, regs + nb));
+  }
+  rec.close();
+  unlink (path.c_str());
+}
+
+TEST (RingWrapAround) {
+  const size_t size = 1024;
+  const int n = 200;
+  Recorder rec (path, size);
+  uint16_t regs[nb];
+
+  rec.setKeyframeInterval (1);
+  for (int i = 0; i < n; i++) {
+
+    sample (regs, i);
+    CHECK_EQUAL (keyframeSize, rec.record (1, HoldingRegister, 0, regs, nb, 1000 + i));
+  }
+
+  // the oldest samples have been dropped, the last ones are in order
+  RecorderReader rd (path);
+  vector<Recorder::Sample> v = rd.read (-1, 0, UINT64_MAX);
+  REQUIRE CHECK_EQUAL (size / keyframeSize, v.size());
+  for (size_t i = 0; i < v.size(); i++) {
+    int k = n - v.size() + i;
+
+    sample (regs, k);
+    CHECK_EQUAL (1000u + k, v[i].timestamp);
+    CHECK (v[i].registers == vector<uint16_t> (regs, regs + nb));
+  }
+  CHECK_EQUAL (0u, rd.read (0, 0, 1000 + n - v.size() - 1).size());
+
+  // a record larger than the ring
+  vector<uint16_t> big (size / 2);
+  CHECK_EQUAL (-1, rec.record (1, HoldingRegister, 0, big.data(), big.size()));
+  CHECK_EQUAL (EMSGSIZE, errno);
+  rec.close();
+  unlink (path.c_str());
+}
+
+TEST (IndexLookup) {
+  Recorder rec (path, 64 * 1024);
+  uint16_t regs[nb];
+
+  rec.setKeyframeInterval (10);
+  for (int i = 0; i < 100; i++) {
+
+    sample (regs, i);
+    rec.record (1, InputRegister, 0, regs, nb, 1000 + i * 10);
+    // an other channel interleaved
+    rec.record (2, InputRegister, 0, regs, 2, 1000 + i * 10);
+  }
+
+  // from in the range, between two keyframes: the samples are decoded from
+  // the previous keyframe of the channel
+  RecorderReader rd (path);
+  vector<Recorder::Sample> v = rd.read (0, 1505, 1600);
+  REQUIRE CHECK_EQUAL (10u, v.size());
+  for (int i = 0; i < 10; i++) {
+
+    sample (regs, 51 + i);
+    CHECK_EQUAL (1510u + i * 10, v[i].timestamp);
+    CHECK (v[i].registers == vector<uint16_t> (regs, regs + nb));
+  }
+  CHECK_EQUAL (10u, rd.read (1, 1505, 1600).size());
+  CHECK_EQUAL (20u, rd.read (-1, 1505, 1600).size());
+
+  // the callback stops the reading
+  int n = 0;
+  CHECK_EQUAL (3, rd.read (0, 1000, 2000, [&n] (const Recorder::Sample & s) {
+    return ++n < 3;
+  }));
+  CHECK_EQUAL (-1, rd.read (2, 0, UINT64_MAX, nullptr));
+  CHECK_EQUAL (EINVAL, errno);
+  rec.close();
+  unlink (path.c_str());
+}
+
+TEST (ReadWhileWriting) {
+  Recorder rec (path, 4096);
+  RecorderReader rd (path);
+  uint16_t regs[nb];
+
+  CHECK (rd.isOpen());
+  CHECK_EQUAL (0u, rd.channels().size());
+  CHECK_EQUAL (0u, rd.read (-1, 0, UINT64_MAX).size());
+
+  rec.setKeyframeInterval (4);
+  for (int i = 0; i < 500; i++) {
+
+    sample (regs, i);
+    rec.record (1, InputRegister, 0, regs, nb, 1000 + i);
+
+    // the reader sees the samples written, the first ones are dropped
+    vector<Recorder::Sample> v = rd.read (0, 0, UINT64_MAX);
+    REQUIRE CHECK (v.size() > 0);
+    CHECK_EQUAL (1000u + i, v.back().timestamp);
+    CHECK (v.back().registers == vector<uint16_t> (regs, regs + nb));
+  }
+  CHECK (rd.read (0, 0, UINT64_MAX).front().timestamp > 1000);
+
+  // the recording continues after the last record
+  rec.close();
+  CHECK (rec.open (path, 4096));
+  sample (regs, 500);
+  CHECK_EQUAL (keyframeSize, rec.record (1, InputRegister, 0, regs, nb, 1500));
+  CHECK_EQUAL (1500u, rd.read (0, 0, UINT64_MAX).back().timestamp);
+  rec.close();
+  unlink (path.c_str());
+}
+
+TEST (RecordSlaveBlocks) {
+  Recorder rec (path, 64 * 1024);
+  BufferedSlave slv (3);
+  uint16_t regs[nb];
+
+  sample (regs, 5);
+  slv.setPduAddressing (true);
+  slv.setBlock (HoldingRegister, nb, 0);
+  slv.addBlock (HoldingRegister, 4, 40000);
+  slv.writeRegisters (0, regs, nb);
+  slv.writeRegisters (40000, regs, 4);
+
+  CHECK (rec.record (slv, HoldingRegister, 2000) > 0);
+  CHECK_EQUAL (-1, rec.record (slv, Coil));
+  CHECK_EQUAL (EINVAL, errno);
+
+  RecorderReader rd (path);
+  int ch = rd.channel (3, HoldingRegister, 40000, 4);
+  REQUIRE CHECK (ch >= 0);
+  CHECK (rd.channel (3, HoldingRegister, 0, nb) >= 0);
+
+  vector<Recorder::Sample> v = rd.read (ch, 0, UINT64_MAX);
+  REQUIRE CHECK_EQUAL (1u, v.size());
+  CHECK_EQUAL (2000u, v[0].timestamp);
+  CHECK (v[0].registers == vector<uint16_t> (regs, regs + 4));
+  CHECK_EQUAL (2u, rd.read (-1, 0, UINT64_MAX).size());
+  rec.close();
+  unlink (path.c_str());
+}
+
+// run all tests
+int main (int argc, char **argv) {
+  return UnitTest::RunAllTests();
+}
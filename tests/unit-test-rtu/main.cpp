@@ -0,0 +1,176 @@
+// libmodbuspp Unit Test of the RTU framing
+// Use UnitTest++ framework -> https://github.com/unittest-cpp/unittest-cpp/wiki
+// This test code is in the public domain.
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <modbuspp.h>
+#include <UnitTest++/UnitTest++.h>
+
+using namespace std;
+using namespace Modbus;
+
+// returns the frame with its crc
+vector<uint8_t> frame (vector<uint8_t> f) {
+  uint16_t crc = RtuLayer::crc16 (f.data(), f.size());
+
+  f.push_back (crc >> 8);
+  f.push_back (crc & 0xFF);
+  return f;
+}
+
+TEST (Crc16) {
+  // Read Holding Registers, slave 1, 10 registers from 0
+  const uint8_t adu[] = { 0x01, 0x03, 0x00, 0x00, 0x00, 0x0A, 0xC5, 0xCD };
+
+  CHECK_EQUAL (0xC5CD, RtuLayer::crc16 (adu, 6));
+  CHECK_EQUAL (0, RtuLayer::crc16 (adu, 8));
+  // incremental
+  uint16_t crc = RtuLayer::crc16 (adu, 2);
+  CHECK_EQUAL (0xC5CD, RtuLayer::crc16 (adu + 2, 4, crc));
+}
+
+// bitwise computation of the CRC, returned as RtuLayer::crc16()
+uint16_t referenceCrc16 (const uint8_t * buf, size_t count, uint16_t crc = 0xFFFF) {
+  uint16_t c = (crc >> 8) | (crc << 8);
+
+  while (count--) {
+
+    c ^= *buf++;
+    for (int j = 0; j < 8; j++) {
+
+      c = (c & 1) ? (c >> 1) ^ 0xA001 : (c >> 1);
+    }
+  }
+  return (c >> 8) | (c << 8);
+}
+
+TEST (Crc16Reference) {
+  mt19937 gen (42);
+  vector<uint8_t> buf (1024);
+
+  for (auto & b : buf) {
+
+    b = gen();
+  }
+  // all lengths and alignments around the 8 bytes blocks
+  for (size_t offset = 0; offset < 8; offset++) {
+
+    for (size_t len = 0; len <= 300; len++) {
+
+      CHECK_EQUAL (referenceCrc16 (&buf[offset], len),
+                   RtuLayer::crc16 (&buf[offset], len));
+    }
+  }
+  // incremental, split at any position
+  for (size_t split = 0; split <= 256; split++) {
+    uint16_t crc = RtuLayer::crc16 (buf.data(), split);
+
+    CHECK_EQUAL (referenceCrc16 (buf.data(), 256),
+                 RtuLayer::crc16 (&buf[split], 256 - split, crc));
+  }
+}
+
+TEST (Crc16Benchmark) {
+  const int loops = 20000;
+  vector<uint8_t> buf (MODBUS_RTU_MAX_ADU_LENGTH);
+  uint16_t crc = 0, ref = 0;
+
+  for (size_t i = 0; i < buf.size(); i++) {
+
+    buf[i] = i * 7;
+  }
+
+  auto t0 = chrono::steady_clock::now();
+  for (int i = 0; i < loops; i++) {
+
+    buf[0] = i;
+    crc ^= RtuLayer::crc16 (buf.data(), buf.size());
+  }
+  auto t1 = chrono::steady_clock::now();
+  for (int i = 0; i < loops; i++) {
+
+    buf[0] = i;
+    ref ^= referenceCrc16 (buf.data(), buf.size());
+  }
+  auto t2 = chrono::steady_clock::now();
+
+  CHECK_EQUAL (ref, crc);
+  double mb = double (loops) * buf.size() / 1e6;
+  cout << "crc16: " << mb / chrono::duration<double> (t1 - t0).count()
+       << " MB/s, bitwise: " << mb / chrono::duration<double> (t2 - t1).count()
+       << " MB/s" << endl;
+}
+
+TEST (FramerLengths) {
+  vector<vector<uint8_t>> frames = {
+    frame ({ 0x01, 0x03, 0x00, 0x10, 0x00, 0x02 }), // request
+    frame ({ 0x01, 0x03, 0x04, 0x00, 0x01, 0x00, 0x02 }), // response
+    frame ({ 0x11, 0x10, 0x00, 0x01, 0x00, 0x02, 0x04, 0x00, 0x0A, 0x01, 0x02 }),
+    frame ({ 0x11, 0x10, 0x00, 0x01, 0x00, 0x02 }),
+    frame ({ 0x0A, 0x83, 0x02 }), // exception
+    frame ({ 0x0A, 0x17, 0x00, 0x03, 0x00, 0x01, 0x00, 0x0E, 0x00, 0x01, 0x02, 0x12, 0x34 }),
+    frame ({ 0x0A, 0x16, 0x00, 0x04, 0x00, 0xF2, 0x00, 0x25 }),
+  };
+  vector<uint8_t> stream;
+  int received = 0;
+  RtuFramer framer (115200);
+
+  framer.setCallback ([&] (Message & msg) {
+    const vector<uint8_t> & f = frames[received++];
+
+    CHECK_EQUAL (f.size(), msg.aduSize());
+    CHECK (memcmp (f.data(), msg.adu(), f.size()) == 0);
+  });
+
+  for (auto & f : frames) {
+
+    stream.insert (stream.end(), f.begin(), f.end());
+  }
+
+  // back to back frames, pushed byte by byte without silence
+  for (size_t i = 0; i < stream.size(); i++) {
+
+    framer.push (&stream[i], 1, 1000 + i * framer.silenceTime() / 10);
+  }
+  CHECK_EQUAL ( (int) frames.size(), received);
+  CHECK_EQUAL (0u, framer.errors());
+  CHECK_EQUAL (0u, framer.pending());
+}
+
+TEST (FramerSilence) {
+  int received = 0;
+  RtuFramer framer (9600, RtuFramer::Requests);
+  uint64_t t = 1000000;
+  vector<uint8_t> unknown = frame ({ 0x01, 0x2B, 0x0E, 0x01, 0x00 }); // read device id
+  vector<uint8_t> bad = frame ({ 0x01, 0x06, 0x00, 0x01, 0x00, 0x03 });
+  vector<uint8_t> good = frame ({ 0x01, 0x06, 0x00, 0x01, 0x00, 0x04 });
+
+  CHECK_EQUAL (4011ul, framer.silenceTime());
+  framer.setCallback ([&] (Message & msg) {
+    received++;
+    CHECK (!msg.isResponse());
+  });
+
+  // unknown function: ended by the silence
+  CHECK_EQUAL (0, framer.push (unknown.data(), unknown.size(), t));
+  CHECK_EQUAL (0, framer.poll (t + 1000));
+  CHECK_EQUAL (1, framer.poll (t + 5000));
+
+  // invalid crc: the frame and the following bytes are dropped until the silence
+  bad[7] ^= 0xFF;
+  t += 100000;
+  CHECK_EQUAL (0, framer.push (bad.data(), bad.size(), t));
+  CHECK_EQUAL (0, framer.push (good.data(), good.size(), t + 2000));
+  CHECK_EQUAL (1u, framer.errors());
+  CHECK_EQUAL (1, framer.push (good.data(), good.size(), t + 20000));
+  CHECK_EQUAL (2, received);
+}
+
+// run all tests
+int main (int argc, char **argv) {
+  return UnitTest::RunAllTests();
+}
+
+/* ========================================================================== */
@@ -52,6 +52,143 @@ TEST (RtuMasterTest) {
   CHECK (!mb.isOpen());
 }
 
+// counts the requests received by the server
+int requests = 0;
+int countRequest (Message * msg, Device * sender) {
+  requests++;
+  return 0;
+}
+
+TEST (ReadCacheTest) {
+  Server srv (Tcp, "127.0.0.1", "1502");
+  BufferedSlave & plc = srv.addSlave (1);
+
+  plc.setPduAddressing (true);
+  plc.setBlock (HoldingRegister, 300, 0);
+  plc.writeRegister (250, 250);
+  plc.setBeforeReplyCallback (countRequest);
+  REQUIRE CHECK (srv.open());
+  CHECK (srv.run());
+
+  Master mb (Tcp, "127.0.0.1", "1502");
+  BufferedSlave slv (1, &mb);
+  uint16_t value;
+
+  slv.setPduAddressing (true);
+  slv.setBlock (HoldingRegister, 300, 0);
+  slv.setMaxAge (1000);
+  REQUIRE CHECK (mb.open ());
+
+  // the whole block is read, in 3 transactions
+  CHECK_EQUAL (1, slv.readRegisters (250, &value));
+  CHECK_EQUAL (250, value);
+  CHECK_EQUAL (3, requests);
+  plc.writeRegister (250, 251);
+  CHECK_EQUAL (1, slv.readRegisters (250, &value));
+  CHECK_EQUAL (250, value);
+  CHECK_EQUAL (3, requests);
+
+  slv.invalidate();
+  CHECK_EQUAL (1, slv.readRegisters (250, &value));
+  CHECK_EQUAL (251, value);
+  CHECK_EQUAL (6, requests);
+
+  mb.close();
+  srv.close();
+}
+
+TEST (PollTest) {
+  Server srv (Tcp, "127.0.0.1", "1502");
+  BufferedSlave & plc = srv.addSlave (1);
+  int changes = 0;
+
+  plc.setPduAddressing (true);
+  plc.setBlock (HoldingRegister, 10, 0);
+  plc.addBlock (HoldingRegister, 4, 100);
+  plc.writeRegister (2, 1234);
+  plc.writeRegister (101, 4321);
+  REQUIRE CHECK (srv.open());
+  CHECK (srv.run());
+
+  Master mb (Tcp, "127.0.0.1", "1502");
+  BufferedSlave slv (1, &mb);
+  uint16_t value;
+
+  slv.setPduAddressing (true);
+  slv.setBlock (HoldingRegister, 10, 0);
+  slv.addBlock (HoldingRegister, 4, 100);
+  auto s = slv.subscribe<uint16_t> (HoldingRegister, 2, 1,
+  [&changes] (const vector<DataChange<uint16_t>> & c) {
+    changes++;
+  });
+  REQUIRE CHECK (mb.open ());
+
+  // the blocks are read aside and copied under the seqlock
+  CHECK_EQUAL (14, slv.updateBlockFromSlave (HoldingRegister));
+  CHECK_EQUAL (1, slv.readRegisters (2, &value));
+  CHECK_EQUAL (1234, value);
+  CHECK_EQUAL (1, slv.readRegisters (101, &value));
+  CHECK_EQUAL (4321, value);
+  CHECK_EQUAL (1, changes);
+  CHECK_EQUAL (14, slv.updateBlockFromSlave (HoldingRegister));
+  CHECK_EQUAL (1, changes);
+
+  mb.close();
+  srv.close();
+}
+
+TEST (WriteTest) {
+  Server srv (Tcp, "127.0.0.1", "1502");
+  BufferedSlave & plc = srv.addSlave (1);
+
+  plc.setPduAddressing (true);
+  plc.setBlock (HoldingRegister, 10, 0);
+  plc.addBlock (HoldingRegister, 4, 100);
+  plc.setBlock (Coil, 16, 0);
+  REQUIRE CHECK (srv.open());
+  CHECK (srv.run());
+
+  Master mb (Tcp, "127.0.0.1", "1502");
+  Slave & slv = mb.addSlave (1);
+  uint16_t regs[4] = { 7, 8, 9, 10 };
+  bool bits[4] = { true, false, true, true };
+  uint16_t value;
+  bool bit;
+
+  slv.setPduAddressing (true);
+  REQUIRE CHECK (mb.open ());
+
+  // the map is written by the server, the response sent after
+  CHECK_EQUAL (1, slv.writeRegister (2, 0x1234));
+  CHECK_EQUAL (4, slv.writeRegisters (100, regs, 4));
+  CHECK_EQUAL (1, slv.maskWriteRegister (2, 0xFF00, 0x0056));
+  CHECK_EQUAL (1, slv.writeCoil (3, true));
+  CHECK_EQUAL (4, slv.writeCoils (8, bits, 4));
+  CHECK_EQUAL (1, plc.readRegisters (2, &value));
+  CHECK_EQUAL (0x1256, value);
+  CHECK_EQUAL (1, plc.readRegisters (103, &value));
+  CHECK_EQUAL (10, value);
+  CHECK_EQUAL (1, plc.readCoils (3, &bit));
+  CHECK (bit);
+  CHECK_EQUAL (1, plc.readCoils (10, &bit));
+  CHECK (bit);
+  CHECK (plc.hasChanges (HoldingRegister));
+
+  // the registers are read after the write
+  CHECK_EQUAL (3, slv.writeReadRegisters (1, regs, 1, 0, regs + 1, 3));
+  CHECK_EQUAL (7, regs[2]);
+  CHECK_EQUAL (0x1256, regs[3]);
+
+  // out of the blocks
+  CHECK_EQUAL (-1, slv.writeRegisters (102, regs, 4));
+  CHECK_EQUAL (EMBXILADD, errno);
+  CHECK_EQUAL (-1, slv.writeCoil (16, true));
+  CHECK_EQUAL (EMBXILADD, errno);
+
+  mb.close();
+  srv.close();
+}
+
 //
 // If you want to re-use a set of test data for more than one test, or provide 
 // setup/teardown for tests, you can use the TEST_FIXTURE macro instead. 
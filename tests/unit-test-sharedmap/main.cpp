@@ -0,0 +1,111 @@
+// libmodbuspp Unit Test of the shared memory maps
+// Use UnitTest++ framework -> https://github.com/unittest-cpp/unittest-cpp/wiki
+// This test code is in the public domain.
+#include <string>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <modbuspp.h>
+#include <UnitTest++/UnitTest++.h>
+
+using namespace std;
+using namespace Modbus;
+
+const string name = "modbuspp-unit-test-" + to_string (getpid());
+
+TEST (SharedMapAttach) {
+  BufferedSlave slv (1);
+  uint16_t regs[10];
+  bool bits[8];
+
+  slv.setPduAddressing (true);
+  slv.setBlock (HoldingRegister, 10, 100);
+  slv.setBlock (InputRegister, 4, 0);
+  slv.setBlock (Coil, 8, 0);
+  for (int i = 0; i < 10; i++) {
+
+    regs[i] = 1000 + i;
+  }
+  slv.writeRegisters (100, regs, 10);
+  slv.writeCoil (3, true);
+
+  CHECK (!SharedMap().open (name));
+  REQUIRE CHECK (slv.attachSharedMemory (name));
+  CHECK (slv.isSharedMemoryAttached());
+  CHECK_EQUAL (-1, slv.setBlock (HoldingRegister, 20, 100));
+  CHECK_EQUAL (EBUSY, errno);
+  CHECK_EQUAL (-1, slv.addBlock (HoldingRegister, 20, 1000));
+  CHECK_EQUAL (EBUSY, errno);
+
+  SharedMap shm (name, true);
+  CHECK (shm.isWritable());
+  CHECK_EQUAL (100, shm.startingAddress (HoldingRegister));
+  CHECK_EQUAL (10, shm.size (HoldingRegister));
+  CHECK_EQUAL (0, shm.size (DiscreteInput));
+
+  // values of the slave
+  CHECK_EQUAL (5, shm.readRegisters (HoldingRegister, 105, regs, 10));
+  CHECK_EQUAL (1005, regs[0]);
+  CHECK_EQUAL (8, shm.readBits (Coil, 0, bits, 8));
+  CHECK (bits[3] && !bits[2]);
+  CHECK_EQUAL (-1, shm.readRegisters (HoldingRegister, 99, regs, 1));
+  CHECK_EQUAL (-1, shm.readRegisters (Coil, 0, regs, 1));
+
+  // written by another process
+  pid_t pid = fork();
+  if (pid == 0) {
+    SharedMap child (name, true);
+    uint16_t values[] = { 0x1234, 0x5678 };
+
+    child.beginUpdate();
+    child.writeRegisters (InputRegister, 2, values, 2);
+    child.writeBits (Coil, 7, bits + 3);
+    child.endUpdate();
+    _exit (0);
+  }
+  int status;
+  waitpid (pid, &status, 0);
+  CHECK (WIFEXITED (status) && WEXITSTATUS (status) == 0);
+  CHECK_EQUAL (2, slv.readInputRegisters (2, regs, 2));
+  CHECK_EQUAL (0x1234, regs[0]);
+  CHECK_EQUAL (0x5678, regs[1]);
+  CHECK_EQUAL (1, slv.readCoils (7, bits));
+  CHECK (bits[0]);
+
+  // written by the slave
+  slv.writeRegister (109, 42);
+  CHECK_EQUAL (1, shm.readRegisters (HoldingRegister, 109, regs));
+  CHECK_EQUAL (42, regs[0]);
+
+  // read-only access
+  SharedMap ro (name);
+  CHECK_EQUAL (-1, ro.writeRegisters (HoldingRegister, 100, regs));
+  CHECK_EQUAL (EBADF, errno);
+
+  // an instance with the same blocks reuses the values
+  BufferedSlave other (2);
+  other.setPduAddressing (true);
+  other.setBlock (HoldingRegister, 10, 100);
+  other.setBlock (InputRegister, 4, 0);
+  other.setBlock (Coil, 8, 0);
+  CHECK (other.attachSharedMemory (name));
+  CHECK_EQUAL (1, other.readRegisters (109, regs));
+  CHECK_EQUAL (42, regs[0]);
+  other.detachSharedMemory();
+
+  slv.detachSharedMemory();
+  CHECK (!slv.isSharedMemoryAttached());
+  CHECK_EQUAL (1, slv.readRegisters (109, regs));
+  CHECK_EQUAL (42, regs[0]);
+  CHECK_EQUAL (20, slv.setBlock (HoldingRegister, 20, 100));
+
+  CHECK (SharedMap::remove (name));
+  CHECK (!SharedMap::remove (name));
+}
+
+// run all tests
+int main (int argc, char **argv) {
+  return UnitTest::RunAllTests();
+}
+
+/* ========================================================================== */
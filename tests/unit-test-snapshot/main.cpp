@@ -0,0 +1,223 @@
+// libmodbuspp Unit Test of the server snapshots
+// Use UnitTest++ framework -> https://github.com/unittest-cpp/unittest-cpp/wiki
+// This test code is in the public domain.
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <modbuspp.h>
+#include <UnitTest++/UnitTest++.h>
+
+using namespace std;
+using namespace Modbus;
+
+void setSlaves (Server & srv) {
+  BufferedSlave & s1 = srv.addSlave (1);
+  BufferedSlave & s2 = srv.addSlave (2);
+
+  s1.setPduAddressing (true);
+  s1.setBlock (HoldingRegister, 1000, 0);
+  s1.addBlock (HoldingRegister, 100, 40000);
+  s1.setBlock (InputRegister, 10, 0);
+  s1.setBlock (Coil, 64, 0);
+  s2.setPduAddressing (true);
+  s2.setBlock (DiscreteInput, 16, 100);
+  s2.setBlock (HoldingRegister, 10, 0);
+}
+
+TEST (SnapshotRestore) {
+  Server srv (Tcp, "127.0.0.1", "1502");
+  Server other (Tcp, "127.0.0.1", "1503");
+  uint16_t regs[1000];
+  bool bit;
+
+  setSlaves (srv);
+  setSlaves (other);
+  for (int i = 0; i < 1000; i++) {
+
+    regs[i] = i;
+  }
+  srv[1].writeRegisters (0, regs, 1000);
+  srv[1].writeRegister (40099, 0xBEEF);
+  srv[1].writeInputRegister (9, 9);
+  srv[1].writeCoil (63, true);
+  srv[2].writeDiscreteInput (115, true);
+  srv[2].writeRegister (0, 0x1234);
+
+  vector<uint8_t> full = srv.snapshot();
+  // bits packed, registers on 2 bytes, small headers
+  CHECK (full.size() < (1000 + 100 + 10 + 10) * 2 + (64 + 16) / 8 + 100);
+
+  CHECK_EQUAL (1000 + 100 + 10 + 64 + 16 + 10, other.restore (full));
+  CHECK_EQUAL (1000, other[1].readRegisters (0, regs, 1000));
+  CHECK_EQUAL (999, regs[999]);
+  CHECK_EQUAL (1, other[1].readRegisters (40099, regs));
+  CHECK_EQUAL (0xBEEF, regs[0]);
+  CHECK_EQUAL (1, other[1].readInputRegisters (9, regs));
+  CHECK_EQUAL (9, regs[0]);
+  CHECK_EQUAL (1, other[1].readCoils (63, &bit));
+  CHECK (bit);
+  CHECK_EQUAL (1, other[2].readDiscreteInputs (115, &bit));
+  CHECK (bit);
+  CHECK_EQUAL (1, other[2].readRegisters (0, regs));
+  CHECK_EQUAL (0x1234, regs[0]);
+  CHECK (srv.snapshot() == other.snapshot());
+
+  // delta
+  CHECK (srv.snapshot (full).size() < 32);
+  srv[1].writeRegister (500, 0);
+  srv[1].writeRegister (502, 0);
+  srv[1].writeCoil (0, true);
+  srv[2].writeDiscreteInput (115, false);
+  vector<uint8_t> delta = srv.snapshot (full);
+  CHECK (delta.size() < 64);
+  CHECK_EQUAL (3 + 1 + 1, other.restore (delta));
+  CHECK (srv.snapshot() == other.snapshot());
+
+  // a delta is not a base
+  CHECK_EQUAL (srv.snapshot().size(), srv.snapshot (delta).size());
+
+  // slaves or blocks missing
+  Server partial (Tcp, "127.0.0.1", "1504");
+  partial.addSlave (2).setPduAddressing (true);
+  partial[2].setBlock (HoldingRegister, 5, 0);
+  CHECK_EQUAL (0, partial.restore (full));
+  partial[2].setBlock (HoldingRegister, 20, 0);
+  CHECK_EQUAL (10, partial.restore (full));
+
+  // corrupted
+  full[full.size() / 2] ^= 1;
+  CHECK_EQUAL (-1, other.restore (full));
+  CHECK_EQUAL (EPROTO, errno);
+  CHECK_EQUAL (-1, other.restore (vector<uint8_t> (8, 0)));
+}
+
+TEST (SnapshotConsistency) {
+  Server srv (Tcp, "127.0.0.1", "1502");
+  Server other (Tcp, "127.0.0.1", "1503");
+  atomic<bool> stop (false);
+  uint16_t v1, v2;
+
+  setSlaves (srv);
+  setSlaves (other);
+
+  // the two slaves are always written together
+  thread writer ([&] {
+    for (uint16_t v = 1; !stop; v++) {
+
+      srv[1].beginUpdate();
+      srv[2].beginUpdate();
+      srv[1].writeRegister (0, v);
+      srv[2].writeRegister (0, v);
+      srv[2].endUpdate();
+      srv[1].endUpdate();
+    }
+  });
+  for (int i = 0; i < 2000; i++) {
+
+    REQUIRE CHECK (other.restore (srv.snapshot()) > 0);
+    other[1].readRegisters (0, &v1);
+    other[2].readRegisters (0, &v2);
+    CHECK_EQUAL (v1, v2);
+  }
+  stop = true;
+  writer.join();
+
+  // taken in a write of the same thread
+  srv[1].beginUpdate();
+  srv[1].writeRegister (0, 7);
+  CHECK (other.restore (srv.snapshot()) > 0);
+  srv[1].endUpdate();
+  other[1].readRegisters (0, &v1);
+  CHECK_EQUAL (7, v1);
+}
+
+// waits for the condition c for 1 s at most
+template <typename C>
+bool waitFor (C c) {
+
+  for (int i = 0; i < 10000 && !c(); i++) {
+    this_thread::sleep_for (chrono::microseconds (100));
+  }
+  return c();
+}
+
+TEST (Replication) {
+  Server primary (Tcp, "127.0.0.1", "1502");
+  Server standby (Tcp, "127.0.0.1", "1503");
+  const string path = "/tmp/modbuspp-unit-test-" + to_string (getpid()) + ".sock";
+  uint16_t value = 0;
+  bool bit = false;
+
+  setSlaves (primary);
+  setSlaves (standby);
+  primary[1].writeRegister (10, 10);
+
+  CHECK (!standby.replicateFrom (path));
+  REQUIRE CHECK (primary.startReplication (path, 100));
+  REQUIRE CHECK (standby.replicateFrom (path));
+  CHECK (primary.isReplicating());
+  CHECK (standby.isReplicating());
+
+  // full snapshot at the connection
+  CHECK (waitFor ([&] {
+    standby[1].readRegisters (10, &value);
+    return value == 10;
+  }));
+
+  // a standby which does not read does not delay the others
+  struct sockaddr_un addr;
+  int late = socket (AF_UNIX, SOCK_STREAM, 0);
+  memset (&addr, 0, sizeof (addr));
+  addr.sun_family = AF_UNIX;
+  strcpy (addr.sun_path, path.c_str());
+  REQUIRE CHECK_EQUAL (0, connect (late, reinterpret_cast<struct sockaddr *> (&addr), sizeof (addr)));
+
+  // application updates
+  primary[1].writeRegister (40050, 42);
+  primary[2].writeDiscreteInput (100, true);
+  CHECK (waitFor ([&] {
+    standby[1].readRegisters (40050, &value);
+    standby[2].readDiscreteInputs (100, &bit);
+    return value == 42 && bit;
+  }));
+  CHECK (standby.replicationSequence() >= 1);
+  CHECK (waitFor ([&] {
+    return standby.replicationSequence() == primary.replicationSequence();
+  }));
+  CHECK (primary.snapshot() == standby.snapshot());
+
+  // nothing is sent while the slaves are not written
+  uint64_t seq = primary.replicationSequence();
+  this_thread::sleep_for (chrono::milliseconds (20));
+  CHECK_EQUAL (seq, primary.replicationSequence());
+  for (uint16_t i = 1; i <= 100; i++) {
+
+    primary[1].writeRegister (0, i);
+    CHECK (waitFor ([&] {
+      standby[1].readRegisters (0, &value);
+      return value == i;
+    }));
+  }
+  close (late);
+
+  // failover
+  primary.stopReplication();
+  CHECK (!primary.isReplicating());
+  CHECK (waitFor ([&] {
+    return !standby.isReplicating();
+  }));
+  unlink (path.c_str());
+}
+
+int main (int argc, char **argv) {
+
+  return UnitTest::RunAllTests();
+}
+/* ========================================================================== */